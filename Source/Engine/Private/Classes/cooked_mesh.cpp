@@ -0,0 +1,228 @@
+﻿#include "Classes/cooked_mesh.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "Classes/mesh.h"
+
+namespace FireEngine
+{
+	namespace
+	{
+		uint64_t AlignOffset(uint64_t offset)
+		{
+			return (offset + c_cooked_mesh_alignment - 1) & ~(c_cooked_mesh_alignment - 1);
+		}
+
+		SMeshBounds CalculateBounds(const SVertexInstance* vertices, uint64_t vertex_count)
+		{
+			SMeshBounds bounds{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+			for (uint64_t i = 0; i < vertex_count; ++i)
+			{
+				for (uint32_t axis = 0; axis < 3; ++axis)
+				{
+					const float value = vertices[i].position[axis];
+					if (i == 0 || value < bounds.min[axis])
+					{
+						bounds.min[axis] = value;
+					}
+					if (i == 0 || value > bounds.max[axis])
+					{
+						bounds.max[axis] = value;
+					}
+				}
+			}
+			return bounds;
+		}
+
+		void WritePadding(std::ofstream& file, uint64_t target_offset)
+		{
+			static const char zeros[c_cooked_mesh_alignment] = {};
+			const uint64_t current = static_cast<uint64_t>(file.tellp());
+			file.write(zeros, static_cast<std::streamsize>(target_offset - current));
+		}
+	}
+
+	bool WriteCookedMesh(const std::string& file_name, const SMeshView& mesh)
+	{
+		SCookedMeshHeader header{};
+		header.magic = c_cooked_mesh_magic;
+		header.version = c_cooked_mesh_version;
+		header.vertex_stride = sizeof(SVertexInstance);
+		header.index_stride = sizeof(IndexType);
+		header.geometry_count = mesh.geometry_count;
+		header.vertex_count = mesh.vertex_count;
+		header.index_count = mesh.index_count;
+		header.bounds = CalculateBounds(mesh.vertices, mesh.vertex_count);
+
+		std::vector<SMeshBounds> geometry_bounds;
+		geometry_bounds.reserve(mesh.geometry_count);
+		for (uint64_t i = 0; i < mesh.geometry_count; ++i)
+		{
+			const SGeometryDesc& geometry = mesh.geometries[i];
+			geometry_bounds.emplace_back(CalculateBounds(mesh.vertices + geometry.vertex_offset, geometry.vertex_count));
+		}
+
+		header.geometry_offset = AlignOffset(sizeof(SCookedMeshHeader));
+		header.geometry_bounds_offset = AlignOffset(header.geometry_offset + mesh.geometry_count * sizeof(SGeometryDesc));
+		header.vertex_offset = AlignOffset(header.geometry_bounds_offset + mesh.geometry_count * sizeof(SMeshBounds));
+		header.index_offset = AlignOffset(header.vertex_offset + mesh.vertex_count * sizeof(SVertexInstance));
+
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(file_name).parent_path(), error);
+
+		// 先写临时文件再改名, 避免运行时映射到写了一半的文件
+		const std::string temp_file_name = MakeTempFileName(file_name);
+		{
+			std::ofstream file(temp_file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				return false;
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			WritePadding(file, header.geometry_offset);
+			file.write(reinterpret_cast<const char*>(mesh.geometries), mesh.geometry_count * sizeof(SGeometryDesc));
+			WritePadding(file, header.geometry_bounds_offset);
+			file.write(reinterpret_cast<const char*>(geometry_bounds.data()), geometry_bounds.size() * sizeof(SMeshBounds));
+			WritePadding(file, header.vertex_offset);
+			file.write(reinterpret_cast<const char*>(mesh.vertices), mesh.vertex_count * sizeof(SVertexInstance));
+			WritePadding(file, header.index_offset);
+			file.write(reinterpret_cast<const char*>(mesh.indices), mesh.index_count * sizeof(IndexType));
+			if (!file)
+			{
+				file.close();
+				std::filesystem::remove(temp_file_name, error);
+				return false;
+			}
+		}
+		std::filesystem::rename(temp_file_name, file_name, error);
+		if (error)
+		{
+			std::filesystem::remove(temp_file_name, error);
+			return false;
+		}
+		return true;
+	}
+
+	bool WriteCookedMesh(const std::string& file_name, const std::vector<CMesh*>& meshes)
+	{
+		uint64_t total_vertex_count = 0;
+		uint64_t total_index_count = 0;
+		std::vector<SGeometryDesc> geometries;
+		geometries.reserve(meshes.size());
+		for (const CMesh* mesh : meshes)
+		{
+			auto& geometry = geometries.emplace_back();
+			geometry.vertex_offset = static_cast<uint32_t>(total_vertex_count);
+			geometry.index_offset = static_cast<uint32_t>(total_index_count);
+			geometry.vertex_count = static_cast<uint32_t>(mesh->m_vretices.size());
+			geometry.index_count = static_cast<uint32_t>(mesh->m_indices.size());
+			geometry.material_index = mesh->material;
+			total_vertex_count += mesh->m_vretices.size();
+			total_index_count += mesh->m_indices.size();
+		}
+
+		std::vector<SVertexInstance> vertices;
+		std::vector<IndexType> indices;
+		vertices.reserve(total_vertex_count);
+		indices.reserve(total_index_count);
+		for (const CMesh* mesh : meshes)
+		{
+			vertices.insert(vertices.end(), mesh->m_vretices.begin(), mesh->m_vretices.end());
+			indices.insert(indices.end(), mesh->m_indices.begin(), mesh->m_indices.end());
+		}
+
+		SMeshView view;
+		view.vertices = vertices.data();
+		view.vertex_count = vertices.size();
+		view.indices = indices.data();
+		view.index_count = indices.size();
+		view.geometries = geometries.data();
+		view.geometry_count = geometries.size();
+		return WriteCookedMesh(file_name, view);
+	}
+
+	bool CCookedMesh::Load(const std::string& file_name)
+	{
+		SFileData file;
+		return file.Open(file_name) && Load(std::move(file));
+	}
+
+	bool CCookedMesh::Load(SFileData&& file)
+	{
+		m_header = nullptr;
+		m_file = std::move(file);
+
+		const uint64_t file_size = m_file.view.size;
+		if (file_size < sizeof(SCookedMeshHeader))
+		{
+			m_file = {};
+			return false;
+		}
+
+		const auto* header = reinterpret_cast<const SCookedMeshHeader*>(m_file.view.data);
+		auto in_file = [file_size](uint64_t offset, uint64_t count, uint64_t stride) {
+			return offset % c_cooked_mesh_alignment == 0 && offset <= file_size && count <= (file_size - offset) / stride;
+		};
+		const bool valid = header->magic == c_cooked_mesh_magic
+			&& header->version == c_cooked_mesh_version
+			&& header->vertex_stride == sizeof(SVertexInstance)
+			&& header->index_stride == sizeof(IndexType)
+			&& in_file(header->geometry_offset, header->geometry_count, sizeof(SGeometryDesc))
+			&& in_file(header->geometry_bounds_offset, header->geometry_count, sizeof(SMeshBounds))
+			&& in_file(header->vertex_offset, header->vertex_count, sizeof(SVertexInstance))
+			&& in_file(header->index_offset, header->index_count, sizeof(IndexType));
+		if (!valid)
+		{
+			m_file = {};
+			return false;
+		}
+
+		// 子网格的范围和索引都要落在缓冲区内, 否则上传和构建加速结构时会越界
+		const uint8_t* base = m_file.view.data;
+		const auto*    geometries = reinterpret_cast<const SGeometryDesc*>(base + header->geometry_offset);
+		const auto*    indices = reinterpret_cast<const IndexType*>(base + header->index_offset);
+		for (uint64_t i = 0; i < header->geometry_count; ++i)
+		{
+			const SGeometryDesc& geometry = geometries[i];
+			if (static_cast<uint64_t>(geometry.vertex_offset) + geometry.vertex_count > header->vertex_count
+				|| static_cast<uint64_t>(geometry.index_offset) + geometry.index_count > header->index_count)
+			{
+				m_file = {};
+				return false;
+			}
+			for (uint32_t j = 0; j < geometry.index_count; ++j)
+			{
+				if (indices[geometry.index_offset + j] >= geometry.vertex_count)
+				{
+					m_file = {};
+					return false;
+				}
+			}
+		}
+		m_header = header;
+		return true;
+	}
+
+	SMeshView CCookedMesh::GetView() const
+	{
+		SMeshView view;
+		if (!m_header)
+		{
+			return view;
+		}
+		const uint8_t* base = m_file.view.data;
+		view.vertices = reinterpret_cast<const SVertexInstance*>(base + m_header->vertex_offset);
+		view.vertex_count = m_header->vertex_count;
+		view.indices = reinterpret_cast<const IndexType*>(base + m_header->index_offset);
+		view.index_count = m_header->index_count;
+		view.geometries = reinterpret_cast<const SGeometryDesc*>(base + m_header->geometry_offset);
+		view.geometry_count = m_header->geometry_count;
+		return view;
+	}
+
+	const SMeshBounds* CCookedMesh::GetGeometryBounds() const
+	{
+		return m_header ? reinterpret_cast<const SMeshBounds*>(m_file.view.data + m_header->geometry_bounds_offset) : nullptr;
+	}
+}
@@ -0,0 +1,216 @@
+﻿#include "Classes/cooked_texture.h"
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace FireEngine
+{
+	namespace
+	{
+		uint64_t AlignOffset(uint64_t offset, uint64_t alignment)
+		{
+			return (offset + alignment - 1) & ~(alignment - 1);
+		}
+
+		void WritePadding(std::ofstream& file, uint64_t target_offset)
+		{
+			static const char zeros[c_cooked_texture_placement_alignment] = {};
+			uint64_t remaining = target_offset - static_cast<uint64_t>(file.tellp());
+			while (remaining > 0)
+			{
+				const uint64_t count = remaining < sizeof(zeros) ? remaining : sizeof(zeros);
+				file.write(zeros, static_cast<std::streamsize>(count));
+				remaining -= count;
+			}
+		}
+	}
+
+	bool WriteCookedTexture(const std::string& file_name, const CTexture& texture)
+	{
+		if (texture.m_mips.empty() || texture.m_mips.size() > c_cooked_texture_max_mips)
+		{
+			return false;
+		}
+
+		SCookedTextureHeader header{};
+		header.magic = c_cooked_texture_magic;
+		header.version = c_cooked_texture_version;
+		header.format = static_cast<uint32_t>(texture.m_format);
+		header.width = static_cast<uint32_t>(texture.m_width);
+		header.height = static_cast<uint32_t>(texture.m_height);
+		header.mip_count = static_cast<uint32_t>(texture.m_mips.size());
+		header.subresource_stride = sizeof(STextureSubresource);
+		header.subresource_offset = AlignOffset(sizeof(SCookedTextureHeader), alignof(STextureSubresource));
+
+		// 与 GetCopyableFootprints 的结果同样对齐, 上传时每个子资源只需要一次 memcpy
+		std::vector<STextureSubresource> subresources;
+		subresources.reserve(header.mip_count);
+		uint64_t offset = header.subresource_offset + header.mip_count * sizeof(STextureSubresource);
+		for (const STextureMip& mip : texture.m_mips)
+		{
+			auto& subresource = subresources.emplace_back();
+			subresource.width = mip.width;
+			subresource.height = mip.height;
+			subresource.row_size = GetTextureRowPitch(texture.m_format, mip.width);
+			subresource.row_pitch = AlignOffset(subresource.row_size, c_cooked_texture_row_pitch_alignment);
+			subresource.row_count = GetTextureRowCount(texture.m_format, mip.height);
+			subresource.offset = AlignOffset(offset, c_cooked_texture_placement_alignment);
+			offset = subresource.offset + subresource.row_pitch * subresource.row_count;
+			if (mip.offset + subresource.row_size * subresource.row_count > texture.m_data.size())
+			{
+				return false;
+			}
+		}
+		header.data_size = offset;
+
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(file_name).parent_path(), error);
+
+		// 先写临时文件再改名, 避免运行时映射到写了一半的文件
+		const std::string temp_file_name = MakeTempFileName(file_name);
+		{
+			std::ofstream file(temp_file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				return false;
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			WritePadding(file, header.subresource_offset);
+			file.write(reinterpret_cast<const char*>(subresources.data()), subresources.size() * sizeof(STextureSubresource));
+			for (uint32_t mip = 0; mip < header.mip_count; ++mip)
+			{
+				const STextureSubresource& subresource = subresources[mip];
+				const uint8_t* src = texture.m_data.data() + texture.m_mips[mip].offset;
+				WritePadding(file, subresource.offset);
+				for (uint64_t row = 0; row < subresource.row_count; ++row)
+				{
+					file.write(reinterpret_cast<const char*>(src + subresource.row_size * row), static_cast<std::streamsize>(subresource.row_size));
+					WritePadding(file, subresource.offset + subresource.row_pitch * (row + 1));
+				}
+			}
+			if (!file)
+			{
+				file.close();
+				std::filesystem::remove(temp_file_name, error);
+				return false;
+			}
+		}
+		std::filesystem::rename(temp_file_name, file_name, error);
+		if (error)
+		{
+			std::filesystem::remove(temp_file_name, error);
+			return false;
+		}
+		return true;
+	}
+
+	bool CookTexture(const std::string& file_name, CTexture& texture, EMipContent content, ETextureFormat format, CJobSystem* job_system)
+	{
+		if (texture.m_format != ETextureFormat::RGBA8 || texture.m_mips.empty())
+		{
+			return false;
+		}
+		// 运行时加载用的是较快的 Box 滤波, 烘焙只做一次, 换成 Kaiser
+		texture.m_data.resize(texture.m_mips[0].size);
+		texture.m_mips.resize(1);
+		if (!texture.GenerateMips(content, EMipFilter::Kaiser, job_system))
+		{
+			return false;
+		}
+		if (IsBlockCompressed(format) && texture.m_width % 4 == 0 && texture.m_height % 4 == 0
+			&& !texture.Compress(format, ECompressionQuality::Normal, job_system))
+		{
+			return false;
+		}
+		return WriteCookedTexture(file_name, texture);
+	}
+
+	SHash128 GetCookedTextureKey(const SByteView& source, EMipContent content, ETextureFormat format)
+	{
+		CContentHasher hasher;
+		hasher.Add(HashBytes(source.data, source.size))
+			.AddValue(c_cooked_texture_version)
+			.AddValue(c_texture_cooker_version)
+			.AddValue(static_cast<uint32_t>(content))
+			.AddValue(static_cast<uint32_t>(format))
+			.AddValue(static_cast<uint32_t>(EMipFilter::Kaiser))
+			.AddValue(static_cast<uint32_t>(ECompressionQuality::Normal));
+		return hasher.Finish();
+	}
+
+	bool CCookedTexture::Load(const std::string& file_name)
+	{
+		SFileData file;
+		return file.Open(file_name) && Load(std::move(file));
+	}
+
+	bool CCookedTexture::Load(SFileData&& file)
+	{
+		m_header = nullptr;
+		m_file = std::move(file);
+
+		const uint64_t file_size = m_file.view.size;
+		if (file_size < sizeof(SCookedTextureHeader))
+		{
+			m_file = {};
+			return false;
+		}
+
+		const auto* header = reinterpret_cast<const SCookedTextureHeader*>(m_file.view.data);
+		bool valid = header->magic == c_cooked_texture_magic
+			&& header->version == c_cooked_texture_version
+			&& header->format <= static_cast<uint32_t>(ETextureFormat::BC7)
+			&& header->width > 0 && header->height > 0
+			&& header->subresource_stride == sizeof(STextureSubresource)
+			&& header->mip_count > 0 && header->mip_count <= c_cooked_texture_max_mips
+			&& header->subresource_offset % alignof(STextureSubresource) == 0
+			&& header->subresource_offset <= file_size
+			&& header->mip_count <= (file_size - header->subresource_offset) / sizeof(STextureSubresource);
+		if (valid)
+		{
+			// 每层都要符合上传布局, 否则 RHI 的整块拷贝会越界
+			const ETextureFormat format = static_cast<ETextureFormat>(header->format);
+			const auto* subresources = reinterpret_cast<const STextureSubresource*>(m_file.view.data + header->subresource_offset);
+			for (uint32_t mip = 0; mip < header->mip_count && valid; ++mip)
+			{
+				const STextureSubresource& subresource = subresources[mip];
+				const uint32_t expected_width = header->width >> mip ? header->width >> mip : 1;
+				const uint32_t expected_height = header->height >> mip ? header->height >> mip : 1;
+				valid = subresource.width == expected_width
+					&& subresource.height == expected_height
+					&& subresource.row_size == GetTextureRowPitch(format, subresource.width)
+					&& subresource.row_count == GetTextureRowCount(format, subresource.height)
+					&& subresource.row_pitch % c_cooked_texture_row_pitch_alignment == 0
+					&& subresource.row_pitch >= subresource.row_size
+					&& subresource.offset % c_cooked_texture_placement_alignment == 0
+					&& subresource.offset <= file_size
+					&& subresource.row_count <= (file_size - subresource.offset) / subresource.row_pitch;
+			}
+		}
+		if (!valid)
+		{
+			m_file = {};
+			return false;
+		}
+		m_header = header;
+		return true;
+	}
+
+	STextureView CCookedTexture::GetView() const
+	{
+		STextureView view;
+		if (!m_header)
+		{
+			return view;
+		}
+		const uint8_t* base = m_file.view.data;
+		view.format = static_cast<ETextureFormat>(m_header->format);
+		view.width = m_header->width;
+		view.height = m_header->height;
+		view.data = base;
+		view.subresources = reinterpret_cast<const STextureSubresource*>(base + m_header->subresource_offset);
+		view.subresource_count = m_header->mip_count;
+		return view;
+	}
+}
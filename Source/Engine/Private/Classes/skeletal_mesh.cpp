@@ -0,0 +1,73 @@
+﻿#include "Classes/skeletal_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace FireEngine
+{
+	namespace
+	{
+		FMatrix ComposeTransform(const FVector& translation, const FQuat& rotation, const FVector& scaling)
+		{
+			FMatrix matrix = FMatrix::Identity();
+			matrix.block<3, 3>(0, 0) = rotation.toRotationMatrix() * scaling.asDiagonal();
+			matrix.block<3, 1>(0, 3) = translation;
+			return matrix;
+		}
+	}
+
+	void CSkeletalMesh::EvaluateSkinMatrices(uint32_t clip_index, float time, std::vector<SSkinMatrix>& out_matrices) const
+	{
+		const size_t bone_count = m_bones.size();
+		out_matrices.resize(bone_count);
+		if (bone_count == 0)
+		{
+			return;
+		}
+
+		const SAnimationClip* clip = nullptr;
+		uint32_t              frame0 = 0;
+		uint32_t              frame1 = 0;
+		float                 alpha = 0.0f;
+		if (clip_index < m_animations.size() && m_animations[clip_index].frame_count > 0 && m_animations[clip_index].frames.size() >= bone_count * m_animations[clip_index].frame_count)
+		{
+			clip = &m_animations[clip_index];
+			const float frame = std::fmod(std::max(time, 0.0f) * clip->frame_rate, static_cast<float>(clip->frame_count));
+			frame0 = std::min(static_cast<uint32_t>(frame), clip->frame_count - 1);
+			frame1 = (frame0 + 1) % clip->frame_count;
+			alpha = frame - static_cast<float>(frame0);
+		}
+
+		thread_local std::vector<FMatrix> global_transforms;
+		global_transforms.resize(bone_count);
+		for (size_t bone = 0; bone < bone_count; ++bone)
+		{
+			FMatrix local;
+			if (clip)
+			{
+				const SBoneTransform& from = clip->frames[frame0 * bone_count + bone];
+				const SBoneTransform& to = clip->frames[frame1 * bone_count + bone];
+				local = ComposeTransform(from.translation + (to.translation - from.translation) * alpha, from.rotation.slerp(alpha, to.rotation),
+					from.scaling + (to.scaling - from.scaling) * alpha);
+			}
+			else
+			{
+				const SBoneTransform& bind = m_bones[bone].bind_local;
+				local = ComposeTransform(bind.translation, bind.rotation, bind.scaling);
+			}
+
+			const int32_t parent = m_bones[bone].parent_index;
+			global_transforms[bone] = parent >= 0 && static_cast<size_t>(parent) < bone ? FMatrix(global_transforms[parent] * local) : local;
+
+			const FMatrix skin = global_transforms[bone] * m_bones[bone].inverse_bind_pose;
+			SSkinMatrix&  out_matrix = out_matrices[bone];
+			for (uint32_t column = 0; column < 4; ++column)
+			{
+				out_matrix.columns[column][0] = skin(0, column);
+				out_matrix.columns[column][1] = skin(1, column);
+				out_matrix.columns[column][2] = skin(2, column);
+				out_matrix.columns[column][3] = 0.0f;
+			}
+		}
+	}
+}
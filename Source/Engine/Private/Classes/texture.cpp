@@ -3,21 +3,125 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "Core/png_decoder.h"
 
 
 namespace FireEngine
 {
-	void CTexture::LoadTextureFromFile(const std::string& tex_file_name)
+	void CTexture::LoadTextureFromFile(const std::string& tex_file_name, CJobSystem* job_system)
 	{
-		stbi_uc* pixels = stbi_load(tex_file_name.c_str(), &m_width, &m_height, &m_channels, STBI_rgb_alpha);
-		if (!pixels)
+		CMappedFile file;
+		if (!file.Open(tex_file_name) || !LoadTextureFromMemory(file.GetView(), job_system))
 		{
 			printf("[error]图片读取失败!\n");
-			return;
+		}
+	}
+
+	bool CTexture::LoadTextureFromMemory(const SByteView& data, CJobSystem* job_system)
+	{
+		// PNG 直接解码进 m_data, 大图的反滤波分给工作线程
+		SPngInfo png_info;
+		if (ReadPngInfo(data, png_info) && IsPngDecodable(png_info))
+		{
+			m_width = static_cast<int32_t>(png_info.width);
+			m_height = static_cast<int32_t>(png_info.height);
+			m_channels = png_info.channels;
+			m_format = ETextureFormat::RGBA8;
+			m_data.resize(static_cast<uint64_t>(m_width) * m_height * 4);
+			if (DecodePng(data, png_info, m_data.data(), job_system))
+			{
+				m_mips = { { png_info.width, png_info.height, 0, m_data.size() } };
+				return true;
+			}
+			m_data.clear();
+			printf("[error]PNG解码失败!\n");
+			return false;
+		}
+
+		// 其它格式仍然交给 stb
+		if (data.size > INT32_MAX)
+		{
+			return false;
+		}
+		stbi_uc* pixels = stbi_load_from_memory(data.data, static_cast<int>(data.size), &m_width, &m_height, &m_channels, STBI_rgb_alpha);
+		if (!pixels)
+		{
+			printf("[error]图片解码失败!\n");
+			return false;
 		}
 		uint64_t data_size = static_cast<uint64_t>(m_width) * m_height * 4 * sizeof(uint8_t);
+		m_format = ETextureFormat::RGBA8;
 		m_data.resize(data_size);
 		memcpy(m_data.data(), pixels, data_size);
 		stbi_image_free(pixels);
+		m_mips = { { static_cast<uint32_t>(m_width), static_cast<uint32_t>(m_height), 0, data_size } };
+		return true;
+	}
+
+	bool CTexture::GenerateMips(EMipContent content, EMipFilter filter, CJobSystem* job_system)
+	{
+		if (m_format != ETextureFormat::RGBA8 || m_data.empty())
+		{
+			return false;
+		}
+		return GenerateMipChain(m_data, m_width, m_height, content, filter, m_mips, job_system);
+	}
+
+	bool CTexture::Compress(ETextureFormat format, ECompressionQuality quality, CJobSystem* job_system)
+	{
+		if (m_format != ETextureFormat::RGBA8 || !IsBlockCompressed(format))
+		{
+			return m_format == format;
+		}
+		// D3D12 要求块压缩贴图的顶层尺寸是4的倍数
+		if (m_width % 4 != 0 || m_height % 4 != 0)
+		{
+			printf("[error]:texture %dx%d can not be block compressed!\n", m_width, m_height);
+			return false;
+		}
+		// 逐层压缩后重新排布, 最小的几层不足一个块时按一个块补齐
+		std::vector<uint8_t>     compressed;
+		std::vector<STextureMip> compressed_mips = m_mips;
+		std::vector<uint8_t>     blocks;
+		uint64_t                 compressed_size = 0;
+		for (const STextureMip& mip : m_mips)
+		{
+			compressed_size += GetTextureDataSize(format, mip.width, mip.height);
+		}
+		compressed.reserve(compressed_size);
+		for (STextureMip& mip : compressed_mips)
+		{
+			if (!CompressTexture(m_data.data() + mip.offset, mip.width, mip.height, format, quality, blocks, job_system))
+			{
+				return false;
+			}
+			mip.offset = compressed.size();
+			mip.size = blocks.size();
+			compressed.insert(compressed.end(), blocks.begin(), blocks.end());
+		}
+		m_data = std::move(compressed);
+		m_mips = std::move(compressed_mips);
+		m_format = format;
+		return true;
+	}
+
+	STextureView CTexture::GetView(std::vector<STextureSubresource>& out_subresources) const
+	{
+		out_subresources.clear();
+		out_subresources.reserve(m_mips.size());
+		for (const STextureMip& mip : m_mips)
+		{
+			const uint64_t row_size = GetTextureRowPitch(m_format, mip.width);
+			out_subresources.push_back({ mip.width, mip.height, mip.offset, row_size, row_size, GetTextureRowCount(m_format, mip.height) });
+		}
+
+		STextureView view;
+		view.format = m_format;
+		view.width = static_cast<uint32_t>(m_width);
+		view.height = static_cast<uint32_t>(m_height);
+		view.data = m_data.data();
+		view.subresources = out_subresources.data();
+		view.subresource_count = static_cast<uint32_t>(out_subresources.size());
+		return view;
 	}
 }
@@ -1,6 +1,14 @@
 ﻿#include "Core/ReadData.h"
 
-#include "Core/OBJ_Loader.hpp"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+#include "Core/float_table_reader.h"
+#include "Core/job_system.h"
+#include "Core/obj_reader.h"
+#include "Core/vertex_welder.h"
+#include "Global/global_context.h"
 #include "Windows.h"
 namespace FireEngine
 {
@@ -45,81 +53,174 @@ namespace FireEngine
 		return blob;
 	}
 
+	CMappedFile MapData(const std::string& file_name)
+	{
+		CMappedFile mapped_file;
+		if (mapped_file.Open(file_name))
+		{
+			return mapped_file;
+		}
+
+#if !defined(WINAPI_FAMILY) || (WINAPI_FAMILY == WINAPI_FAMILY_DESKTOP_APP)
+		char module_name[_MAX_PATH] = {};
+		if (!GetModuleFileNameA(nullptr, module_name, _MAX_PATH)) throw std::system_error(std::error_code(static_cast<int>(GetLastError()), std::system_category()), "GetModuleFileNameA");
+
+		char drive[_MAX_DRIVE];
+		char path[_MAX_PATH];
+
+		if (_splitpath_s(module_name, drive, _MAX_DRIVE, path, _MAX_PATH, nullptr, 0, nullptr, 0)) throw std::runtime_error("_splitpath_s");
+
+		char module_relative_name[_MAX_PATH];
+		if (_makepath_s(module_relative_name, _MAX_PATH, drive, path, file_name.c_str(), nullptr)) throw std::runtime_error("_makepath_s");
+
+		if (mapped_file.Open(module_relative_name))
+		{
+			return mapped_file;
+		}
+#endif
+
+		throw std::runtime_error("MapData");
+	}
+
 	bool LoadMeshVertex(const std::string& mesh_file_name, std::vector<FireEngine::SVertexInstance>& out_vertex_instances, std::vector<IndexType>& out_indices)
 	{
-		std::ifstream fin;
-		char          input;
+		CMappedFile mapped_file;
+		if (!mapped_file.Open(mesh_file_name))
+		{
+			return false;
+		}
 
-		fin.open(mesh_file_name.c_str());
-		if (fin.fail())
+		// 格式: "Vertex Count: N" 之后是 "Data:", 再往后每个顶点 8 个浮点数: position[3] uv[2] normal[3]
+		const char* p   = mapped_file.GetView().CharBegin();
+		const char* end = mapped_file.GetView().CharEnd();
+		p = static_cast<const char*>(memchr(p, ':', end - p));
+		if (!p)
 		{
 			return false;
 		}
-		fin.get(input);
-		while (input != ':')
+		++p;
+		while (p < end && (*p == ' ' || *p == '\t'))
 		{
-			fin.get(input);
+			++p;
 		}
-
-		uint32_t vertex_cnt;
-		fin >> vertex_cnt;
-
-		fin.get(input);
-		while (input != ':')
+		uint32_t vertex_cnt = 0;
+		if (std::from_chars(p, end, vertex_cnt).ec != std::errc())
 		{
-			fin.get(input);
+			return false;
+		}
+		p = static_cast<const char*>(memchr(p, ':', end - p));
+		if (!p)
+		{
+			return false;
 		}
-		fin.get(input);
-		fin.get(input);
+		++p;
 
-		out_vertex_instances.reserve(vertex_cnt);
-		out_indices.reserve(vertex_cnt);
+		constexpr uint32_t column_count = 8;
+		std::vector<float> values;
+		const uint64_t row_count = ReadFloatTable(p, end, column_count, values, vertex_cnt);
 
-		for (uint32_t i = 0; i < vertex_cnt; i++)
+		out_vertex_instances.reserve(row_count);
+		out_indices.reserve(row_count);
+		for (uint64_t i = 0; i < row_count; i++)
 		{
+			const float* row = &values[i * column_count];
 			auto& vertex = out_vertex_instances.emplace_back();
-			fin >> vertex.position[0] >> vertex.position[1] >> vertex.position[2];
+			vertex.position[0] = row[0];
+			vertex.position[1] = row[1];
+			vertex.position[2] = row[2];
 			vertex.position[3] = 1.0f;
-			fin >> vertex.uv[0] >> vertex.uv[1];
-			fin >> vertex.normal[0] >> vertex.normal[1] >> vertex.normal[2];
+			vertex.uv[0] = row[3];
+			vertex.uv[1] = row[4];
+			vertex.normal[0] = row[5];
+			vertex.normal[1] = row[6];
+			vertex.normal[2] = row[7];
 
-			out_indices.emplace_back(i);
+			out_indices.emplace_back(static_cast<IndexType>(i));
+		}
+		WeldVertices(out_vertex_instances, out_indices);
+		return row_count == vertex_cnt;
+	}
+
+	static bool ParseWeldedObj(const SByteView& data, SObjMeshData& out_mesh)
+	{
+		CJobSystem* job_system = g_global_singleton_context ? g_global_singleton_context->m_job_system.get() : nullptr;
+		bool parsed = job_system ? ReadObjParallel(data, *job_system, out_mesh) : ReadObj(data, out_mesh);
+		if (!parsed)
+		{
+			return false;
+		}
+		WeldVertices(out_mesh.vertices, out_mesh.indices, out_mesh.geometries);
+		return true;
+	}
+
+	bool ParseMeshVertexObject(const SByteView& data, std::vector<FireEngine::SVertexInstance>& out_vertex_instances, std::vector<IndexType>& out_indices, std::vector<SGeometryDesc>& out_geometries)
+	{
+		SObjMeshData obj_mesh;
+		if (!ParseWeldedObj(data, obj_mesh))
+		{
+			return false;
+		}
+		out_vertex_instances = std::move(obj_mesh.vertices);
+		out_indices = std::move(obj_mesh.indices);
+		out_geometries = std::move(obj_mesh.geometries);
+		return true;
+	}
+
+	bool ParseMeshVertexObject(const SByteView& data, std::vector<FireEngine::SVertexInstance>& out_vertex_instances, std::vector<IndexType>& out_indices, std::string& out_material_library)
+	{
+		SObjMeshData obj_mesh;
+		if (!ParseWeldedObj(data, obj_mesh))
+		{
+			return false;
+		}
+
+		// 多个子网格合并成一个网格时, 把子网格内的局部索引改成全局索引
+		for (const SGeometryDesc& geometry : obj_mesh.geometries)
+		{
+			for (uint32_t i = 0; i < geometry.index_count; ++i)
+			{
+				obj_mesh.indices[geometry.index_offset + i] += geometry.vertex_offset;
+			}
+		}
+		out_vertex_instances = std::move(obj_mesh.vertices);
+		out_indices = std::move(obj_mesh.indices);
+		out_material_library = std::move(obj_mesh.material_library);
+		return true;
+	}
+
+	bool ParseMeshVertexObject(const SByteView& data, std::vector<FireEngine::SVertexInstance>& out_vertex_instances, std::vector<IndexType>& out_indices)
+	{
+		std::string material_library;
+		return ParseMeshVertexObject(data, out_vertex_instances, out_indices, material_library);
+	}
+
+	bool LoadMeshVertexObject(const std::string& mesh_file_name, std::vector<FireEngine::SVertexInstance>& out_vertex_instances, std::vector<IndexType>& out_indices, std::vector<SGeometryDesc>& out_geometries)
+	{
+		CMappedFile mapped_file;
+		if (!mapped_file.Open(mesh_file_name))
+		{
+			printf("[error]:open %s failed!\n", mesh_file_name.c_str());
+			return false;
+		}
+		if (!ParseMeshVertexObject(mapped_file.GetView(), out_vertex_instances, out_indices, out_geometries))
+		{
+			printf("[error]:parse %s failed!\n", mesh_file_name.c_str());
+			return false;
 		}
 		return true;
 	}
 
 	void LoadMeshVertexObject(const std::string& mesh_file_name, std::vector<FireEngine::SVertexInstance>& out_vertex_instances, std::vector<IndexType>& out_indices)
 	{
-		objl::Loader loader;
-		loader.LoadFile(mesh_file_name);
-	
-		assert(loader.LoadedMeshes.size() == 1);
-		auto mesh = loader.LoadedMeshes[0];
-
-		out_vertex_instances.reserve(mesh.Vertices.size());
-		for (int i = 0; i < mesh.Vertices.size(); i++) {
-			FireEngine::SVertexInstance& vert     = out_vertex_instances.emplace_back();
-			const objl::Vertex&          src_vert = mesh.Vertices[i];
-			vert.position[0]                      = src_vert.Position.X;
-			vert.position[1]                      = src_vert.Position.Y;
-			vert.position[2]                      = src_vert.Position.Z;
-			vert.position[3]                      = 1.0f;
-
-			// normalize
-			float size_qure = src_vert.Normal.X* src_vert.Normal.X + src_vert.Normal.Y * src_vert.Normal.Y + src_vert.Normal.Z * src_vert.Normal.Z;
-			float length = std::sqrt(size_qure);
-			float inv_length = 1.0f / length;
-			vert.normal[0] = src_vert.Normal.X * inv_length;
-			vert.normal[1] = src_vert.Normal.Y * inv_length;
-			vert.normal[2] = src_vert.Normal.Z * inv_length;
-
-			vert.uv[0] = src_vert.TextureCoordinate.X;
-			vert.uv[1] = src_vert.TextureCoordinate.Y;
-		}
-		out_indices.reserve(mesh.Indices.size());
-		for (uint64_t i = 0; i < mesh.Indices.size(); i++)
-		{
-			out_indices.emplace_back(mesh.Indices[i]);
+		CMappedFile mapped_file;
+		if (!mapped_file.Open(mesh_file_name))
+		{
+			printf("[error]:open %s failed!\n", mesh_file_name.c_str());
+			return;
+		}
+		if (!ParseMeshVertexObject(mapped_file.GetView(), out_vertex_instances, out_indices))
+		{
+			printf("[error]:parse %s failed!\n", mesh_file_name.c_str());
 		}
 	}
 }
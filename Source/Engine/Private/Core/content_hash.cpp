@@ -0,0 +1,138 @@
+﻿#include "Core/content_hash.h"
+
+#include <cstring>
+
+namespace FireEngine
+{
+	namespace
+	{
+		constexpr uint64_t c_murmur_c1 = 0x87c37b91114253d5ull;
+		constexpr uint64_t c_murmur_c2 = 0x4cf5ad432745937full;
+
+		inline uint64_t RotateLeft(uint64_t value, int shift)
+		{
+			return (value << shift) | (value >> (64 - shift));
+		}
+
+		inline uint64_t Load64(const uint8_t* data)
+		{
+			uint64_t value;
+			memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		inline uint64_t FinalMix(uint64_t k)
+		{
+			k ^= k >> 33;
+			k *= 0xff51afd7ed558ccdull;
+			k ^= k >> 33;
+			k *= 0xc4ceb9fe1a85ec53ull;
+			k ^= k >> 33;
+			return k;
+		}
+
+		inline uint64_t MixK1(uint64_t k1)
+		{
+			k1 *= c_murmur_c1;
+			k1 = RotateLeft(k1, 31);
+			return k1 * c_murmur_c2;
+		}
+
+		inline uint64_t MixK2(uint64_t k2)
+		{
+			k2 *= c_murmur_c2;
+			k2 = RotateLeft(k2, 33);
+			return k2 * c_murmur_c1;
+		}
+	}
+
+	std::string SHash128::ToString() const
+	{
+		static const char digits[] = "0123456789abcdef";
+		std::string text(32, '0');
+		for (int i = 0; i < 16; ++i)
+		{
+			text[15 - i] = digits[(high >> (i * 4)) & 0xF];
+			text[31 - i] = digits[(low >> (i * 4)) & 0xF];
+		}
+		return text;
+	}
+
+	SHash128 HashBytes(const void* data, uint64_t size, uint64_t seed)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		const uint64_t block_count = size / 16;
+
+		uint64_t h1 = seed;
+		uint64_t h2 = seed;
+
+		// 主循环每次吃16字节, 两路交叉混合
+		for (uint64_t i = 0; i < block_count; ++i)
+		{
+			const uint64_t k1 = Load64(bytes + i * 16);
+			const uint64_t k2 = Load64(bytes + i * 16 + 8);
+
+			h1 ^= MixK1(k1);
+			h1 = RotateLeft(h1, 27);
+			h1 += h2;
+			h1 = h1 * 5 + 0x52dce729;
+
+			h2 ^= MixK2(k2);
+			h2 = RotateLeft(h2, 31);
+			h2 += h1;
+			h2 = h2 * 5 + 0x38495ab5;
+		}
+
+		// 不足16字节的尾部
+		const uint8_t* tail = bytes + block_count * 16;
+		uint64_t k1 = 0;
+		uint64_t k2 = 0;
+		switch (size & 15)
+		{
+		case 15: k2 ^= static_cast<uint64_t>(tail[14]) << 48; [[fallthrough]];
+		case 14: k2 ^= static_cast<uint64_t>(tail[13]) << 40; [[fallthrough]];
+		case 13: k2 ^= static_cast<uint64_t>(tail[12]) << 32; [[fallthrough]];
+		case 12: k2 ^= static_cast<uint64_t>(tail[11]) << 24; [[fallthrough]];
+		case 11: k2 ^= static_cast<uint64_t>(tail[10]) << 16; [[fallthrough]];
+		case 10: k2 ^= static_cast<uint64_t>(tail[9]) << 8; [[fallthrough]];
+		case 9:
+			k2 ^= static_cast<uint64_t>(tail[8]);
+			h2 ^= MixK2(k2);
+			[[fallthrough]];
+		case 8: k1 ^= static_cast<uint64_t>(tail[7]) << 56; [[fallthrough]];
+		case 7: k1 ^= static_cast<uint64_t>(tail[6]) << 48; [[fallthrough]];
+		case 6: k1 ^= static_cast<uint64_t>(tail[5]) << 40; [[fallthrough]];
+		case 5: k1 ^= static_cast<uint64_t>(tail[4]) << 32; [[fallthrough]];
+		case 4: k1 ^= static_cast<uint64_t>(tail[3]) << 24; [[fallthrough]];
+		case 3: k1 ^= static_cast<uint64_t>(tail[2]) << 16; [[fallthrough]];
+		case 2: k1 ^= static_cast<uint64_t>(tail[1]) << 8; [[fallthrough]];
+		case 1:
+			k1 ^= static_cast<uint64_t>(tail[0]);
+			h1 ^= MixK1(k1);
+			break;
+		default:
+			break;
+		}
+
+		h1 ^= size;
+		h2 ^= size;
+		h1 += h2;
+		h2 += h1;
+		h1 = FinalMix(h1);
+		h2 = FinalMix(h2);
+		h1 += h2;
+		h2 += h1;
+		return { h1, h2 };
+	}
+
+	CContentHasher& CContentHasher::Add(const void* data, uint64_t size)
+	{
+		// 以上一步的结果为前缀再哈希一次, 短数据的开销只有一次 HashBytes
+		const SHash128 part = HashBytes(data, size, m_hash.low ^ RotateLeft(m_hash.high, 32));
+		uint8_t chain[sizeof(SHash128) * 2];
+		memcpy(chain, &m_hash, sizeof(SHash128));
+		memcpy(chain + sizeof(SHash128), &part, sizeof(SHash128));
+		m_hash = HashBytes(chain, sizeof(chain));
+		return *this;
+	}
+}
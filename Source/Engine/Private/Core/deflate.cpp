@@ -0,0 +1,43 @@
+﻿#include "Core/deflate.h"
+
+#include <climits>
+
+// stb_image_write 只用到 zlib 压缩, 实现单独放在这个编译单元里并屏蔽它的警告
+#if defined(_MSC_VER)
+#pragma warning(push, 0)
+#elif defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wall"
+#pragma GCC diagnostic ignored "-Wextra"
+#endif
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_STATIC
+#define STBI_WRITE_NO_STDIO
+#include "stb_image_write.h"
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace FireEngine
+{
+	bool ZlibDeflate(const uint8_t* data, uint64_t size, std::vector<uint8_t>& out_data)
+	{
+		if (size > INT_MAX)
+		{
+			return false;
+		}
+		int compressed_size = 0;
+		unsigned char* compressed = stbi_zlib_compress(const_cast<uint8_t*>(data), static_cast<int>(size), &compressed_size, 8);
+		if (!compressed)
+		{
+			return false;
+		}
+		out_data.assign(compressed, compressed + compressed_size);
+		STBIW_FREE(compressed);
+		return true;
+	}
+}
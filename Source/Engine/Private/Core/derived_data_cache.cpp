@@ -0,0 +1,46 @@
+﻿#include "Core/derived_data_cache.h"
+
+#include <cstdio>
+#include <filesystem>
+
+namespace FireEngine
+{
+	CDerivedDataCache::CDerivedDataCache(const std::string& cache_directory)
+	{
+		// 统一成绝对路径, 资源系统读到绝对路径时直接映射, 不经过挂载点
+		std::error_code error;
+		m_cache_directory = std::filesystem::absolute(cache_directory, error).generic_string();
+		if (error)
+		{
+			m_cache_directory = cache_directory;
+		}
+		if (!m_cache_directory.empty() && m_cache_directory.back() != '/' && m_cache_directory.back() != '\\')
+		{
+			m_cache_directory += '/';
+		}
+		std::filesystem::create_directories(m_cache_directory, error);
+		if (error)
+		{
+			printf("[error]:create derived data cache %s failed!\n", m_cache_directory.c_str());
+		}
+	}
+
+	std::string CDerivedDataCache::GetPath(const SHash128& key, std::string_view extension) const
+	{
+		// 按前两位分256个子目录, 避免单个目录下文件过多
+		const std::string name = key.ToString();
+		std::string path = m_cache_directory;
+		path.append(name, 0, 2);
+		path += '/';
+		path += name;
+		path += '.';
+		path.append(extension.data(), extension.size());
+		return path;
+	}
+
+	bool CDerivedDataCache::Exists(const SHash128& key, std::string_view extension) const
+	{
+		std::error_code error;
+		return std::filesystem::is_regular_file(GetPath(key, extension), error);
+	}
+}
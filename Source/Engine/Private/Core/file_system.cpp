@@ -0,0 +1,750 @@
+﻿#include "Core/file_system.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#include "Classes/cooked_mesh.h"
+#include "Classes/cooked_texture.h"
+#include "Classes/material_library.h"
+#include "Classes/mesh.h"
+#include "Classes/texture.h"
+#include "Core/ReadData.h"
+#include "Core/job_system.h"
+#include "Core/mtl_reader.h"
+#include "Function/fbx_binary_reader.h"
+#include "Global/global_context.h"
+
+namespace FireEngine
+{
+	namespace
+	{
+		// 导入文件里的引用相对于引用它的文件所在目录
+		std::string ResolveDependencyPath(const std::string& owner_file_name, const std::string& reference)
+		{
+			const std::filesystem::path reference_path(reference);
+			if (reference_path.is_absolute())
+			{
+				return reference_path.lexically_normal().generic_string();
+			}
+			return (std::filesystem::path(owner_file_name).parent_path() / reference_path).lexically_normal().generic_string();
+		}
+	}
+
+	CFileSystem::CFileSystem(const std::string& resource_path) : m_resource_root_path(resource_path + "/"), m_io_queue(std::make_unique<CIoQueue>())
+	{
+		MountDirectory(resource_path);
+	}
+
+	bool CFileSystem::MountDirectory(const std::string& directory)
+	{
+		std::error_code error;
+		if (!std::filesystem::is_directory(directory, error))
+		{
+			printf("[error]:mount directory %s failed!\n", directory.c_str());
+			return false;
+		}
+		m_mount_points.push_back({ directory + "/", nullptr });
+		return true;
+	}
+
+	bool CFileSystem::MountPak(const std::string& pak_file_name)
+	{
+		auto pak = std::make_unique<CPakFile>();
+		if (!pak->Open(pak_file_name))
+		{
+			printf("[error]:mount pak %s failed!\n", pak_file_name.c_str());
+			return false;
+		}
+		m_mount_points.push_back({ std::string(), std::move(pak) });
+		return true;
+	}
+
+	FPathHash CFileSystem::InternPath(std::string_view relative_path)
+	{
+		const FPathHash path_hash = HashPath(relative_path);
+		std::lock_guard<std::mutex> lock(m_intern_mutex);
+		auto result = m_interned_paths.try_emplace(path_hash);
+		if (result.second)
+		{
+			result.first->second = NormalizePath(relative_path);
+		}
+		return path_hash;
+	}
+
+	bool CFileSystem::FindInternedPath(FPathHash path_hash, std::string& out_path) const
+	{
+		std::lock_guard<std::mutex> lock(m_intern_mutex);
+		auto it = m_interned_paths.find(path_hash);
+		if (it == m_interned_paths.end())
+		{
+			return false;
+		}
+		out_path = it->second;
+		return true;
+	}
+
+	bool CFileSystem::Exists(FPathHash path_hash) const
+	{
+		std::string path;
+		const bool interned = FindInternedPath(path_hash, path);
+		for (auto it = m_mount_points.rbegin(); it != m_mount_points.rend(); ++it)
+		{
+			std::error_code error;
+			if (it->pak ? it->pak->Find(path_hash) != nullptr : interned && std::filesystem::is_regular_file(it->directory + path, error))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool CFileSystem::ReadFile(FPathHash path_hash, SFileData& out_file, CJobSystem* job_system) const
+	{
+		std::string path;
+		const bool interned = FindInternedPath(path_hash, path);
+		for (auto it = m_mount_points.rbegin(); it != m_mount_points.rend(); ++it)
+		{
+			if (it->pak)
+			{
+				// 找到条目但读取失败(损坏或解压失败)时不再回退到更早的挂载, 避免悄悄读到旧版本
+				if (const SPakEntry* entry = it->pak->Find(path_hash))
+				{
+					return it->pak->Read(*entry, out_file, job_system);
+				}
+			}
+			else if (interned && out_file.Open(it->directory + path))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool CFileSystem::ReadFile(std::string_view relative_path, SFileData& out_file, CJobSystem* job_system)
+	{
+		return ReadFile(InternPath(relative_path), out_file, job_system);
+	}
+
+	bool CFileSystem::ReadFileRange(FPathHash path_hash, uint64_t offset, uint64_t size, uint8_t* out_data, CJobSystem* job_system) const
+	{
+		std::string path;
+		const bool interned = FindInternedPath(path_hash, path);
+		for (auto it = m_mount_points.rbegin(); it != m_mount_points.rend(); ++it)
+		{
+			if (it->pak)
+			{
+				if (const SPakEntry* entry = it->pak->Find(path_hash))
+				{
+					return it->pak->ReadRange(*entry, offset, size, out_data, job_system);
+				}
+			}
+			else if (interned)
+			{
+				// 映射整个文件只会换入拷贝到的页
+				CMappedFile file;
+				if (file.Open(it->directory + path))
+				{
+					if (offset > file.GetSize() || size > file.GetSize() - offset)
+					{
+						return false;
+					}
+					if (size > 0)
+					{
+						memcpy(out_data, file.GetData() + offset, size);
+					}
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void CFileSystem::ReadFileAsync(FPathHash path_hash, EIoPriority priority, FIoReadCallback on_read, bool direct, CJobSystem* job_system) const
+	{
+		std::string path;
+		const bool interned = FindInternedPath(path_hash, path);
+		for (auto it = m_mount_points.rbegin(); it != m_mount_points.rend(); ++it)
+		{
+			if (it->pak)
+			{
+				if (const SPakEntry* entry = it->pak->Find(path_hash))
+				{
+					SFileData file_data;
+					const bool success = it->pak->Read(*entry, file_data, job_system);
+					on_read(success, std::move(file_data));
+					return;
+				}
+			}
+			else if (interned)
+			{
+				// 打开和读取都在IO线程上进行, 后面还有挂载点时才需要先判断存在, 否则直接提交
+				std::error_code error;
+				const std::string file_name = it->directory + path;
+				if (std::next(it) == m_mount_points.rend() || std::filesystem::is_regular_file(file_name, error))
+				{
+					m_io_queue->Read(file_name, priority, std::move(on_read), direct);
+					return;
+				}
+			}
+		}
+		on_read(false, SFileData{});
+	}
+
+	void CFileSystem::ReadFileAsync(std::string_view relative_path, EIoPriority priority, FIoReadCallback on_read, bool direct, CJobSystem* job_system)
+	{
+		ReadFileAsync(InternPath(relative_path), priority, std::move(on_read), direct, job_system);
+	}
+
+	CAssetSystem::CAssetSystem()
+	{
+		m_reader_thread = std::thread([this]() { ReaderLoop(); });
+	}
+
+	CAssetSystem::~CAssetSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_read_condition.notify_all();
+		m_reader_thread.join();
+
+		// 还没读的请求直接丢弃, 已经提交给 IO 队列的读取和交给工作线程的解码要等它结束
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (std::deque<SLoadRequest>& read_requests : m_read_requests)
+		{
+			m_in_flight -= static_cast<uint32_t>(read_requests.size());
+			read_requests.clear();
+		}
+		m_complete_condition.wait(lock, [this]() { return m_in_flight == 0; });
+	}
+
+	SAssetHandle CAssetSystem::RetainAsset(std::unique_ptr<CAssetBase>&& asset, EAssetType type)
+	{
+		SAssetRecord record;
+		record.asset = std::move(asset);
+		record.state = EAssetState::Loaded;
+		record.ref_count = 1;
+		const SAssetHandle handle{ m_records.Insert(std::move(record)), type };
+		TrackCpuMemory(handle);
+		return handle;
+	}
+
+	CAssetBase* CAssetSystem::GetAsset(SAssetHandle handle)
+	{
+		// 还在等待依赖的资源已经解码, 发布之前对外不可见
+		SAssetRecord* record = m_records.Get(handle.slot);
+		if (!record || record->state != EAssetState::Loaded)
+		{
+			return nullptr;
+		}
+		m_residency.Touch(record->cpu_residency);
+		for (FResidencyHandle residency : record->gpu_residency)
+		{
+			m_residency.Touch(residency);
+		}
+		return record->asset.get();
+	}
+
+	SAssetHandle CAssetSystem::LoadAsync(const std::string& file_name, EAssetType type, FAssetLoadedCallback on_loaded, EIoPriority priority)
+	{
+		// 路径按文件系统的规则归一化后求哈希, 大小写和分隔符不同的写法指向同一个资源
+		CFileSystem* file_system = g_global_singleton_context ? g_global_singleton_context->m_file_system.get() : nullptr;
+		const SAssetKey key{ file_system ? file_system->InternPath(file_name) : HashPath(file_name), type };
+
+		SAssetHandle handle;
+		handle.type = type;
+		auto found = m_asset_slots.find(key);
+		if (found != m_asset_slots.end())
+		{
+			handle.slot = found->second;
+			SAssetRecord* record = m_records.Get(handle.slot);
+			++record->ref_count;
+			if (on_loaded)
+			{
+				if (record->state == EAssetState::Loading)
+				{
+					record->on_loaded.emplace_back(std::move(on_loaded));
+				}
+				else
+				{
+					m_ready_callbacks.emplace_back(handle, std::move(on_loaded));
+				}
+			}
+			return handle;
+		}
+
+		SAssetRecord record;
+		record.state = EAssetState::Loading;
+		record.ref_count = 1;
+		record.has_key = true;
+		record.key = key;
+		record.priority = priority;
+		if (on_loaded)
+		{
+			record.on_loaded.emplace_back(std::move(on_loaded));
+		}
+		handle.slot = m_records.Insert(std::move(record));
+		m_asset_slots.emplace(key, handle.slot);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++m_in_flight;
+			m_read_requests[static_cast<uint32_t>(priority)].push_back({ handle, file_name, priority });
+		}
+		m_read_condition.notify_one();
+		return handle;
+	}
+
+	EAssetState CAssetSystem::GetState(SAssetHandle handle) const
+	{
+		const SAssetRecord* record = m_records.Get(handle.slot);
+		return record ? record->state : EAssetState::Invalid;
+	}
+
+	uint32_t CAssetSystem::GetRefCount(SAssetHandle handle) const
+	{
+		const SAssetRecord* record = m_records.Get(handle.slot);
+		return record ? record->ref_count : 0;
+	}
+
+	std::vector<SAssetHandle> CAssetSystem::GetDependencies(SAssetHandle handle) const
+	{
+		const SAssetRecord* record = m_records.Get(handle.slot);
+		return record ? record->dependencies : std::vector<SAssetHandle>();
+	}
+
+	void CAssetSystem::AddRef(SAssetHandle handle)
+	{
+		if (SAssetRecord* record = m_records.Get(handle.slot))
+		{
+			++record->ref_count;
+		}
+	}
+
+	void CAssetSystem::Release(SAssetHandle handle)
+	{
+		SAssetRecord* record = m_records.Get(handle.slot);
+		if (record && record->ref_count > 0 && --record->ref_count == 0)
+		{
+			Unload(handle);
+		}
+	}
+
+	void CAssetSystem::Unload(SAssetHandle handle)
+	{
+		SAssetRecord* record = m_records.Get(handle.slot);
+		if (!record)
+		{
+			return;
+		}
+		// 回调里可能再加载别的资源, m_records 会扩容, 回调之后重新查找
+		std::vector<FAssetUnloadCallback> on_unload = std::move(record->on_unload);
+		for (FAssetUnloadCallback& callback : on_unload)
+		{
+			callback(handle, GetAsset(handle));
+		}
+
+		// 回调里可能已经卸载了它自己
+		record = m_records.Get(handle.slot);
+		if (!record)
+		{
+			return;
+		}
+		ForgetKey(*record);
+		m_residency.Untrack(record->cpu_residency);
+		for (FResidencyHandle residency : record->gpu_residency)
+		{
+			m_residency.Untrack(residency);
+		}
+		// 先删掉自己再释放依赖, 释放可能引起别的卸载, m_records 会变化
+		std::vector<SAssetHandle> dependencies = std::move(record->dependencies);
+		m_records.Erase(handle.slot);
+		for (SAssetHandle dependency : dependencies)
+		{
+			Release(dependency);
+		}
+	}
+
+	void CAssetSystem::TrackCpuMemory(SAssetHandle handle)
+	{
+		SAssetRecord* record = m_records.Get(handle.slot);
+		if (!record || !record->asset)
+		{
+			return;
+		}
+		record->cpu_residency = m_residency.Track(EResidencyCategory::CpuPayload, record->asset->GetMemorySize(), [this, handle]() {
+			if (SAssetRecord* evicted = m_records.Get(handle.slot))
+			{
+				evicted->asset->ReleaseCpuData();
+				evicted->cpu_residency = {};
+			}
+		});
+	}
+
+	void CAssetSystem::TrackGpuMemory(SAssetHandle handle, EResidencyCategory category, uint64_t size)
+	{
+		SAssetRecord* record = m_records.Get(handle.slot);
+		if (!record)
+		{
+			return;
+		}
+		// 卸载会连带 Untrack 其它条目, 被淘汰的这条已经移除
+		record->gpu_residency.emplace_back(m_residency.Track(category, size, [this, handle]() { Unload(handle); }));
+	}
+
+	void CAssetSystem::PinAsset(SAssetHandle handle, EResidencyCategory category)
+	{
+		SAssetRecord* record = m_records.Get(handle.slot);
+		if (!record)
+		{
+			return;
+		}
+		if (category == EResidencyCategory::CpuPayload)
+		{
+			m_residency.Pin(record->cpu_residency);
+			return;
+		}
+		for (FResidencyHandle residency : record->gpu_residency)
+		{
+			if (m_residency.GetCategory(residency) == category)
+			{
+				m_residency.Pin(residency);
+			}
+		}
+	}
+
+	void CAssetSystem::UnpinAsset(SAssetHandle handle, EResidencyCategory category)
+	{
+		SAssetRecord* record = m_records.Get(handle.slot);
+		if (!record)
+		{
+			return;
+		}
+		if (category == EResidencyCategory::CpuPayload)
+		{
+			m_residency.Unpin(record->cpu_residency);
+			return;
+		}
+		for (FResidencyHandle residency : record->gpu_residency)
+		{
+			if (m_residency.GetCategory(residency) == category)
+			{
+				m_residency.Unpin(residency);
+			}
+		}
+	}
+
+	bool CAssetSystem::IsCpuResident(SAssetHandle handle) const
+	{
+		const SAssetRecord* record = m_records.Get(handle.slot);
+		return record && record->asset && record->cpu_residency.IsValid();
+	}
+
+	void CAssetSystem::UpdateResidency()
+	{
+		m_residency.BeginFrame();
+		m_residency.EnforceBudgets();
+	}
+
+	void CAssetSystem::AddUnloadCallback(SAssetHandle handle, FAssetUnloadCallback on_unload)
+	{
+		SAssetRecord* record = m_records.Get(handle.slot);
+		if (record && on_unload)
+		{
+			record->on_unload.emplace_back(std::move(on_unload));
+		}
+	}
+
+	void CAssetSystem::ForgetKey(SAssetRecord& record)
+	{
+		if (!record.has_key)
+		{
+			return;
+		}
+		m_asset_slots.erase(record.key);
+		record.has_key = false;
+	}
+
+	void CAssetSystem::PumpCompletions()
+	{
+		std::vector<SLoadResult> completed;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			completed.swap(m_completed);
+		}
+		std::vector<std::pair<SAssetHandle, FAssetLoadedCallback>> ready_callbacks;
+		ready_callbacks.swap(m_ready_callbacks);
+
+		for (SLoadResult& result : completed)
+		{
+			// 加载期间已经被卸载, 句柄失效, 结果直接丢弃
+			SAssetRecord* record = m_records.Get(result.handle.slot);
+			if (!record)
+			{
+				continue;
+			}
+			record->asset = std::move(result.asset);
+			if (!record->asset || result.dependencies.empty())
+			{
+				Publish(result.handle);
+				continue;
+			}
+
+			// 依赖比依赖它的资源高一级, 排在同级的其它资源前面读取, 叶子先完成
+			const EIoPriority priority = record->priority == EIoPriority::Low ? EIoPriority::Normal : EIoPriority::High;
+			record->pending_dependencies = static_cast<uint32_t>(result.dependencies.size());
+			for (SAssetDependency& dependency : result.dependencies)
+			{
+				// 依赖的类型和依赖它的资源不同, 图里不会有环
+				const SAssetHandle dependency_handle = LoadAsync(dependency.file_name, dependency.type, [this, owner = result.handle](SAssetHandle, CAssetBase*) {
+					OnDependencyLoaded(owner);
+				}, priority);
+				m_records.Get(result.handle.slot)->dependencies.push_back(dependency_handle);
+			}
+		}
+		for (auto& [handle, callback] : ready_callbacks)
+		{
+			callback(handle, GetAsset(handle));
+		}
+	}
+
+	void CAssetSystem::Publish(SAssetHandle handle)
+	{
+		SAssetRecord* record = m_records.Get(handle.slot);
+		record->state = record->asset ? EAssetState::Loaded : EAssetState::Failed;
+		if (!record->asset)
+		{
+			ForgetKey(*record);
+		}
+		TrackCpuMemory(handle);
+		record = m_records.Get(handle.slot);
+		std::vector<FAssetLoadedCallback> on_loaded = std::move(record->on_loaded);
+		for (FAssetLoadedCallback& callback : on_loaded)
+		{
+			callback(handle, GetAsset(handle));
+		}
+	}
+
+	void CAssetSystem::OnDependencyLoaded(SAssetHandle handle)
+	{
+		// 等待期间被卸载时依赖已经随之释放
+		SAssetRecord* record = m_records.Get(handle.slot);
+		if (record && record->state == EAssetState::Loading && --record->pending_dependencies == 0)
+		{
+			Publish(handle);
+		}
+	}
+
+	bool CAssetSystem::Wait(SAssetHandle handle)
+	{
+		while (GetState(handle) == EAssetState::Loading)
+		{
+			// 已经加载完成的依赖的回调推迟到了下一次 PumpCompletions, 不需要等待
+			if (m_ready_callbacks.empty())
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_complete_condition.wait(lock, [this]() { return !m_completed.empty(); });
+			}
+			PumpCompletions();
+		}
+		return GetState(handle) == EAssetState::Loaded;
+	}
+
+	void CAssetSystem::ReaderLoop()
+	{
+		while (true)
+		{
+			SLoadRequest request;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				auto has_request = [this]() {
+					return std::any_of(m_read_requests.begin(), m_read_requests.end(), [](const std::deque<SLoadRequest>& read_requests) { return !read_requests.empty(); });
+				};
+				m_read_condition.wait(lock, [this, &has_request]() { return m_quit || has_request(); });
+				if (m_quit)
+				{
+					return;
+				}
+				for (std::deque<SLoadRequest>& read_requests : m_read_requests)
+				{
+					if (!read_requests.empty())
+					{
+						request = std::move(read_requests.front());
+						read_requests.pop_front();
+						break;
+					}
+				}
+			}
+
+			// 资源路径都相对于挂载点, 在 pak 中未压缩时拿到的是 pak 映射上的视图
+			// 绝对路径(比如派生数据缓存里的烘焙结果)不经过挂载点, 直接交给 IO 队列
+			// 散文件的读取是异步的, 读取线程不等它完成, 一次可以有一整批文件在途
+			CFileSystem* file_system = g_global_singleton_context ? g_global_singleton_context->m_file_system.get() : nullptr;
+			CJobSystem* job_system = g_global_singleton_context ? g_global_singleton_context->m_job_system.get() : nullptr;
+			const bool is_absolute = std::filesystem::path(request.file_name).is_absolute();
+			// 烘焙结果读完就上传或交给流送, 绕过页缓存
+			const bool direct = request.handle.type == EAssetType::CookedMesh || request.handle.type == EAssetType::CookedTexture;
+			const std::string file_name = request.file_name;
+			const EIoPriority priority = request.priority;
+			FIoReadCallback on_read = [this, request = std::move(request)](bool success, SFileData&& file_data) mutable {
+				OnFileRead(std::move(request), success, std::move(file_data));
+			};
+			if (!file_system)
+			{
+				SFileData file_data;
+				const bool success = file_data.Open(file_name);
+				on_read(success, std::move(file_data));
+			}
+			else if (is_absolute)
+			{
+				file_system->GetIoQueue().Read(file_name, priority, std::move(on_read), direct);
+			}
+			else
+			{
+				file_system->ReadFileAsync(file_name, priority, std::move(on_read), direct, job_system);
+			}
+		}
+	}
+
+	void CAssetSystem::OnFileRead(SLoadRequest&& request, bool success, SFileData&& file_data)
+	{
+		if (!success)
+		{
+			// 烘焙结果不存在是正常情况, 调用方会重新烘焙
+			if (request.handle.type != EAssetType::CookedMesh && request.handle.type != EAssetType::CookedTexture)
+			{
+				printf("[error]:open %s failed!\n", request.file_name.c_str());
+			}
+			Complete(std::move(request), nullptr);
+			return;
+		}
+
+		// .femesh 和 .fetex 只做校验, 不需要解码
+		if (request.handle.type == EAssetType::CookedMesh)
+		{
+			auto cooked_mesh = std::make_unique<CCookedMesh>();
+			if (!cooked_mesh->Load(std::move(file_data)))
+			{
+				cooked_mesh.reset();
+			}
+			Complete(std::move(request), std::move(cooked_mesh));
+			return;
+		}
+		if (request.handle.type == EAssetType::CookedTexture)
+		{
+			auto cooked_texture = std::make_unique<CCookedTexture>();
+			if (!cooked_texture->Load(std::move(file_data)))
+			{
+				cooked_texture.reset();
+			}
+			Complete(std::move(request), std::move(cooked_texture));
+			return;
+		}
+
+		// IO线程只做IO, 解码放到工作线程上, 后面文件的读取和这个文件的解码重叠
+		CJobSystem* job_system = g_global_singleton_context ? g_global_singleton_context->m_job_system.get() : nullptr;
+		if (job_system)
+		{
+			// std::function 要求可拷贝, 映射的文件只能移动, 放进 shared_ptr 里交给工作线程
+			auto shared_file_data = std::make_shared<SFileData>(std::move(file_data));
+			job_system->Submit([this, request = std::move(request), shared_file_data]() mutable {
+				Decode(std::move(request), std::move(*shared_file_data));
+			});
+		}
+		else
+		{
+			Decode(std::move(request), std::move(file_data));
+		}
+	}
+
+	void CAssetSystem::Decode(SLoadRequest&& request, SFileData&& file_data)
+	{
+		const SByteView data = file_data.view;
+		std::unique_ptr<CAssetBase> asset;
+		std::vector<SAssetDependency> dependencies;
+		switch (request.handle.type)
+		{
+		case EAssetType::Mesh:
+		{
+			auto mesh = std::make_unique<CMesh>();
+			std::string material_library;
+			if (ParseMeshVertexObject(data, mesh->m_vretices, mesh->m_indices, material_library))
+			{
+				asset = std::move(mesh);
+				if (!material_library.empty())
+				{
+					dependencies.push_back({ ResolveDependencyPath(request.file_name, material_library), EAssetType::MaterialLibrary });
+				}
+			}
+			break;
+		}
+		case EAssetType::MaterialLibrary:
+		{
+			auto material_library = std::make_unique<CMaterialLibrary>();
+			if (ReadMtl(data, material_library->m_materials))
+			{
+				// 多个材质共用一张贴图时只加载一次
+				auto add_texture = [&](const std::string& texture, EAssetType type) {
+					if (texture.empty())
+					{
+						return;
+					}
+					SAssetDependency dependency{ ResolveDependencyPath(request.file_name, texture), type };
+					auto same = [&dependency](const SAssetDependency& other) { return other.type == dependency.type && other.file_name == dependency.file_name; };
+					if (std::none_of(dependencies.begin(), dependencies.end(), same))
+					{
+						dependencies.push_back(std::move(dependency));
+					}
+				};
+				for (const SMtlMaterial& material : material_library->m_materials)
+				{
+					add_texture(material.diffuse_texture, EAssetType::Texture);
+					add_texture(material.normal_texture, EAssetType::NormalMap);
+				}
+				asset = std::move(material_library);
+			}
+			break;
+		}
+		case EAssetType::FbxMesh:
+		{
+			auto mesh = std::make_unique<CMesh>();
+			if (ReadFbxMesh(data, *mesh))
+			{
+				asset = std::move(mesh);
+			}
+			break;
+		}
+		case EAssetType::Texture:
+		case EAssetType::NormalMap:
+		{
+			// 多张贴图各自在工作线程上解码并生成 mip, 单张大图内部再用 ParallelFor 切分
+			auto texture = std::make_unique<CTexture>();
+			CJobSystem* job_system = g_global_singleton_context ? g_global_singleton_context->m_job_system.get() : nullptr;
+			const EMipContent mip_content = request.handle.type == EAssetType::NormalMap ? EMipContent::NormalMap : EMipContent::Color;
+			if (texture->LoadTextureFromMemory(data, job_system) && texture->GenerateMips(mip_content, EMipFilter::Box, job_system))
+			{
+				asset = std::move(texture);
+			}
+			break;
+		}
+		default:
+			break;
+		}
+		if (!asset)
+		{
+			printf("[error]:load %s failed!\n", request.file_name.c_str());
+		}
+		Complete(std::move(request), std::move(asset), std::move(dependencies));
+	}
+
+	void CAssetSystem::Complete(SLoadRequest&& request, std::unique_ptr<CAssetBase>&& asset, std::vector<SAssetDependency>&& dependencies)
+	{
+		// 持锁通知, 否则析构函数看到 m_in_flight 归零后可能先销毁条件变量
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_completed.push_back({ request.handle, std::move(asset), std::move(dependencies) });
+		--m_in_flight;
+		m_complete_condition.notify_all();
+	}
+}
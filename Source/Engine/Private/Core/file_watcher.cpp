@@ -0,0 +1,266 @@
+﻿#include "Core/file_watcher.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <utility>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace FireEngine
+{
+	CFileWatcher::CFileWatcher(const std::string& root_directory, uint32_t settle_time_ms)
+		: m_root_directory(root_directory)
+		, m_settle_time(settle_time_ms)
+	{
+		if (!m_root_directory.empty() && m_root_directory.back() != '/' && m_root_directory.back() != '\\')
+		{
+			m_root_directory += '/';
+		}
+		if (!Open())
+		{
+			printf("[error]:watch %s failed!\n", m_root_directory.c_str());
+			Close();
+			return;
+		}
+		m_thread = std::thread([this]() { WatchLoop(); });
+	}
+
+	CFileWatcher::~CFileWatcher()
+	{
+		if (m_thread.joinable())
+		{
+#if defined(_WIN32)
+			SetEvent(m_stop_event);
+#else
+			const char stop = 0;
+			while (write(m_stop_pipe[1], &stop, 1) < 0 && errno == EINTR)
+			{
+			}
+#endif
+			m_thread.join();
+		}
+		Close();
+	}
+
+	void CFileWatcher::PollChanges(std::vector<std::string>& out_paths)
+	{
+		const auto now = std::chrono::steady_clock::now();
+		const size_t first = out_paths.size();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (auto it = m_pending_changes.begin(); it != m_pending_changes.end();)
+			{
+				if (now - it->second < m_settle_time)
+				{
+					++it;
+					continue;
+				}
+				out_paths.emplace_back(it->first);
+				it = m_pending_changes.erase(it);
+			}
+		}
+		std::sort(out_paths.begin() + first, out_paths.end());
+	}
+
+	void CFileWatcher::AddChange(std::string&& path)
+	{
+		std::replace(path.begin(), path.end(), '\\', '/');
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pending_changes[std::move(path)] = std::chrono::steady_clock::now();
+	}
+
+#if defined(_WIN32)
+	bool CFileWatcher::Open()
+	{
+		const std::wstring directory = std::filesystem::path(m_root_directory).wstring();
+		HANDLE handle = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if (handle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		m_directory_handle = handle;
+		m_stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+		return m_stop_event != nullptr;
+	}
+
+	void CFileWatcher::Close()
+	{
+		if (m_directory_handle)
+		{
+			CloseHandle(m_directory_handle);
+			m_directory_handle = nullptr;
+		}
+		if (m_stop_event)
+		{
+			CloseHandle(m_stop_event);
+			m_stop_event = nullptr;
+		}
+	}
+
+	void CFileWatcher::WatchLoop()
+	{
+		alignas(DWORD) static thread_local uint8_t buffer[64 * 1024];
+		OVERLAPPED overlapped = {};
+		overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+		HANDLE events[] = { overlapped.hEvent, m_stop_event };
+		for (;;)
+		{
+			ResetEvent(overlapped.hEvent);
+			if (!ReadDirectoryChangesW(m_directory_handle, buffer, sizeof(buffer), TRUE,
+				FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE, nullptr, &overlapped, nullptr))
+			{
+				break;
+			}
+			DWORD bytes = 0;
+			if (WaitForMultipleObjects(_countof(events), events, FALSE, INFINITE) != WAIT_OBJECT_0)
+			{
+				CancelIoEx(m_directory_handle, &overlapped);
+				GetOverlappedResult(m_directory_handle, &overlapped, &bytes, TRUE);
+				break;
+			}
+			if (!GetOverlappedResult(m_directory_handle, &overlapped, &bytes, FALSE))
+			{
+				break;
+			}
+			if (bytes == 0)
+			{
+				// 缓冲区放不下, 这一批通知丢失了
+				printf("[warning]:file watcher overflowed, some changes were missed\n");
+				continue;
+			}
+			const uint8_t* cursor = buffer;
+			for (;;)
+			{
+				const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(cursor);
+				if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME)
+				{
+					const int name_length = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+					const int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, name_length, nullptr, 0, nullptr, nullptr);
+					std::string path(static_cast<size_t>(length), '\0');
+					WideCharToMultiByte(CP_UTF8, 0, info->FileName, name_length, path.data(), length, nullptr, nullptr);
+					AddChange(std::move(path));
+				}
+				if (info->NextEntryOffset == 0)
+				{
+					break;
+				}
+				cursor += info->NextEntryOffset;
+			}
+		}
+		CloseHandle(overlapped.hEvent);
+	}
+#else
+	bool CFileWatcher::Open()
+	{
+		m_inotify_descriptor = inotify_init1(IN_CLOEXEC);
+		if (m_inotify_descriptor < 0 || pipe2(m_stop_pipe, O_CLOEXEC) != 0)
+		{
+			return false;
+		}
+		AddWatches("");
+		return !m_watch_directories.empty();
+	}
+
+	void CFileWatcher::Close()
+	{
+		auto close_descriptor = [](int& descriptor) {
+			if (descriptor >= 0)
+			{
+				close(descriptor);
+				descriptor = -1;
+			}
+		};
+		close_descriptor(m_inotify_descriptor);
+		close_descriptor(m_stop_pipe[0]);
+		close_descriptor(m_stop_pipe[1]);
+		m_watch_directories.clear();
+	}
+
+	void CFileWatcher::AddWatches(const std::string& relative_directory)
+	{
+		const std::string directory = m_root_directory + relative_directory;
+		const int watch = inotify_add_watch(m_inotify_descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (watch < 0)
+		{
+			return;
+		}
+		m_watch_directories[watch] = relative_directory;
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+		{
+			if (entry.is_directory(error))
+			{
+				AddWatches(relative_directory + entry.path().filename().string() + '/');
+			}
+		}
+	}
+
+	void CFileWatcher::WatchLoop()
+	{
+		alignas(inotify_event) static thread_local char buffer[64 * 1024];
+		for (;;)
+		{
+			pollfd descriptors[] = { { m_inotify_descriptor, POLLIN, 0 }, { m_stop_pipe[0], POLLIN, 0 } };
+			if (poll(descriptors, 2, -1) < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				break;
+			}
+			if (descriptors[1].revents != 0)
+			{
+				break;
+			}
+			const ssize_t length = read(m_inotify_descriptor, buffer, sizeof(buffer));
+			if (length < 0)
+			{
+				if (errno == EINTR || errno == EAGAIN)
+				{
+					continue;
+				}
+				break;
+			}
+			for (const char* cursor = buffer; cursor < buffer + length;)
+			{
+				const auto* event = reinterpret_cast<const inotify_event*>(cursor);
+				cursor += sizeof(inotify_event) + event->len;
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					printf("[warning]:file watcher overflowed, some changes were missed\n");
+					continue;
+				}
+				auto directory = m_watch_directories.find(event->wd);
+				if (event->len == 0 || directory == m_watch_directories.end())
+				{
+					continue;
+				}
+				std::string path = directory->second + event->name;
+				if (event->mask & IN_ISDIR)
+				{
+					if (event->mask & (IN_CREATE | IN_MOVED_TO))
+					{
+						AddWatches(path + '/');
+					}
+					continue;
+				}
+				if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+				{
+					AddChange(std::move(path));
+				}
+			}
+		}
+	}
+#endif
+}
@@ -0,0 +1,132 @@
+﻿#include "Core/float_table_reader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FIRE_ENGINE_FLOAT_TABLE_SSE2 1
+#include <emmintrin.h>
+#else
+#define FIRE_ENGINE_FLOAT_TABLE_SSE2 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace FireEngine
+{
+	namespace
+	{
+		constexpr uint64_t c_block_size = 64;
+
+		inline uint32_t CountTrailingZeros(uint64_t value)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward64(&index, value);
+			return static_cast<uint32_t>(index);
+#else
+			return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+		}
+
+		// 64字节中每个空白字符(空格/制表/回车/换行)对应一位
+		inline uint64_t WhitespaceMask(const char* block)
+		{
+#if FIRE_ENGINE_FLOAT_TABLE_SSE2
+			const __m128i space = _mm_set1_epi8(' ');
+			const __m128i tab = _mm_set1_epi8('\t');
+			const __m128i carriage_return = _mm_set1_epi8('\r');
+			const __m128i new_line = _mm_set1_epi8('\n');
+			uint64_t mask = 0;
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+				__m128i is_blank = _mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab));
+				is_blank = _mm_or_si128(is_blank, _mm_cmpeq_epi8(bytes, carriage_return));
+				is_blank = _mm_or_si128(is_blank, _mm_cmpeq_epi8(bytes, new_line));
+				mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(is_blank))) << (i * 16);
+			}
+			return mask;
+#else
+			uint64_t mask = 0;
+			for (uint32_t i = 0; i < c_block_size; ++i)
+			{
+				const char c = block[i];
+				if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+				{
+					mask |= 1ull << i;
+				}
+			}
+			return mask;
+#endif
+		}
+	}
+
+	uint64_t ReadFloatTable(const char* begin, const char* end, uint32_t column_count, std::vector<float>& out_values, uint64_t max_row_count)
+	{
+		if (column_count == 0 || begin >= end)
+		{
+			return 0;
+		}
+
+		const uint64_t first_value = out_values.size();
+		const uint64_t max_value_count = max_row_count > UINT64_MAX / column_count ? UINT64_MAX : max_row_count * column_count;
+		if (max_row_count != UINT64_MAX)
+		{
+			// 行数通常来自文件头, 不可信; 每个数至少占一个字符加一个分隔符, 预留量不超过输入能放下的个数
+			const uint64_t input_value_limit = (static_cast<uint64_t>(end - begin) + 1) / 2;
+			out_values.reserve(first_value + std::min(max_value_count, input_value_limit));
+		}
+
+		uint64_t value_count = 0;
+		uint64_t previous_blank = 1;
+		bool     stop = false;
+		char     tail_block[c_block_size];
+		for (const char* block = begin; block < end && !stop; block += c_block_size)
+		{
+			const char* scan = block;
+			if (static_cast<uint64_t>(end - block) < c_block_size)
+			{
+				// 最后不足64字节的部分用空格补齐
+				memset(tail_block, ' ', c_block_size);
+				memcpy(tail_block, block, end - block);
+				scan = tail_block;
+			}
+
+			const uint64_t blank = WhitespaceMask(scan);
+			uint64_t token_starts = ~blank & ((blank << 1) | previous_blank);
+			previous_blank = blank >> 63;
+
+			while (token_starts)
+			{
+				const char* token = block + CountTrailingZeros(token_starts);
+				token_starts &= token_starts - 1;
+				if (*token == '+')
+				{
+					++token;
+				}
+
+				float value;
+				const auto result = std::from_chars(token, end, value);
+				if (result.ec != std::errc())
+				{
+					stop = true;
+					break;
+				}
+				out_values.emplace_back(value);
+				if (++value_count == max_value_count)
+				{
+					stop = true;
+					break;
+				}
+			}
+		}
+
+		const uint64_t row_count = value_count / column_count;
+		out_values.resize(first_value + row_count * column_count);
+		return row_count;
+	}
+}
@@ -0,0 +1,591 @@
+﻿#include "Core/inflate.h"
+
+#include <cstring>
+#include <mutex>
+
+namespace FireEngine
+{
+	namespace
+	{
+		constexpr uint32_t c_max_code_bits = 15;
+		constexpr uint32_t c_litlen_table_bits = 11;
+		constexpr uint32_t c_distance_table_bits = 9;
+		constexpr uint32_t c_litlen_symbols = 288;
+		constexpr uint32_t c_distance_symbols = 32;
+
+		constexpr uint16_t c_length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		constexpr uint8_t  c_length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		constexpr uint16_t c_distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		constexpr uint8_t  c_distance_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+		constexpr uint8_t  c_code_length_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+		// 查表项: 低5位为消耗的位数, 5~7位为类型
+		// 字面量: 第8位表示一次输出两个字节, 16~23/24~31位为字面量
+		// 长度/距离: 8~15位为额外位数, 16~31位为基数
+		enum EEntryType : uint32_t
+		{
+			Literal = 0,
+			Length = 1,
+			EndOfBlock = 2,
+			SlowPath = 3,
+			Invalid = 4,
+		};
+
+		inline uint32_t MakeEntry(uint32_t bits, EEntryType type, uint32_t payload) { return bits | (type << 5) | payload; }
+		inline uint32_t EntryBits(uint32_t entry) { return entry & 31; }
+		inline uint32_t EntryType(uint32_t entry) { return (entry >> 5) & 7; }
+
+		inline uint32_t ReverseBits(uint32_t code, uint32_t length)
+		{
+			uint32_t reversed = 0;
+			for (uint32_t i = 0; i < length; ++i, code >>= 1)
+			{
+				reversed = (reversed << 1) | (code & 1);
+			}
+			return reversed;
+		}
+
+		template <uint32_t TableBits, uint32_t SymbolCount>
+		struct SHuffmanTable
+		{
+			uint32_t entries[1u << TableBits];
+			// 超过 TableBits 位的码字按规范哈夫曼逐位解码
+			uint16_t counts[c_max_code_bits + 1];
+			uint16_t symbols[SymbolCount];
+
+			// symbol_entry 把符号转成查表项的负载部分
+			template <typename FSymbolEntry>
+			bool Build(const uint8_t* lengths, uint32_t symbol_count, FSymbolEntry&& symbol_entry)
+			{
+				memset(counts, 0, sizeof(counts));
+				for (uint32_t i = 0; i < symbol_count; ++i)
+				{
+					++counts[lengths[i]];
+				}
+				counts[0] = 0;
+
+				// 超额订阅的码表非法, 不完整的码表只允许出现在只有一个码字的情况
+				int32_t left = 1;
+				for (uint32_t length = 1; length <= c_max_code_bits; ++length)
+				{
+					left = (left << 1) - counts[length];
+					if (left < 0)
+					{
+						return false;
+					}
+				}
+
+				uint16_t offsets[c_max_code_bits + 2];
+				uint32_t next_code[c_max_code_bits + 2];
+				offsets[1] = 0;
+				next_code[1] = 0;
+				for (uint32_t length = 1; length <= c_max_code_bits; ++length)
+				{
+					offsets[length + 1] = static_cast<uint16_t>(offsets[length] + counts[length]);
+					next_code[length + 1] = (next_code[length] + counts[length]) << 1;
+				}
+
+				for (uint32_t& entry : entries)
+				{
+					entry = MakeEntry(0, Invalid, 0);
+				}
+				bool has_long_codes = false;
+				for (uint32_t symbol = 0; symbol < symbol_count; ++symbol)
+				{
+					const uint32_t length = lengths[symbol];
+					if (length == 0)
+					{
+						continue;
+					}
+					symbols[offsets[length]++] = static_cast<uint16_t>(symbol);
+					const uint32_t code = ReverseBits(next_code[length]++, length);
+					if (length > TableBits)
+					{
+						has_long_codes = true;
+						continue;
+					}
+					const uint32_t entry = symbol_entry(symbol, length);
+					for (uint32_t index = code; index < (1u << TableBits); index += 1u << length)
+					{
+						entries[index] = entry;
+					}
+				}
+				if (has_long_codes)
+				{
+					// 长码字的前缀位置改为走慢路径
+					for (uint32_t index = 0; index < (1u << TableBits); ++index)
+					{
+						if (EntryType(entries[index]) == Invalid)
+						{
+							entries[index] = MakeEntry(0, SlowPath, 0);
+						}
+					}
+				}
+				return true;
+			}
+
+			// 规范哈夫曼逐位解码, 返回符号, 失败返回 -1
+			int32_t DecodeSlow(uint64_t bits, uint32_t& consumed) const
+			{
+				int32_t code = 0;
+				int32_t first = 0;
+				int32_t index = 0;
+				for (uint32_t length = 1; length <= c_max_code_bits; ++length)
+				{
+					code |= static_cast<int32_t>(bits & 1);
+					bits >>= 1;
+					const int32_t count = counts[length];
+					if (code - count < first)
+					{
+						consumed = length;
+						return symbols[index + (code - first)];
+					}
+					index += count;
+					first = (first + count) << 1;
+					code <<= 1;
+				}
+				return -1;
+			}
+		};
+
+		using FLitLenTable = SHuffmanTable<c_litlen_table_bits, c_litlen_symbols>;
+		using FDistanceTable = SHuffmanTable<c_distance_table_bits, c_distance_symbols>;
+
+		uint32_t LitLenPayload(uint32_t symbol, uint32_t length)
+		{
+			if (symbol < 256)
+			{
+				return MakeEntry(length, Literal, symbol << 16);
+			}
+			if (symbol == 256)
+			{
+				return MakeEntry(length, EndOfBlock, 0);
+			}
+			if (symbol - 257 >= 29)
+			{
+				return MakeEntry(length, Invalid, 0);
+			}
+			return MakeEntry(length, Length, (c_length_extra[symbol - 257] << 8) | (static_cast<uint32_t>(c_length_base[symbol - 257]) << 16));
+		}
+
+		uint32_t DistancePayload(uint32_t symbol, uint32_t length)
+		{
+			if (symbol >= 30)
+			{
+				return MakeEntry(length, Invalid, 0);
+			}
+			return MakeEntry(length, Length, (c_distance_extra[symbol] << 8) | (static_cast<uint32_t>(c_distance_base[symbol]) << 16));
+		}
+
+		bool BuildLitLenTable(FLitLenTable& table, const uint8_t* lengths, uint32_t symbol_count)
+		{
+			if (!table.Build(lengths, symbol_count, LitLenPayload))
+			{
+				return false;
+			}
+			// 查表的位数里能再放下一个字面量时, 合并成一次输出两个字节的表项
+			uint32_t single[1u << c_litlen_table_bits];
+			memcpy(single, table.entries, sizeof(single));
+			for (uint32_t index = 0; index < (1u << c_litlen_table_bits); ++index)
+			{
+				const uint32_t first = single[index];
+				const uint32_t first_bits = EntryBits(first);
+				if (EntryType(first) != Literal)
+				{
+					continue;
+				}
+				const uint32_t second = single[index >> first_bits];
+				const uint32_t second_bits = EntryBits(second);
+				if (EntryType(second) != Literal || first_bits + second_bits > c_litlen_table_bits)
+				{
+					continue;
+				}
+				table.entries[index] = MakeEntry(first_bits + second_bits, Literal, (1u << 8) | (first & 0x00FF0000u) | ((second & 0x00FF0000u) << 8));
+			}
+			return true;
+		}
+
+		struct SFixedTables
+		{
+			FLitLenTable   litlen;
+			FDistanceTable distance;
+		};
+
+		const SFixedTables& GetFixedTables()
+		{
+			static SFixedTables tables;
+			static std::once_flag once;
+			std::call_once(once, []() {
+				uint8_t lengths[c_litlen_symbols];
+				memset(lengths, 8, 144);
+				memset(lengths + 144, 9, 112);
+				memset(lengths + 256, 7, 24);
+				memset(lengths + 280, 8, 8);
+				BuildLitLenTable(tables.litlen, lengths, c_litlen_symbols);
+				memset(lengths, 5, c_distance_symbols);
+				tables.distance.Build(lengths, c_distance_symbols, DistancePayload);
+			});
+			return tables;
+		}
+
+		class CInflater
+		{
+		public:
+			CInflater(const SByteView& input, uint8_t* out, uint64_t out_capacity)
+				: m_in(input.data), m_in_end(input.data + input.size), m_out_begin(out), m_out(out), m_out_end(out + out_capacity) {}
+
+			bool Run()
+			{
+				bool is_final = false;
+				while (!is_final)
+				{
+					Refill();
+					is_final = Bits(1) != 0;
+					const uint32_t block_type = static_cast<uint32_t>(Bits(3) >> 1);
+					Consume(3);
+					bool ok = false;
+					switch (block_type)
+					{
+					case 0:
+						ok = StoredBlock();
+						break;
+					case 1:
+					{
+						const SFixedTables& fixed = GetFixedTables();
+						ok = HuffmanBlock(fixed.litlen, fixed.distance);
+						break;
+					}
+					case 2:
+						ok = DynamicBlock();
+						break;
+					default:
+						break;
+					}
+					if (!ok || IsOverrun())
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+
+			uint64_t GetOutputSize() const { return static_cast<uint64_t>(m_out - m_out_begin); }
+
+		private:
+			// 保证缓冲里至少有56位, 剩余数据不足8字节时逐字节读, 读完后补零
+			inline void Refill()
+			{
+				if (m_in_end - m_in >= 8)
+				{
+					uint64_t word;
+					memcpy(&word, m_in, sizeof(word));
+					m_bit_buffer |= word << m_bit_count;
+					const uint32_t bytes = (63 - m_bit_count) >> 3;
+					m_in += bytes;
+					m_bit_count += bytes << 3;
+					return;
+				}
+				m_bit_buffer &= m_bit_count ? (~0ull >> (64 - m_bit_count)) : 0;
+				while (m_bit_count < 56)
+				{
+					uint64_t byte = 0;
+					if (m_in < m_in_end)
+					{
+						byte = *m_in++;
+					}
+					else
+					{
+						++m_padding_bytes;
+					}
+					m_bit_buffer |= byte << m_bit_count;
+					m_bit_count += 8;
+				}
+			}
+
+			inline uint64_t Bits(uint32_t count) const { return m_bit_buffer & ((1ull << count) - 1); }
+			inline void Consume(uint32_t count)
+			{
+				m_bit_buffer >>= count;
+				m_bit_count -= count;
+			}
+			inline uint32_t Read(uint32_t count)
+			{
+				const uint32_t value = static_cast<uint32_t>(Bits(count));
+				Consume(count);
+				return value;
+			}
+
+			// 读到了补进来的零字节, 说明输入被截断
+			bool IsOverrun() const { return m_padding_bytes * 8 > m_bit_count; }
+
+			bool StoredBlock()
+			{
+				// 丢掉到字节边界的位, 把缓冲里剩余的整字节退回输入
+				Consume(m_bit_count & 7);
+				const uint32_t buffered = m_bit_count >> 3;
+				if (buffered < m_padding_bytes)
+				{
+					return false;
+				}
+				m_in -= buffered - m_padding_bytes;
+				m_bit_buffer = 0;
+				m_bit_count = 0;
+				m_padding_bytes = 0;
+
+				if (m_in_end - m_in < 4)
+				{
+					return false;
+				}
+				const uint32_t length = m_in[0] | (m_in[1] << 8);
+				const uint32_t inverted = m_in[2] | (m_in[3] << 8);
+				m_in += 4;
+				if ((length ^ 0xFFFF) != inverted || static_cast<uint64_t>(m_in_end - m_in) < length || static_cast<uint64_t>(m_out_end - m_out) < length)
+				{
+					return false;
+				}
+				memcpy(m_out, m_in, length);
+				m_in += length;
+				m_out += length;
+				return true;
+			}
+
+			bool DynamicBlock()
+			{
+				Refill();
+				const uint32_t litlen_count = Read(5) + 257;
+				const uint32_t distance_count = Read(5) + 1;
+				const uint32_t code_length_count = Read(4) + 4;
+				if (litlen_count > 286 || distance_count > 30)
+				{
+					return false;
+				}
+
+				uint8_t code_length_lengths[19] = {};
+				for (uint32_t i = 0; i < code_length_count; ++i)
+				{
+					Refill();
+					code_length_lengths[c_code_length_order[i]] = static_cast<uint8_t>(Read(3));
+				}
+				SHuffmanTable<7, 19> code_length_table;
+				if (!code_length_table.Build(code_length_lengths, 19, [](uint32_t symbol, uint32_t length) { return MakeEntry(length, Literal, symbol << 16); }))
+				{
+					return false;
+				}
+
+				uint8_t lengths[c_litlen_symbols + c_distance_symbols] = {};
+				const uint32_t total = litlen_count + distance_count;
+				for (uint32_t i = 0; i < total;)
+				{
+					Refill();
+					const uint32_t entry = code_length_table.entries[Bits(7)];
+					if (EntryType(entry) != Literal)
+					{
+						return false;
+					}
+					Consume(EntryBits(entry));
+					const uint32_t symbol = entry >> 16;
+					if (symbol < 16)
+					{
+						lengths[i++] = static_cast<uint8_t>(symbol);
+						continue;
+					}
+					uint32_t repeat = 0;
+					uint8_t  value = 0;
+					if (symbol == 16)
+					{
+						if (i == 0)
+						{
+							return false;
+						}
+						value = lengths[i - 1];
+						repeat = 3 + Read(2);
+					}
+					else if (symbol == 17)
+					{
+						repeat = 3 + Read(3);
+					}
+					else
+					{
+						repeat = 11 + Read(7);
+					}
+					if (i + repeat > total)
+					{
+						return false;
+					}
+					memset(lengths + i, value, repeat);
+					i += repeat;
+				}
+				if (lengths[256] == 0 || IsOverrun())
+				{
+					return false;
+				}
+
+				FLitLenTable   litlen;
+				FDistanceTable distance;
+				if (!BuildLitLenTable(litlen, lengths, litlen_count) || !distance.Build(lengths + litlen_count, distance_count, DistancePayload))
+				{
+					return false;
+				}
+				return HuffmanBlock(litlen, distance);
+			}
+
+			bool HuffmanBlock(const FLitLenTable& litlen, const FDistanceTable& distance)
+			{
+				while (true)
+				{
+					// 一次补充后的56位足够一个长度码(15+5)加一个距离码(15+13)
+					Refill();
+					uint32_t entry = litlen.entries[Bits(c_litlen_table_bits)];
+					// 输出还有余量时, 同一次补充里连续解两个字面量表项, 每项的两个字节直接写出不逐个检查边界
+					if (EntryType(entry) == Literal && m_out_end - m_out >= 4)
+					{
+						WriteLiterals(entry);
+						entry = litlen.entries[Bits(c_litlen_table_bits)];
+						if (EntryType(entry) == Literal)
+						{
+							WriteLiterals(entry);
+							continue;
+						}
+						Refill();
+					}
+					uint32_t type = EntryType(entry);
+					if (type == SlowPath)
+					{
+						uint32_t consumed = 0;
+						const int32_t symbol = litlen.DecodeSlow(m_bit_buffer, consumed);
+						if (symbol < 0)
+						{
+							return false;
+						}
+						entry = LitLenPayload(static_cast<uint32_t>(symbol), consumed);
+						type = EntryType(entry);
+					}
+					Consume(EntryBits(entry));
+
+					if (type == Literal)
+					{
+						if (entry & (1u << 8))
+						{
+							if (m_out_end - m_out < 2)
+							{
+								return false;
+							}
+							m_out[0] = static_cast<uint8_t>(entry >> 16);
+							m_out[1] = static_cast<uint8_t>(entry >> 24);
+							m_out += 2;
+						}
+						else
+						{
+							if (m_out == m_out_end)
+							{
+								return false;
+							}
+							*m_out++ = static_cast<uint8_t>(entry >> 16);
+						}
+						continue;
+					}
+					if (type == EndOfBlock)
+					{
+						return true;
+					}
+					if (type != Length)
+					{
+						return false;
+					}
+
+					const uint32_t length = (entry >> 16) + Read((entry >> 8) & 0xFF);
+					uint32_t distance_entry = distance.entries[Bits(c_distance_table_bits)];
+					if (EntryType(distance_entry) == SlowPath)
+					{
+						uint32_t consumed = 0;
+						const int32_t symbol = distance.DecodeSlow(m_bit_buffer, consumed);
+						if (symbol < 0)
+						{
+							return false;
+						}
+						distance_entry = DistancePayload(static_cast<uint32_t>(symbol), consumed);
+					}
+					if (EntryType(distance_entry) != Length)
+					{
+						return false;
+					}
+					Consume(EntryBits(distance_entry));
+					const uint32_t match_distance = (distance_entry >> 16) + Read((distance_entry >> 8) & 0xFF);
+					if (match_distance > static_cast<uint64_t>(m_out - m_out_begin) || length > static_cast<uint64_t>(m_out_end - m_out))
+					{
+						return false;
+					}
+					CopyMatch(match_distance, length);
+				}
+			}
+
+			inline void WriteLiterals(uint32_t entry)
+			{
+				m_out[0] = static_cast<uint8_t>(entry >> 16);
+				m_out[1] = static_cast<uint8_t>(entry >> 24);
+				m_out += 1 + ((entry >> 8) & 1);
+				Consume(EntryBits(entry));
+			}
+
+			inline void CopyMatch(uint32_t distance, uint32_t length)
+			{
+				const uint8_t* source = m_out - distance;
+				uint8_t*       target = m_out;
+				m_out += length;
+				if (distance >= 8 && m_out_end - m_out >= 8)
+				{
+					// 距离不小于8时按8字节块复制, 块之间不会读到本次写入的数据
+					while (target < m_out)
+					{
+						memcpy(target, source, 8);
+						target += 8;
+						source += 8;
+					}
+				}
+				else if (distance == 1)
+				{
+					memset(target, *source, length);
+				}
+				else
+				{
+					while (target < m_out)
+					{
+						*target++ = *source++;
+					}
+				}
+			}
+
+			const uint8_t* m_in;
+			const uint8_t* m_in_end;
+			uint8_t*       m_out_begin;
+			uint8_t*       m_out;
+			uint8_t*       m_out_end;
+			uint64_t       m_bit_buffer{ 0 };
+			uint32_t       m_bit_count{ 0 };
+			uint32_t       m_padding_bytes{ 0 };
+		};
+	}
+
+	bool ZlibInflate(const SByteView& compressed, uint8_t* out, uint64_t out_capacity, uint64_t& out_size)
+	{
+		out_size = 0;
+		if (compressed.size < 2)
+		{
+			return false;
+		}
+		const uint32_t method = compressed.data[0];
+		const uint32_t flags = compressed.data[1];
+		// 只支持 deflate, 不支持预设字典
+		if ((method & 15) != 8 || (method >> 4) > 7 || ((method << 8) | flags) % 31 != 0 || (flags & 32))
+		{
+			return false;
+		}
+		CInflater inflater({ compressed.data + 2, compressed.size - 2 }, out, out_capacity);
+		if (!inflater.Run())
+		{
+			return false;
+		}
+		out_size = inflater.GetOutputSize();
+		return true;
+	}
+}
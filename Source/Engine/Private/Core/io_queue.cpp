@@ -0,0 +1,634 @@
+﻿#include "Core/io_queue.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+// Windows.h 的 min/max 宏会破坏 std::min/std::max
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32) && defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define FIRE_ENGINE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#else
+#define FIRE_ENGINE_IO_URING 0
+#endif
+
+namespace FireEngine
+{
+	namespace
+	{
+		// 回退路径和 io_uring 不可用时的读取线程数
+		constexpr uint32_t c_io_fallback_thread_count = 4;
+
+		// 回退路径一次读完整个文件, 不做 O_DIRECT
+		bool ReadWholeFile(const std::string& file_name, SFileData& out_file)
+		{
+#if defined(_WIN32)
+			HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+			LARGE_INTEGER file_size{};
+			bool success = GetFileSizeEx(file, &file_size) != 0;
+			if (success)
+			{
+				out_file.buffer.resize(static_cast<size_t>(file_size.QuadPart));
+				uint64_t offset = 0;
+				while (success && offset < out_file.buffer.size())
+				{
+					const DWORD length = static_cast<DWORD>(std::min<uint64_t>(out_file.buffer.size() - offset, 1u << 30));
+					DWORD read_size = 0;
+					success = ReadFile(file, out_file.buffer.data() + offset, length, &read_size, nullptr) && read_size > 0;
+					offset += read_size;
+				}
+			}
+			CloseHandle(file);
+#else
+			const int file_descriptor = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+			if (file_descriptor < 0)
+			{
+				return false;
+			}
+			struct stat file_stat{};
+			bool success = fstat(file_descriptor, &file_stat) == 0;
+			if (success)
+			{
+				out_file.buffer.resize(static_cast<size_t>(file_stat.st_size));
+				uint64_t offset = 0;
+				while (success && offset < out_file.buffer.size())
+				{
+					const ssize_t read_size = pread(file_descriptor, out_file.buffer.data() + offset, out_file.buffer.size() - offset, static_cast<off_t>(offset));
+					if (read_size < 0 && errno == EINTR)
+					{
+						continue;
+					}
+					success = read_size > 0;
+					offset += success ? static_cast<uint64_t>(read_size) : 0;
+				}
+			}
+			close(file_descriptor);
+#endif
+			if (!success)
+			{
+				out_file = {};
+				return false;
+			}
+			out_file.view = { out_file.buffer.data(), out_file.buffer.size() };
+			return true;
+		}
+	}
+
+#if FIRE_ENGINE_IO_URING
+	// 直接用系统调用操作 io_uring, 不依赖 liburing
+	struct CIoQueue::SRing
+	{
+		// 已经打开, 正在分块读取的文件
+		struct SActiveRead
+		{
+			SReadRequest request;
+			SFileData    data;
+			int          file_descriptor{ -1 };
+			uint64_t     size{ 0 };
+			uint64_t     next_offset{ 0 };
+			uint32_t     pending_chunks{ 0 };
+			bool         direct{ false };
+			bool         failed{ false };
+		};
+
+		// 一次读取中的一块, 下标就是 SQE 的 user_data
+		struct SChunk
+		{
+			SActiveRead*        read{ nullptr };
+			uint64_t            offset{ 0 };
+			uint32_t            length{ 0 };
+			int32_t             staging{ -1 };
+			iovec               io_vector{};
+		};
+
+		~SRing();
+		bool Open(uint32_t queue_depth);
+
+		io_uring_sqe* GetSqe();
+		// 把 GetSqe 拿到的项交给内核, 同时至少等待 wait_count 个完成
+		bool Enter(uint32_t wait_count);
+		// 取出一个完成项, 没有时返回 false
+		bool PopCqe(uint64_t& out_user_data, int32_t& out_result);
+
+		int       ring_descriptor{ -1 };
+		void*     sq_ring{ nullptr };
+		size_t    sq_ring_size{ 0 };
+		void*     cq_ring{ nullptr };
+		size_t    cq_ring_size{ 0 };
+		io_uring_sqe* sqes{ nullptr };
+		size_t    sqes_size{ 0 };
+		uint32_t* sq_head{ nullptr };
+		uint32_t* sq_tail{ nullptr };
+		uint32_t* sq_array{ nullptr };
+		uint32_t  sq_mask{ 0 };
+		uint32_t* cq_head{ nullptr };
+		uint32_t* cq_tail{ nullptr };
+		io_uring_cqe* cqes{ nullptr };
+		uint32_t  cq_mask{ 0 };
+		uint32_t  to_submit{ 0 };
+
+		std::vector<SChunk>   chunks;
+		std::vector<uint32_t> free_chunks;
+		// O_DIRECT 要求缓冲和偏移都对齐, 注册失败(比如 RLIMIT_MEMLOCK 太小)时照样使用, 只是不走 READ_FIXED
+		std::vector<uint8_t*> staging_buffers;
+		std::vector<int32_t>  free_staging;
+		bool                  staging_registered{ false };
+		// io_uring_enter 出错后内核仍可能写入已经提交的块, 这些文件的缓冲留到关闭环之后再释放
+		std::vector<std::vector<uint8_t>> abandoned_buffers;
+	};
+
+	CIoQueue::SRing::~SRing()
+	{
+		if (sqes)
+		{
+			munmap(sqes, sqes_size);
+		}
+		if (cq_ring && cq_ring != sq_ring)
+		{
+			munmap(cq_ring, cq_ring_size);
+		}
+		if (sq_ring)
+		{
+			munmap(sq_ring, sq_ring_size);
+		}
+		if (ring_descriptor >= 0)
+		{
+			close(ring_descriptor);
+		}
+		for (uint8_t* buffer : staging_buffers)
+		{
+			free(buffer);
+		}
+	}
+
+	bool CIoQueue::SRing::Open(uint32_t queue_depth)
+	{
+		io_uring_params params{};
+		const long result = syscall(__NR_io_uring_setup, queue_depth, &params);
+		if (result < 0)
+		{
+			return false;
+		}
+		ring_descriptor = static_cast<int>(result);
+
+		sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		// 新内核的 SQ 和 CQ 环在同一次映射里
+		const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (single_mmap)
+		{
+			sq_ring_size = std::max(sq_ring_size, cq_ring_size);
+		}
+		sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_descriptor, IORING_OFF_SQ_RING);
+		if (sq_ring == MAP_FAILED)
+		{
+			sq_ring = nullptr;
+			return false;
+		}
+		if (single_mmap)
+		{
+			cq_ring = sq_ring;
+		}
+		else
+		{
+			cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_descriptor, IORING_OFF_CQ_RING);
+			if (cq_ring == MAP_FAILED)
+			{
+				cq_ring = nullptr;
+				return false;
+			}
+		}
+		sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+		void* sqe_memory = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_descriptor, IORING_OFF_SQES);
+		if (sqe_memory == MAP_FAILED)
+		{
+			return false;
+		}
+		sqes = static_cast<io_uring_sqe*>(sqe_memory);
+
+		uint8_t* sq_base = static_cast<uint8_t*>(sq_ring);
+		uint8_t* cq_base = static_cast<uint8_t*>(cq_ring);
+		sq_head = reinterpret_cast<uint32_t*>(sq_base + params.sq_off.head);
+		sq_tail = reinterpret_cast<uint32_t*>(sq_base + params.sq_off.tail);
+		sq_array = reinterpret_cast<uint32_t*>(sq_base + params.sq_off.array);
+		sq_mask = *reinterpret_cast<uint32_t*>(sq_base + params.sq_off.ring_mask);
+		cq_head = reinterpret_cast<uint32_t*>(cq_base + params.cq_off.head);
+		cq_tail = reinterpret_cast<uint32_t*>(cq_base + params.cq_off.tail);
+		cqes = reinterpret_cast<io_uring_cqe*>(cq_base + params.cq_off.cqes);
+		cq_mask = *reinterpret_cast<uint32_t*>(cq_base + params.cq_off.ring_mask);
+
+		// 在途的块不超过 SQ 的大小, CQ 至少是它的两倍, 不会溢出
+		const uint32_t chunk_count = std::min(queue_depth, params.sq_entries);
+		chunks.resize(chunk_count);
+		for (uint32_t i = chunk_count; i > 0; --i)
+		{
+			free_chunks.push_back(i - 1);
+		}
+
+		// 直接读取的块数占队列深度的四分之一, 其余留给走页缓存的小文件
+		const uint32_t staging_count = std::max(1u, chunk_count / 4);
+		std::vector<iovec> staging_vectors;
+		for (uint32_t i = 0; i < staging_count; ++i)
+		{
+			void* buffer = nullptr;
+			if (posix_memalign(&buffer, 4096, c_io_chunk_size) != 0)
+			{
+				break;
+			}
+			staging_buffers.push_back(static_cast<uint8_t*>(buffer));
+			staging_vectors.push_back({ buffer, c_io_chunk_size });
+		}
+		for (uint32_t i = static_cast<uint32_t>(staging_buffers.size()); i > 0; --i)
+		{
+			free_staging.push_back(static_cast<int32_t>(i - 1));
+		}
+		staging_registered = !staging_vectors.empty()
+			&& syscall(__NR_io_uring_register, ring_descriptor, IORING_REGISTER_BUFFERS, staging_vectors.data(), static_cast<unsigned>(staging_vectors.size())) == 0;
+		return true;
+	}
+
+	io_uring_sqe* CIoQueue::SRing::GetSqe()
+	{
+		const uint32_t tail = *sq_tail + to_submit;
+		const uint32_t index = tail & sq_mask;
+		io_uring_sqe* sqe = &sqes[index];
+		memset(sqe, 0, sizeof(io_uring_sqe));
+		sq_array[index] = index;
+		++to_submit;
+		return sqe;
+	}
+
+	bool CIoQueue::SRing::Enter(uint32_t wait_count)
+	{
+		// 内核读取 tail 之前必须看到写好的 SQE
+		__atomic_store_n(sq_tail, *sq_tail + to_submit, __ATOMIC_RELEASE);
+		uint32_t submit_count = to_submit;
+		to_submit = 0;
+		while (submit_count > 0 || wait_count > 0)
+		{
+			const long result = syscall(__NR_io_uring_enter, ring_descriptor, submit_count, wait_count, wait_count > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+			if (result < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return false;
+			}
+			submit_count -= std::min<uint32_t>(submit_count, static_cast<uint32_t>(result));
+			wait_count = 0;
+		}
+		return true;
+	}
+
+	bool CIoQueue::SRing::PopCqe(uint64_t& out_user_data, int32_t& out_result)
+	{
+		const uint32_t head = *cq_head;
+		if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+		{
+			return false;
+		}
+		const io_uring_cqe& cqe = cqes[head & cq_mask];
+		out_user_data = cqe.user_data;
+		out_result = cqe.res;
+		__atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+		return true;
+	}
+#else
+	struct CIoQueue::SRing
+	{
+	};
+#endif
+
+	CIoQueue::CIoQueue(uint32_t queue_depth) : m_queue_depth(std::max(queue_depth, 1u))
+	{
+#if FIRE_ENGINE_IO_URING
+		auto ring = std::make_unique<SRing>();
+		if (ring->Open(m_queue_depth))
+		{
+			m_ring = std::move(ring);
+			m_threads.emplace_back([this]() { RingLoop(); });
+			return;
+		}
+		printf("[warning]:io_uring unavailable, falling back to pread threads\n");
+#endif
+		for (uint32_t i = 0; i < std::min(m_queue_depth, c_io_fallback_thread_count); ++i)
+		{
+			m_threads.emplace_back([this]() { WorkerLoop(); });
+		}
+	}
+
+	CIoQueue::~CIoQueue()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_condition.notify_all();
+		for (std::thread& thread : m_threads)
+		{
+			thread.join();
+		}
+
+		SReadRequest request;
+		while (PopRequest(request))
+		{
+			request.on_read(false, SFileData{});
+		}
+	}
+
+	void CIoQueue::Read(const std::string& file_name, EIoPriority priority, FIoReadCallback on_read, bool direct)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_requests[static_cast<uint32_t>(priority)].push_back({ file_name, std::move(on_read), direct });
+		}
+		m_condition.notify_one();
+	}
+
+	bool CIoQueue::PopRequest(SReadRequest& out_request)
+	{
+		for (std::deque<SReadRequest>& requests : m_requests)
+		{
+			if (!requests.empty())
+			{
+				out_request = std::move(requests.front());
+				requests.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool CIoQueue::HasRequests() const
+	{
+		return std::any_of(m_requests.begin(), m_requests.end(), [](const std::deque<SReadRequest>& requests) { return !requests.empty(); });
+	}
+
+	void CIoQueue::WorkerLoop()
+	{
+		while (true)
+		{
+			SReadRequest request;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this]() { return m_quit || HasRequests(); });
+				if (m_quit)
+				{
+					return;
+				}
+				PopRequest(request);
+			}
+			SFileData file_data;
+			const bool success = ReadWholeFile(request.file_name, file_data);
+			request.on_read(success, std::move(file_data));
+		}
+	}
+
+	void CIoQueue::RingLoop()
+	{
+#if FIRE_ENGINE_IO_URING
+		using SChunk = SRing::SChunk;
+		using SActiveRead = SRing::SActiveRead;
+		SRing& ring = *m_ring;
+		std::vector<std::unique_ptr<SActiveRead>> active_reads;
+		// 读短了需要接着读的块, 优先于新块提交
+		std::vector<uint32_t> retry_chunks;
+		uint32_t in_flight = 0;
+
+		auto finish_read = [](std::unique_ptr<SActiveRead>& read) {
+			if (read->file_descriptor >= 0)
+			{
+				close(read->file_descriptor);
+			}
+			if (read->failed)
+			{
+				read->data = {};
+			}
+			else
+			{
+				read->data.view = { read->data.buffer.data(), read->size };
+			}
+			read->request.on_read(!read->failed, std::move(read->data));
+			read.reset();
+		};
+
+		auto prepare_chunk = [&ring](uint32_t chunk_index) {
+			SChunk& chunk = ring.chunks[chunk_index];
+			io_uring_sqe* sqe = ring.GetSqe();
+			sqe->fd = chunk.read->file_descriptor;
+			sqe->off = chunk.offset;
+			sqe->user_data = chunk_index;
+			if (chunk.staging >= 0)
+			{
+				// O_DIRECT 的长度也要对齐, 读到文件尾时内核返回实际长度
+				const uint32_t aligned_length = (chunk.length + 4095u) & ~4095u;
+				uint8_t* staging = ring.staging_buffers[chunk.staging];
+				chunk.io_vector = { staging, aligned_length };
+				if (ring.staging_registered)
+				{
+					sqe->opcode = IORING_OP_READ_FIXED;
+					sqe->addr = reinterpret_cast<uint64_t>(staging);
+					sqe->len = aligned_length;
+					sqe->buf_index = static_cast<uint16_t>(chunk.staging);
+					return;
+				}
+			}
+			else
+			{
+				chunk.io_vector = { chunk.read->data.buffer.data() + chunk.offset, chunk.length };
+			}
+			sqe->opcode = IORING_OP_READV;
+			sqe->addr = reinterpret_cast<uint64_t>(&chunk.io_vector);
+			sqe->len = 1;
+		};
+
+		while (true)
+		{
+			// 按优先级打开新文件, 同时打开的文件数也限制在队列深度以内
+			bool quit = false;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				if (in_flight == 0 && retry_chunks.empty() && active_reads.empty())
+				{
+					m_condition.wait(lock, [this]() { return m_quit || HasRequests(); });
+				}
+				quit = m_quit;
+				SReadRequest request;
+				while (!quit && active_reads.size() < m_queue_depth && PopRequest(request))
+				{
+					auto read = std::make_unique<SActiveRead>();
+					read->request = std::move(request);
+					active_reads.emplace_back(std::move(read));
+				}
+			}
+			if (quit && in_flight == 0)
+			{
+				for (std::unique_ptr<SActiveRead>& read : active_reads)
+				{
+					read->failed = true;
+					finish_read(read);
+				}
+				return;
+			}
+
+			for (std::unique_ptr<SActiveRead>& read : active_reads)
+			{
+				if (read->file_descriptor >= 0 || read->failed)
+				{
+					continue;
+				}
+				read->file_descriptor = open(read->request.file_name.c_str(), O_RDONLY | O_CLOEXEC);
+				struct stat file_stat{};
+				if (read->file_descriptor < 0 || fstat(read->file_descriptor, &file_stat) != 0)
+				{
+					read->failed = true;
+					continue;
+				}
+				read->size = static_cast<uint64_t>(file_stat.st_size);
+				read->data.buffer.resize(static_cast<size_t>(read->size));
+				// 不支持 O_DIRECT 的文件系统(比如 tmpfs)上 fcntl 会失败, 继续走页缓存
+				if (read->request.direct && read->size >= c_direct_io_min_size && !ring.staging_buffers.empty())
+				{
+					const int flags = fcntl(read->file_descriptor, F_GETFL);
+					read->direct = flags >= 0 && fcntl(read->file_descriptor, F_SETFL, flags | O_DIRECT) == 0;
+				}
+			}
+
+			// 先补读短了的块, 再按打开顺序给每个文件切新块
+			for (uint32_t chunk_index : retry_chunks)
+			{
+				prepare_chunk(chunk_index);
+				++in_flight;
+			}
+			retry_chunks.clear();
+			for (std::unique_ptr<SActiveRead>& read : active_reads)
+			{
+				while (!read->failed && read->file_descriptor >= 0 && read->next_offset < read->size && !ring.free_chunks.empty())
+				{
+					if (read->direct && ring.free_staging.empty())
+					{
+						break;
+					}
+					const uint32_t chunk_index = ring.free_chunks.back();
+					ring.free_chunks.pop_back();
+					SChunk& chunk = ring.chunks[chunk_index];
+					chunk.read = read.get();
+					chunk.offset = read->next_offset;
+					chunk.length = static_cast<uint32_t>(std::min<uint64_t>(c_io_chunk_size, read->size - read->next_offset));
+					chunk.staging = -1;
+					if (read->direct)
+					{
+						chunk.staging = ring.free_staging.back();
+						ring.free_staging.pop_back();
+					}
+					read->next_offset += chunk.length;
+					++read->pending_chunks;
+					prepare_chunk(chunk_index);
+					++in_flight;
+				}
+			}
+
+			// 打开失败, 空文件和已经读完的文件在这里完成
+			for (std::unique_ptr<SActiveRead>& read : active_reads)
+			{
+				if (read->pending_chunks == 0 && (read->failed || read->next_offset >= read->size))
+				{
+					finish_read(read);
+				}
+			}
+			active_reads.erase(std::remove(active_reads.begin(), active_reads.end(), nullptr), active_reads.end());
+
+			// 一次系统调用提交这一批并等待至少一个完成, 新请求要等到下一个完成才会被打开
+			if (in_flight == 0)
+			{
+				continue;
+			}
+			if (!ring.Enter(1))
+			{
+				// 环已经不能用了, 再等也收不到完成项: 正在读的文件放回队列最前面, 连同之后的请求都交给 pread 线程
+				printf("[error]:io_uring_enter failed, errno %d, falling back to pread threads\n", errno);
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					for (auto it = active_reads.rbegin(); it != active_reads.rend(); ++it)
+					{
+						SActiveRead& read = **it;
+						if (read.file_descriptor >= 0)
+						{
+							close(read.file_descriptor);
+						}
+						ring.abandoned_buffers.emplace_back(std::move(read.data.buffer));
+						m_requests[static_cast<uint32_t>(EIoPriority::High)].push_front(std::move(read.request));
+					}
+					// 析构函数设置 m_quit 之后才会遍历 m_threads, 这里加线程不会和它冲突
+					for (uint32_t i = 1; !m_quit && i < std::min(m_queue_depth, c_io_fallback_thread_count); ++i)
+					{
+						m_threads.emplace_back([this]() { WorkerLoop(); });
+					}
+				}
+				m_condition.notify_all();
+				WorkerLoop();
+				return;
+			}
+			uint64_t user_data = 0;
+			int32_t  result = 0;
+			while (ring.PopCqe(user_data, result))
+			{
+				--in_flight;
+				const uint32_t chunk_index = static_cast<uint32_t>(user_data);
+				SChunk& chunk = ring.chunks[chunk_index];
+				SActiveRead& read = *chunk.read;
+				if (result == -EAGAIN || result == -EINTR)
+				{
+					retry_chunks.push_back(chunk_index);
+					continue;
+				}
+				const uint32_t read_size = result > 0 ? std::min(static_cast<uint32_t>(result), chunk.length) : 0;
+				if (chunk.staging >= 0 && read_size > 0)
+				{
+					memcpy(read.data.buffer.data() + chunk.offset, chunk.io_vector.iov_base, read_size);
+				}
+				// 读到0字节说明文件被截短了, 直接读取时中途的短读必须还是对齐的
+				const bool short_read = read_size > 0 && read_size < chunk.length;
+				if (result <= 0 || (short_read && chunk.staging >= 0 && read_size % 4096 != 0))
+				{
+					read.failed = true;
+				}
+				else if (short_read)
+				{
+					chunk.offset += read_size;
+					chunk.length -= read_size;
+					retry_chunks.push_back(chunk_index);
+					continue;
+				}
+				if (chunk.staging >= 0)
+				{
+					ring.free_staging.push_back(chunk.staging);
+				}
+				chunk.read = nullptr;
+				ring.free_chunks.push_back(chunk_index);
+				--read.pending_chunks;
+			}
+		}
+#endif
+	}
+}
@@ -0,0 +1,116 @@
+﻿#include "Core/job_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace FireEngine
+{
+	CJobSystem::CJobSystem(uint32_t worker_count)
+	{
+		if (worker_count == 0)
+		{
+			const uint32_t hardware_threads = std::thread::hardware_concurrency();
+			worker_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+		}
+		m_workers.reserve(worker_count);
+		for (uint32_t i = 0; i < worker_count; ++i)
+		{
+			m_workers.emplace_back([this]() { WorkerLoop(); });
+		}
+	}
+
+	CJobSystem::~CJobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_condition.notify_all();
+		for (std::thread& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	void CJobSystem::Submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.emplace_back(std::move(job));
+		}
+		m_condition.notify_one();
+	}
+
+	void CJobSystem::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& job)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+		if (count == 1 || m_workers.empty())
+		{
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				job(i);
+			}
+			return;
+		}
+
+		struct SParallelForState
+		{
+			std::atomic<uint32_t>   next{ 0 };
+			std::atomic<uint32_t>   finished{ 0 };
+			uint32_t                count{ 0 };
+			const std::function<void(uint32_t)>* job{ nullptr };
+			std::mutex              mutex;
+			std::condition_variable condition;
+		};
+		auto state = std::make_shared<SParallelForState>();
+		state->count = count;
+		state->job = &job;
+
+		// 帮手任务可能在ParallelFor返回后才被调度, 此时已经取不到下标, 不会再访问job
+		auto run = [](SParallelForState& s) {
+			uint32_t index;
+			while ((index = s.next.fetch_add(1)) < s.count)
+			{
+				(*s.job)(index);
+				if (s.finished.fetch_add(1) + 1 == s.count)
+				{
+					std::lock_guard<std::mutex> lock(s.mutex);
+					s.condition.notify_all();
+				}
+			}
+		};
+
+		const uint32_t helper_count = std::min(count - 1, GetWorkerCount());
+		for (uint32_t i = 0; i < helper_count; ++i)
+		{
+			Submit([state, run]() { run(*state); });
+		}
+		run(*state);
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->condition.wait(lock, [&state]() { return state->finished.load() == state->count; });
+	}
+
+	void CJobSystem::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this]() { return m_quit || !m_jobs.empty(); });
+				if (m_quit && m_jobs.empty())
+				{
+					return;
+				}
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+			}
+			job();
+		}
+	}
+}
@@ -0,0 +1,347 @@
+﻿#include "Core/lz_codec.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FIRE_ENGINE_LZ_SSE2 1
+#include <emmintrin.h>
+#else
+#define FIRE_ENGINE_LZ_SSE2 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace FireEngine
+{
+	namespace
+	{
+		constexpr uint32_t c_min_match = 4;
+		constexpr uint32_t c_last_literals = 5;
+		// 最后一个匹配必须在结尾12字节之前开始, 解码端因此可以放心地按8/16字节整块拷贝
+		constexpr uint32_t c_match_find_limit = 12;
+		constexpr uint32_t c_max_offset = 65535;
+		constexpr uint32_t c_hash_bits = 14;
+		// 连续找不到匹配时步长逐渐变大, 不可压缩的数据很快跳过
+		constexpr uint32_t c_skip_trigger = 6;
+
+		inline uint32_t CountTrailingZeros(uint64_t value)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward64(&index, value);
+			return static_cast<uint32_t>(index);
+#else
+			return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+		}
+
+		inline uint32_t Read32(const uint8_t* p)
+		{
+			uint32_t value;
+			memcpy(&value, p, sizeof(value));
+			return value;
+		}
+
+		inline uint64_t Read64(const uint8_t* p)
+		{
+			uint64_t value;
+			memcpy(&value, p, sizeof(value));
+			return value;
+		}
+
+		inline uint32_t HashSequence(uint32_t sequence)
+		{
+			return (sequence * 2654435761u) >> (32 - c_hash_bits);
+		}
+
+		inline void Copy8(uint8_t* dst, const uint8_t* src)
+		{
+			memcpy(dst, src, 8);
+		}
+
+		inline void Copy16(uint8_t* dst, const uint8_t* src)
+		{
+#if FIRE_ENGINE_LZ_SSE2
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+#else
+			memcpy(dst, src, 16);
+#endif
+		}
+
+		// 从 ip/match 开始数相同的字节, 不超过 limit
+		inline uint32_t CountMatch(const uint8_t* ip, const uint8_t* match, const uint8_t* limit)
+		{
+			const uint8_t* start = ip;
+			while (ip + 8 <= limit)
+			{
+				const uint64_t diff = Read64(ip) ^ Read64(match);
+				if (diff)
+				{
+					return static_cast<uint32_t>(ip - start) + (CountTrailingZeros(diff) >> 3);
+				}
+				ip += 8;
+				match += 8;
+			}
+			while (ip < limit && *ip == *match)
+			{
+				++ip;
+				++match;
+			}
+			return static_cast<uint32_t>(ip - start);
+		}
+
+		inline uint8_t* WriteLength(uint8_t* op, uint64_t length)
+		{
+			while (length >= 255)
+			{
+				*op++ = 255;
+				length -= 255;
+			}
+			*op++ = static_cast<uint8_t>(length);
+			return op;
+		}
+
+		inline uint8_t* WriteLiterals(uint8_t* op, const uint8_t* literals, uint64_t literal_count, uint32_t match_token)
+		{
+			uint8_t* token = op++;
+			if (literal_count >= 15)
+			{
+				*token = static_cast<uint8_t>(0xF0 | match_token);
+				op = WriteLength(op, literal_count - 15);
+			}
+			else
+			{
+				*token = static_cast<uint8_t>((literal_count << 4) | match_token);
+			}
+			if (literal_count > 0)
+			{
+				memcpy(op, literals, literal_count);
+			}
+			return op + literal_count;
+		}
+
+		// 读 token 后面的扩展长度, 输入不足时返回 false
+		inline bool ReadLength(const uint8_t*& ip, const uint8_t* iend, uint64_t& length)
+		{
+			uint8_t byte;
+			do
+			{
+				if (ip >= iend)
+				{
+					return false;
+				}
+				byte = *ip++;
+				length += byte;
+			} while (byte == 255);
+			return true;
+		}
+	}
+
+	uint64_t LzCompressBound(uint64_t size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	uint64_t LzCompress(const uint8_t* src, uint64_t size, uint8_t* dst, uint64_t dst_capacity)
+	{
+		if (size > c_lz_max_block_size || dst_capacity < LzCompressBound(size))
+		{
+			return 0;
+		}
+
+		const uint8_t* anchor = src;
+		uint8_t*       op = dst;
+		if (size >= c_match_find_limit + 1)
+		{
+			// 表中存的是相对于 src 的位置, 初始的0指向开头, 用实际字节比较过滤掉假匹配
+			uint32_t hash_table[1u << c_hash_bits] = {};
+			const uint8_t* const match_limit = src + size - c_last_literals;
+			const uint8_t* const find_limit = src + size - c_match_find_limit;
+			const uint8_t*       ip = src + 1;
+			while (ip < find_limit)
+			{
+				// 找下一个匹配
+				const uint8_t* match;
+				uint32_t       attempts = 1u << c_skip_trigger;
+				while (true)
+				{
+					const uint32_t sequence = Read32(ip);
+					uint32_t&      slot = hash_table[HashSequence(sequence)];
+					match = src + slot;
+					slot = static_cast<uint32_t>(ip - src);
+					if (static_cast<uint64_t>(ip - match) <= c_max_offset && match < ip && Read32(match) == sequence)
+					{
+						break;
+					}
+					ip += attempts++ >> c_skip_trigger;
+					if (ip >= find_limit)
+					{
+						goto last_literals;
+					}
+				}
+
+				// 向前扩展
+				while (ip > anchor && match > src && ip[-1] == match[-1])
+				{
+					--ip;
+					--match;
+				}
+
+				const uint32_t match_length = c_min_match + CountMatch(ip + c_min_match, match + c_min_match, match_limit);
+				const uint32_t match_token = match_length - c_min_match >= 15 ? 15 : match_length - c_min_match;
+				op = WriteLiterals(op, anchor, static_cast<uint64_t>(ip - anchor), match_token);
+				const uint32_t offset = static_cast<uint32_t>(ip - match);
+				*op++ = static_cast<uint8_t>(offset);
+				*op++ = static_cast<uint8_t>(offset >> 8);
+				if (match_token == 15)
+				{
+					op = WriteLength(op, match_length - c_min_match - 15);
+				}
+
+				ip += match_length;
+				anchor = ip;
+				if (ip < find_limit)
+				{
+					// 匹配中间的位置也放进表里, 提高下一次命中率
+					hash_table[HashSequence(Read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - src);
+				}
+			}
+		}
+
+	last_literals:
+		op = WriteLiterals(op, anchor, static_cast<uint64_t>(src + size - anchor), 0);
+		return static_cast<uint64_t>(op - dst);
+	}
+
+	bool LzDecompress(const uint8_t* src, uint64_t src_size, uint8_t* dst, uint64_t dst_size)
+	{
+		const uint8_t*       ip = src;
+		const uint8_t* const iend = src + src_size;
+		uint8_t*             op = dst;
+		uint8_t* const       oend = dst + dst_size;
+		// 快速路径要求的余量, 缓冲太小时取开头, 读过 token 之后的比较一定不成立
+		// 短字面量整块拷贝16字节并且后面至少还有2字节的偏移, 短匹配整块拷贝24字节
+		const uint8_t* const ifast_limit = src_size > 16 + 2 ? iend - (16 + 2) : src;
+		uint8_t* const       oliteral_limit = dst_size > 16 ? oend - 16 : dst;
+		uint8_t* const       omatch_limit = dst_size > 24 ? oend - 24 : dst;
+
+		while (ip < iend)
+		{
+			const uint32_t token = *ip++;
+
+			// 字面量, 多写的部分会被后面的数据覆盖
+			uint64_t literal_count = token >> 4;
+			if (literal_count < 15 && ip <= ifast_limit && op < oliteral_limit)
+			{
+				Copy16(op, ip);
+				ip += literal_count;
+				op += literal_count;
+			}
+			else
+			{
+				if (literal_count == 15 && !ReadLength(ip, iend, literal_count))
+				{
+					return false;
+				}
+				if (literal_count > static_cast<uint64_t>(iend - ip) || literal_count > static_cast<uint64_t>(oend - op))
+				{
+					return false;
+				}
+				if (static_cast<uint64_t>(iend - ip) >= literal_count + 16 && static_cast<uint64_t>(oend - op) >= literal_count + 16)
+				{
+					for (uint64_t i = 0; i < literal_count; i += 16)
+					{
+						Copy16(op + i, ip + i);
+					}
+				}
+				else if (literal_count > 0)
+				{
+					// 解压空数据时 op 可以是空指针, 长度为0也不能传给 memcpy
+					memcpy(op, ip, literal_count);
+				}
+				ip += literal_count;
+				op += literal_count;
+
+				// 最后一个序列只有字面量
+				if (ip == iend)
+				{
+					break;
+				}
+				if (iend - ip < 2)
+				{
+					return false;
+				}
+			}
+
+			const uint32_t offset = ip[0] | (static_cast<uint32_t>(ip[1]) << 8);
+			ip += 2;
+			if (offset == 0 || offset > static_cast<uint64_t>(op - dst))
+			{
+				return false;
+			}
+			const uint8_t* match = op - offset;
+
+			// 不超过18字节且偏移至少为8的匹配, 三次8字节拷贝
+			uint64_t match_length = token & 15;
+			if (match_length < 15 && offset >= 8 && op < omatch_limit)
+			{
+				Copy8(op, match);
+				Copy8(op + 8, match + 8);
+				Copy8(op + 16, match + 16);
+				op += match_length + c_min_match;
+				continue;
+			}
+
+			if (match_length == 15 && !ReadLength(ip, iend, match_length))
+			{
+				return false;
+			}
+			match_length += c_min_match;
+			if (match_length > static_cast<uint64_t>(oend - op))
+			{
+				return false;
+			}
+			if (static_cast<uint64_t>(oend - op) >= match_length + 16)
+			{
+				if (offset >= 16)
+				{
+					for (uint64_t i = 0; i < match_length; i += 16)
+					{
+						Copy16(op + i, match + i);
+					}
+				}
+				else if (offset >= 8)
+				{
+					for (uint64_t i = 0; i < match_length; i += 8)
+					{
+						Copy8(op + i, match + i);
+					}
+				}
+				else
+				{
+					// 短偏移是重复的图案, 先逐字节铺出一个不小于8字节的整周期, 之后按8字节拷贝
+					const uint32_t period = offset * ((8 + offset - 1) / offset);
+					for (uint32_t i = 0; i < period; ++i)
+					{
+						op[i] = match[i];
+					}
+					for (uint64_t i = period; i < match_length; i += 8)
+					{
+						Copy8(op + i, op + i - period);
+					}
+				}
+			}
+			else
+			{
+				for (uint64_t i = 0; i < match_length; ++i)
+				{
+					op[i] = match[i];
+				}
+			}
+			op += match_length;
+		}
+		return op == oend && ip == iend;
+	}
+}
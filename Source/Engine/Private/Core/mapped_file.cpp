@@ -0,0 +1,189 @@
+﻿#include "Core/mapped_file.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <thread>
+#include <utility>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace FireEngine
+{
+	std::string MakeTempFileName(const std::string& file_name)
+	{
+		// 随机种子区分进程和机器, 计数器区分同一进程内的调用
+		static const uint64_t process_salt = (static_cast<uint64_t>(std::random_device{}()) << 32)
+			^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+		static std::atomic<uint64_t> counter{ 0 };
+		const uint64_t unique = process_salt
+			^ (counter.fetch_add(1, std::memory_order_relaxed) * 0x9E3779B97F4A7C15ull)
+			^ static_cast<uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), ".%016llx.tmp", static_cast<unsigned long long>(unique));
+		return file_name + suffix;
+	}
+
+	CMappedFile::~CMappedFile()
+	{
+		Close();
+	}
+
+	CMappedFile::CMappedFile(CMappedFile&& other) noexcept
+	{
+		MoveFrom(other);
+	}
+
+	CMappedFile& CMappedFile::operator=(CMappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			MoveFrom(other);
+		}
+		return *this;
+	}
+
+	void CMappedFile::MoveFrom(CMappedFile& other)
+	{
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_is_open = std::exchange(other.m_is_open, false);
+#if defined(_WIN32)
+		m_file_handle = std::exchange(other.m_file_handle, nullptr);
+		m_mapping_handle = std::exchange(other.m_mapping_handle, nullptr);
+#else
+		m_file_descriptor = std::exchange(other.m_file_descriptor, -1);
+#endif
+	}
+
+#if defined(_WIN32)
+	bool CMappedFile::Open(const std::string& file_name)
+	{
+		Close();
+
+		HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER file_size{};
+		if (!GetFileSizeEx(file, &file_size))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		m_file_handle = file;
+		m_size = static_cast<uint64_t>(file_size.QuadPart);
+		m_is_open = true;
+
+		// 空文件无法创建映射, 当作合法的空视图
+		if (m_size == 0)
+		{
+			return true;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+		{
+			Close();
+			return false;
+		}
+		m_mapping_handle = mapping;
+
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!view)
+		{
+			Close();
+			return false;
+		}
+		m_data = static_cast<const uint8_t*>(view);
+		return true;
+	}
+
+	void CMappedFile::Close()
+	{
+		if (m_data)
+		{
+			UnmapViewOfFile(m_data);
+		}
+		if (m_mapping_handle)
+		{
+			CloseHandle(m_mapping_handle);
+		}
+		if (m_file_handle)
+		{
+			CloseHandle(m_file_handle);
+		}
+		m_data = nullptr;
+		m_size = 0;
+		m_is_open = false;
+		m_mapping_handle = nullptr;
+		m_file_handle = nullptr;
+	}
+#else
+	bool CMappedFile::Open(const std::string& file_name)
+	{
+		Close();
+
+		int file_descriptor = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+		if (file_descriptor < 0)
+		{
+			return false;
+		}
+
+		struct stat file_stat{};
+		if (fstat(file_descriptor, &file_stat) != 0)
+		{
+			close(file_descriptor);
+			return false;
+		}
+
+		m_file_descriptor = file_descriptor;
+		m_size = static_cast<uint64_t>(file_stat.st_size);
+		m_is_open = true;
+
+		// 长度为0的映射是非法的, 当作合法的空视图
+		if (m_size == 0)
+		{
+			return true;
+		}
+
+		void* view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+		if (view == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+		m_data = static_cast<const uint8_t*>(view);
+		return true;
+	}
+
+	void CMappedFile::Close()
+	{
+		if (m_data)
+		{
+			munmap(const_cast<uint8_t*>(m_data), m_size);
+		}
+		if (m_file_descriptor >= 0)
+		{
+			close(m_file_descriptor);
+		}
+		m_data = nullptr;
+		m_size = 0;
+		m_is_open = false;
+		m_file_descriptor = -1;
+	}
+#endif
+}
@@ -0,0 +1,383 @@
+﻿#include "Core/mip_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FIRE_ENGINE_MIP_SSE2 1
+#include <emmintrin.h>
+#else
+#define FIRE_ENGINE_MIP_SSE2 0
+#endif
+
+#include "Core/job_system.h"
+
+namespace FireEngine
+{
+	namespace
+	{
+		// 每个任务生成的目标行数
+		constexpr uint32_t c_rows_per_job = 16;
+		constexpr uint32_t c_max_taps = 8;
+		constexpr uint32_t c_linear_to_srgb_steps = 4096;
+
+		struct SColorTables
+		{
+			float   srgb_to_linear[256];
+			uint8_t linear_to_srgb[c_linear_to_srgb_steps];
+
+			SColorTables()
+			{
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					const float value = i / 255.0f;
+					srgb_to_linear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+				}
+				for (uint32_t i = 0; i < c_linear_to_srgb_steps; ++i)
+				{
+					const float value = i / static_cast<float>(c_linear_to_srgb_steps - 1);
+					const float srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+					linear_to_srgb[i] = static_cast<uint8_t>(std::clamp(srgb * 255.0f + 0.5f, 0.0f, 255.0f));
+				}
+			}
+		};
+
+		const SColorTables& GetColorTables()
+		{
+			static const SColorTables tables;
+			return tables;
+		}
+
+		// 2:1 降采样的可分离核, 目标像素 x 取源像素 2x + first_tap 开始的 tap_count 个
+		struct SDownsampleKernel
+		{
+			int32_t  first_tap{ 0 };
+			uint32_t tap_count{ 0 };
+			float    weights[c_max_taps]{};
+		};
+
+		float BesselI0(float x)
+		{
+			float sum = 1.0f;
+			float term = 1.0f;
+			for (uint32_t k = 1; k < 16; ++k)
+			{
+				term *= (x * 0.5f / k) * (x * 0.5f / k);
+				sum += term;
+			}
+			return sum;
+		}
+
+		SDownsampleKernel MakeKernel(EMipFilter filter)
+		{
+			SDownsampleKernel kernel;
+			if (filter == EMipFilter::Box)
+			{
+				kernel.first_tap = 0;
+				kernel.tap_count = 2;
+				kernel.weights[0] = kernel.weights[1] = 0.5f;
+				return kernel;
+			}
+
+			// 目标像素中心在源像素 2x 与 2x+1 之间, 两侧各4个源像素
+			constexpr float c_pi = 3.14159265358979f;
+			constexpr float c_beta = 4.0f;
+			constexpr float c_radius = 4.0f;
+			kernel.first_tap = -3;
+			kernel.tap_count = c_max_taps;
+			float sum = 0.0f;
+			for (uint32_t i = 0; i < c_max_taps; ++i)
+			{
+				const float distance = static_cast<float>(i) - 3.5f;
+				const float x = distance * 0.5f;
+				const float sinc = std::fabs(x) < 1e-6f ? 1.0f : std::sin(c_pi * x) / (c_pi * x);
+				const float t = distance / c_radius;
+				const float window = BesselI0(c_beta * std::sqrt(std::max(0.0f, 1.0f - t * t))) / BesselI0(c_beta);
+				kernel.weights[i] = sinc * window;
+				sum += kernel.weights[i];
+			}
+			for (uint32_t i = 0; i < c_max_taps; ++i)
+			{
+				kernel.weights[i] /= sum;
+			}
+			return kernel;
+		}
+
+		// 8位像素转成滤波用的浮点 RGBA
+		void DecodeRow(const uint8_t* source, uint32_t width, EMipContent content, float* out_row)
+		{
+			const SColorTables& tables = GetColorTables();
+			switch (content)
+			{
+			case EMipContent::Color:
+				for (uint32_t x = 0; x < width; ++x, source += 4, out_row += 4)
+				{
+					out_row[0] = tables.srgb_to_linear[source[0]];
+					out_row[1] = tables.srgb_to_linear[source[1]];
+					out_row[2] = tables.srgb_to_linear[source[2]];
+					out_row[3] = source[3] * (1.0f / 255.0f);
+				}
+				break;
+			case EMipContent::Linear:
+				for (uint32_t x = 0; x < width * 4; ++x)
+				{
+					out_row[x] = source[x] * (1.0f / 255.0f);
+				}
+				break;
+			case EMipContent::NormalMap:
+				for (uint32_t x = 0; x < width; ++x, source += 4, out_row += 4)
+				{
+					out_row[0] = source[0] * (1.0f / 127.5f) - 1.0f;
+					out_row[1] = source[1] * (1.0f / 127.5f) - 1.0f;
+					out_row[2] = source[2] * (1.0f / 127.5f) - 1.0f;
+					out_row[3] = source[3] * (1.0f / 255.0f);
+				}
+				break;
+			}
+		}
+
+		inline uint8_t ToUnorm8(float value)
+		{
+			return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+
+		void EncodeRow(const float* row, uint32_t width, EMipContent content, uint8_t* out_target)
+		{
+			const SColorTables& tables = GetColorTables();
+			switch (content)
+			{
+			case EMipContent::Color:
+			{
+				constexpr float c_scale = static_cast<float>(c_linear_to_srgb_steps - 1);
+				for (uint32_t x = 0; x < width; ++x, row += 4, out_target += 4)
+				{
+					out_target[0] = tables.linear_to_srgb[static_cast<uint32_t>(std::clamp(row[0], 0.0f, 1.0f) * c_scale + 0.5f)];
+					out_target[1] = tables.linear_to_srgb[static_cast<uint32_t>(std::clamp(row[1], 0.0f, 1.0f) * c_scale + 0.5f)];
+					out_target[2] = tables.linear_to_srgb[static_cast<uint32_t>(std::clamp(row[2], 0.0f, 1.0f) * c_scale + 0.5f)];
+					out_target[3] = ToUnorm8(row[3]);
+				}
+				break;
+			}
+			case EMipContent::Linear:
+				for (uint32_t x = 0; x < width * 4; ++x)
+				{
+					out_target[x] = ToUnorm8(row[x]);
+				}
+				break;
+			case EMipContent::NormalMap:
+				for (uint32_t x = 0; x < width; ++x, row += 4, out_target += 4)
+				{
+					// 平均后的法线变短, 重新归一化; 完全抵消时退回 +Z
+					float normal[3] = { row[0], row[1], row[2] };
+					const float length_sq = normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2];
+					if (length_sq > 1e-12f)
+					{
+						const float inverse_length = 1.0f / std::sqrt(length_sq);
+						for (float& component : normal)
+						{
+							component *= inverse_length;
+						}
+					}
+					else
+					{
+						normal[0] = normal[1] = 0.0f;
+						normal[2] = 1.0f;
+					}
+					for (uint32_t c = 0; c < 3; ++c)
+					{
+						out_target[c] = ToUnorm8(normal[c] * 0.5f + 0.5f);
+					}
+					out_target[3] = ToUnorm8(row[3]);
+				}
+				break;
+			}
+		}
+
+		// 水平方向降采样一行, 一个像素的 RGBA 正好是一个 SSE 寄存器
+		inline void DownsamplePixel(const float* source, int32_t first, int32_t last_pixel, const SDownsampleKernel& kernel, bool clamp, float* out_pixel)
+		{
+#if FIRE_ENGINE_MIP_SSE2
+			__m128 sum = _mm_setzero_ps();
+			for (uint32_t tap = 0; tap < kernel.tap_count; ++tap)
+			{
+				const int32_t sample = clamp ? std::clamp(first + static_cast<int32_t>(tap), 0, last_pixel) : first + static_cast<int32_t>(tap);
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source + sample * 4), _mm_set1_ps(kernel.weights[tap])));
+			}
+			_mm_storeu_ps(out_pixel, sum);
+#else
+			float sum[4] = {};
+			for (uint32_t tap = 0; tap < kernel.tap_count; ++tap)
+			{
+				const int32_t sample = clamp ? std::clamp(first + static_cast<int32_t>(tap), 0, last_pixel) : first + static_cast<int32_t>(tap);
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					sum[c] += source[sample * 4 + c] * kernel.weights[tap];
+				}
+			}
+			memcpy(out_pixel, sum, sizeof(sum));
+#endif
+		}
+
+		void DownsampleRow(const float* source, uint32_t source_width, const SDownsampleKernel& kernel, uint32_t target_width, float* out_row)
+		{
+			// 只有两端的像素需要夹取采样位置
+			const int32_t last_pixel = static_cast<int32_t>(source_width) - 1;
+			for (uint32_t x = 0; x < target_width; ++x)
+			{
+				const int32_t first = static_cast<int32_t>(x * 2) + kernel.first_tap;
+				const bool    clamp = first < 0 || first + static_cast<int32_t>(kernel.tap_count) - 1 > last_pixel;
+				DownsamplePixel(source, first, last_pixel, kernel, clamp, out_row + x * 4);
+			}
+		}
+
+		void AccumulateRow(const float* row, float weight, uint32_t float_count, float* out_sum)
+		{
+			uint32_t i = 0;
+#if FIRE_ENGINE_MIP_SSE2
+			const __m128 weights = _mm_set1_ps(weight);
+			for (; i + 4 <= float_count; i += 4)
+			{
+				_mm_storeu_ps(out_sum + i, _mm_add_ps(_mm_loadu_ps(out_sum + i), _mm_mul_ps(_mm_loadu_ps(row + i), weights)));
+			}
+#endif
+			for (; i < float_count; ++i)
+			{
+				out_sum[i] += row[i] * weight;
+			}
+		}
+
+		// 盒式滤波直接读两行源像素写一行目标, 不经过浮点的中间行
+		void DownsampleBoxRows(const uint8_t* source, uint32_t source_width, uint32_t source_height, uint8_t* target, uint32_t target_width,
+			uint32_t row_begin, uint32_t row_end, EMipContent content)
+		{
+			std::vector<float> decoded(static_cast<size_t>(source_width) * 8);
+			std::vector<float> average(static_cast<size_t>(target_width) * 4);
+			float* upper = decoded.data();
+			float* lower = decoded.data() + static_cast<size_t>(source_width) * 4;
+			for (uint32_t y = row_begin; y < row_end; ++y)
+			{
+				const uint32_t upper_row = std::min(y * 2, source_height - 1);
+				const uint32_t lower_row = std::min(y * 2 + 1, source_height - 1);
+				DecodeRow(source + static_cast<uint64_t>(upper_row) * source_width * 4, source_width, content, upper);
+				DecodeRow(source + static_cast<uint64_t>(lower_row) * source_width * 4, source_width, content, lower);
+				for (uint32_t x = 0; x < target_width; ++x)
+				{
+					const uint32_t left = std::min(x * 2, source_width - 1) * 4;
+					const uint32_t right = std::min(x * 2 + 1, source_width - 1) * 4;
+#if FIRE_ENGINE_MIP_SSE2
+					const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(upper + left), _mm_loadu_ps(upper + right)),
+						_mm_add_ps(_mm_loadu_ps(lower + left), _mm_loadu_ps(lower + right)));
+					_mm_storeu_ps(average.data() + x * 4, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+					for (uint32_t c = 0; c < 4; ++c)
+					{
+						average[x * 4 + c] = (upper[left + c] + upper[right + c] + lower[left + c] + lower[right + c]) * 0.25f;
+					}
+#endif
+				}
+				EncodeRow(average.data(), target_width, content, target + static_cast<uint64_t>(y) * target_width * 4);
+			}
+		}
+
+		// 生成目标层级的 [row_begin, row_end) 行
+		void DownsampleRows(const uint8_t* source, uint32_t source_width, uint32_t source_height, uint8_t* target, uint32_t target_width,
+			uint32_t row_begin, uint32_t row_end, EMipContent content, const SDownsampleKernel& kernel)
+		{
+			// 先把这一段用到的源行解码并做水平降采样, 再做垂直方向
+			const int32_t source_first = std::max(0, static_cast<int32_t>(row_begin * 2) + kernel.first_tap);
+			const int32_t source_last = std::min(static_cast<int32_t>(source_height) - 1, static_cast<int32_t>((row_end - 1) * 2) + kernel.first_tap + static_cast<int32_t>(kernel.tap_count) - 1);
+			const uint32_t band_rows = static_cast<uint32_t>(source_last - source_first + 1);
+			const uint32_t target_floats = target_width * 4;
+
+			std::vector<float> decoded(static_cast<size_t>(source_width) * 4);
+			std::vector<float> band(static_cast<size_t>(band_rows) * target_floats);
+			for (uint32_t i = 0; i < band_rows; ++i)
+			{
+				DecodeRow(source + static_cast<uint64_t>(source_first + i) * source_width * 4, source_width, content, decoded.data());
+				DownsampleRow(decoded.data(), source_width, kernel, target_width, band.data() + static_cast<size_t>(i) * target_floats);
+			}
+
+			std::vector<float> sum(target_floats);
+			for (uint32_t y = row_begin; y < row_end; ++y)
+			{
+				std::fill(sum.begin(), sum.end(), 0.0f);
+				const int32_t first = static_cast<int32_t>(y * 2) + kernel.first_tap;
+				for (uint32_t tap = 0; tap < kernel.tap_count; ++tap)
+				{
+					const int32_t sample = std::clamp(first + static_cast<int32_t>(tap), source_first, source_last);
+					AccumulateRow(band.data() + static_cast<size_t>(sample - source_first) * target_floats, kernel.weights[tap], target_floats, sum.data());
+				}
+				EncodeRow(sum.data(), target_width, content, target + static_cast<uint64_t>(y) * target_width * 4);
+			}
+		}
+	}
+
+	uint32_t GetMipCount(uint32_t width, uint32_t height)
+	{
+		uint32_t count = 1;
+		while (width > 1 || height > 1)
+		{
+			width = std::max(1u, width / 2);
+			height = std::max(1u, height / 2);
+			++count;
+		}
+		return count;
+	}
+
+	bool GenerateMipChain(std::vector<uint8_t>& data, uint32_t width, uint32_t height, EMipContent content, EMipFilter filter,
+		std::vector<STextureMip>& out_mips, CJobSystem* job_system)
+	{
+		if (width == 0 || height == 0 || data.size() < static_cast<uint64_t>(width) * height * 4)
+		{
+			return false;
+		}
+
+		// 一次性算好所有层级的位置, 只扩容一次
+		const uint32_t mip_count = GetMipCount(width, height);
+		out_mips.resize(mip_count);
+		uint64_t offset = 0;
+		for (uint32_t level = 0; level < mip_count; ++level)
+		{
+			STextureMip& mip = out_mips[level];
+			mip.width = std::max(1u, width >> level);
+			mip.height = std::max(1u, height >> level);
+			mip.offset = offset;
+			mip.size = static_cast<uint64_t>(mip.width) * mip.height * 4;
+			offset += mip.size;
+		}
+		data.resize(offset);
+
+		const SDownsampleKernel kernel = MakeKernel(filter);
+		for (uint32_t level = 1; level < mip_count; ++level)
+		{
+			const STextureMip& source = out_mips[level - 1];
+			const STextureMip& target = out_mips[level];
+			const uint32_t job_count = (target.height + c_rows_per_job - 1) / c_rows_per_job;
+			auto downsample = [&](uint32_t job) {
+				const uint32_t row_begin = job * c_rows_per_job;
+				const uint32_t row_end = std::min(target.height, row_begin + c_rows_per_job);
+				if (filter == EMipFilter::Box)
+				{
+					DownsampleBoxRows(data.data() + source.offset, source.width, source.height, data.data() + target.offset, target.width,
+						row_begin, row_end, content);
+					return;
+				}
+				DownsampleRows(data.data() + source.offset, source.width, source.height, data.data() + target.offset, target.width,
+					row_begin, row_end, content, kernel);
+			};
+			if (job_system && job_count > 1)
+			{
+				job_system->ParallelFor(job_count, downsample);
+			}
+			else
+			{
+				for (uint32_t job = 0; job < job_count; ++job)
+				{
+					downsample(job);
+				}
+			}
+		}
+		return true;
+	}
+}
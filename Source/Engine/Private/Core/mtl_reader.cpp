@@ -0,0 +1,123 @@
+﻿#include "Core/mtl_reader.h"
+
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+namespace FireEngine
+{
+	namespace
+	{
+		inline bool IsBlank(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		// 把一行切成以空白分隔的若干项, 遇到 '#' 结束
+		void SplitLine(const char* p, const char* line_end, std::vector<std::string_view>& out_tokens)
+		{
+			out_tokens.clear();
+			while (p < line_end)
+			{
+				while (p < line_end && IsBlank(*p))
+				{
+					++p;
+				}
+				if (p >= line_end || *p == '#')
+				{
+					break;
+				}
+				const char* token_begin = p;
+				while (p < line_end && !IsBlank(*p))
+				{
+					++p;
+				}
+				out_tokens.emplace_back(token_begin, p - token_begin);
+			}
+		}
+
+		float ParseFloat(std::string_view token)
+		{
+			float value = 0.0f;
+			const char* begin = token.data();
+			if (!token.empty() && *begin == '+')
+			{
+				++begin;
+			}
+			std::from_chars(begin, token.data() + token.size(), value);
+			return value;
+		}
+
+		void ParseColor(const std::vector<std::string_view>& tokens, float* out_color)
+		{
+			// "Kd r" 表示三个分量相同, 只写了一个值时复制到 g/b
+			for (size_t i = 0; i < 3; ++i)
+			{
+				out_color[i] = ParseFloat(tokens[tokens.size() > i + 1 ? i + 1 : 1]);
+			}
+		}
+	}
+
+	bool ReadMtl(const SByteView& buffer, std::vector<SMtlMaterial>& out_materials)
+	{
+		out_materials.clear();
+		const char* p = buffer.CharBegin();
+		const char* end = buffer.CharEnd();
+		std::vector<std::string_view> tokens;
+		while (p < end)
+		{
+			const void* new_line = memchr(p, '\n', end - p);
+			const char* line_end = new_line ? static_cast<const char*>(new_line) : end;
+			SplitLine(p, line_end, tokens);
+			p = line_end + 1;
+			if (tokens.size() < 2)
+			{
+				continue;
+			}
+
+			const std::string_view keyword = tokens[0];
+			if (keyword == "newmtl")
+			{
+				SMtlMaterial& material = out_materials.emplace_back();
+				material.name = tokens[1];
+				material.material.emission[3] = 1.0f;
+				continue;
+			}
+			// newmtl 之前的语句不属于任何材质
+			if (out_materials.empty())
+			{
+				continue;
+			}
+			SMtlMaterial& material = out_materials.back();
+			if (keyword == "Kd")
+			{
+				ParseColor(tokens, material.material.kd);
+			}
+			else if (keyword == "Ks")
+			{
+				ParseColor(tokens, material.material.ks);
+			}
+			else if (keyword == "Ke")
+			{
+				ParseColor(tokens, material.material.emission);
+			}
+			else if (keyword == "Ns")
+			{
+				material.material.specular_exponent = ParseFloat(tokens[1]);
+			}
+			else if (keyword == "Ni")
+			{
+				material.material.emission[3] = ParseFloat(tokens[1]);
+			}
+			else if (keyword == "map_Kd")
+			{
+				material.diffuse_texture = tokens.back();
+			}
+			else if (keyword == "map_Bump" || keyword == "map_bump" || keyword == "bump" || keyword == "norm")
+			{
+				material.normal_texture = tokens.back();
+			}
+		}
+		return !out_materials.empty();
+	}
+}
@@ -0,0 +1,636 @@
+﻿#include "Core/obj_reader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#include "Core/job_system.h"
+#include "Core/triangulation.h"
+
+namespace FireEngine
+{
+	namespace
+	{
+		struct SObjCorner
+		{
+			int32_t position;
+			int32_t uv;
+			int32_t normal;
+		};
+
+		struct SObjAttributes
+		{
+			std::vector<float> positions;
+			std::vector<float> uvs;
+			std::vector<float> normals;
+
+			size_t PositionCount() const { return positions.size() / 3; }
+			size_t UvCount() const { return uvs.size() / 2; }
+			size_t NormalCount() const { return normals.size() / 3; }
+		};
+
+		struct SObjParseState
+		{
+			SObjAttributes          attributes;
+			std::vector<SObjCorner> corners;
+
+			SGeometryDesc current{};
+			std::string   current_name;
+		};
+
+		inline bool IsBlank(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		inline const char* SkipBlank(const char* p, const char* end)
+		{
+			while (p < end && IsBlank(*p))
+			{
+				++p;
+			}
+			return p;
+		}
+
+		inline const char* SkipLine(const char* p, const char* end)
+		{
+			const void* new_line = memchr(p, '\n', end - p);
+			return new_line ? static_cast<const char*>(new_line) + 1 : end;
+		}
+
+		inline const char* LineEnd(const char* p, const char* end)
+		{
+			const void* new_line = memchr(p, '\n', end - p);
+			return new_line ? static_cast<const char*>(new_line) : end;
+		}
+
+		inline std::string_view TrimmedTail(const char* p, const char* line_end)
+		{
+			p = SkipBlank(p, line_end);
+			while (line_end > p && IsBlank(line_end[-1]))
+			{
+				--line_end;
+			}
+			return std::string_view(p, line_end - p);
+		}
+
+		inline const char* ParseFloat(const char* p, const char* end, float& out_value)
+		{
+			p = SkipBlank(p, end);
+			if (p < end && *p == '+')
+			{
+				++p;
+			}
+			auto result = std::from_chars(p, end, out_value);
+			if (result.ec != std::errc())
+			{
+				out_value = 0.0f;
+			}
+			return result.ptr;
+		}
+
+		inline const char* ParseFloats(const char* p, const char* end, std::vector<float>& out_values, uint32_t count)
+		{
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				p = ParseFloat(p, end, out_values.emplace_back());
+			}
+			return p;
+		}
+
+		inline bool MatchKeyword(const char* p, const char* end, const char* keyword, size_t length)
+		{
+			return static_cast<size_t>(end - p) > length && memcmp(p, keyword, length) == 0 && IsBlank(p[length]);
+		}
+
+		// 读取一个面的所有角, 保留OBJ原始的索引值(从1开始, 负数为相对索引, 0表示缺省)
+		template <typename FCornerFunc>
+		const char* ParseFaceCorners(const char* p, const char* end, FCornerFunc&& on_corner)
+		{
+			while (true)
+			{
+				p = SkipBlank(p, end);
+				if (p >= end || *p == '\n' || *p == '#')
+				{
+					break;
+				}
+
+				SObjCorner corner{ 0, 0, 0 };
+				auto       result = std::from_chars(p, end, corner.position);
+				if (result.ec != std::errc())
+				{
+					break;
+				}
+				p = result.ptr;
+				if (p < end && *p == '/')
+				{
+					++p;
+					if (p < end && *p != '/')
+					{
+						result = std::from_chars(p, end, corner.uv);
+						p = result.ptr;
+					}
+					if (p < end && *p == '/')
+					{
+						++p;
+						result = std::from_chars(p, end, corner.normal);
+						p = result.ptr;
+					}
+				}
+				on_corner(corner);
+			}
+			return p;
+		}
+
+		// 原始索引转为从0开始的绝对索引, 越界或缺省返回-1
+		inline int32_t ResolveIndex(int32_t index, size_t element_count)
+		{
+			int64_t resolved = index < 0 ? static_cast<int64_t>(element_count) + index : static_cast<int64_t>(index) - 1;
+			if (index == 0 || resolved < 0 || resolved >= static_cast<int64_t>(element_count))
+			{
+				return -1;
+			}
+			return static_cast<int32_t>(resolved);
+		}
+
+		void EmitFace(const SObjCorner* corners, size_t corner_count, const SObjAttributes& attributes, IndexType first_index, std::vector<SVertexInstance>& out_vertices, std::vector<IndexType>& out_indices)
+		{
+			if (corner_count < 3)
+			{
+				return;
+			}
+			for (size_t i = 0; i < corner_count; ++i)
+			{
+				if (corners[i].position < 0)
+				{
+					return;
+				}
+			}
+
+			// 任意一个角缺法线时整个面都使用面法线
+			bool  missing_normal = false;
+			float face_normal[3] = { 0.0f, 0.0f, 0.0f };
+			for (size_t i = 0; i < corner_count; ++i)
+			{
+				missing_normal |= corners[i].normal < 0;
+			}
+			if (missing_normal)
+			{
+				// Newell 法线, 凹多边形的第一个角是凹角时也不会翻转; 符号与三角形的 (p0 - p1) x (p2 - p1) 一致
+				for (size_t i = 0; i < corner_count; ++i)
+				{
+					const float* current = &attributes.positions[corners[i].position * 3];
+					const float* next = &attributes.positions[corners[(i + 1) % corner_count].position * 3];
+					face_normal[0] -= (current[1] - next[1]) * (current[2] + next[2]);
+					face_normal[1] -= (current[2] - next[2]) * (current[0] + next[0]);
+					face_normal[2] -= (current[0] - next[0]) * (current[1] + next[1]);
+				}
+			}
+
+			for (size_t i = 0; i < corner_count; ++i)
+			{
+				const SObjCorner& corner = corners[i];
+				SVertexInstance&  vert = out_vertices.emplace_back();
+				const float* position = &attributes.positions[corner.position * 3];
+				vert.position[0] = position[0];
+				vert.position[1] = position[1];
+				vert.position[2] = position[2];
+				vert.position[3] = 1.0f;
+
+				const float* normal = missing_normal ? face_normal : &attributes.normals[corner.normal * 3];
+				const float  length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+				const float  inv_length = length > 0.0f ? 1.0f / length : 0.0f;
+				vert.normal[0] = normal[0] * inv_length;
+				vert.normal[1] = normal[1] * inv_length;
+				vert.normal[2] = normal[2] * inv_length;
+
+				if (corner.uv >= 0)
+				{
+					vert.uv[0] = attributes.uvs[corner.uv * 2];
+					vert.uv[1] = attributes.uvs[corner.uv * 2 + 1];
+				}
+			}
+
+			const SVertexInstance& first_vertex = out_vertices[out_vertices.size() - corner_count];
+			TriangulatePolygon(first_vertex.position, sizeof(SVertexInstance) / sizeof(float), static_cast<uint32_t>(corner_count), out_indices, first_index);
+		}
+
+		void FlushGeometry(SGeometryDesc& current, const std::string& current_name, uint32_t vertex_end, uint32_t index_end, SObjMeshData& out_mesh)
+		{
+			current.vertex_count = vertex_end - current.vertex_offset;
+			current.index_count  = index_end - current.index_offset;
+			if (current.index_count > 0)
+			{
+				out_mesh.geometries.emplace_back(current);
+				out_mesh.geometry_names.emplace_back(current_name);
+			}
+			current.vertex_offset = vertex_end;
+			current.index_offset  = index_end;
+			current.vertex_count  = 0;
+			current.index_count   = 0;
+		}
+
+		uint32_t FindOrAddMaterial(std::string_view name, SObjMeshData& out_mesh)
+		{
+			for (uint32_t i = 0; i < out_mesh.material_names.size(); ++i)
+			{
+				if (out_mesh.material_names[i] == name)
+				{
+					return i;
+				}
+			}
+			out_mesh.material_names.emplace_back(name);
+			return static_cast<uint32_t>(out_mesh.material_names.size() - 1);
+		}
+
+		enum class EObjChunkEvent : uint8_t
+		{
+			Group,
+			Material,
+		};
+
+		struct SObjChunkEvent
+		{
+			EObjChunkEvent type;
+			uint32_t       face_index;
+			std::string    name;
+			// 第三阶段填写: 事件发生时块内已输出的顶点数和索引数
+			uint32_t       local_vertex_count{ 0 };
+			uint32_t       local_index_count{ 0 };
+		};
+
+		// 第一阶段里相对索引先解析成块内下标, relative_mask 标记哪些分量还需要加上块的全局基址
+		struct SObjChunkCorner
+		{
+			SObjCorner corner;
+			uint32_t   relative_mask;
+		};
+
+		struct SObjIndexSegment
+		{
+			uint32_t index_begin;
+			uint32_t index_end;
+			int64_t  fixup;
+		};
+
+		struct SObjChunk
+		{
+			const char* begin{ nullptr };
+			const char* end{ nullptr };
+
+			SObjAttributes               attributes;
+			std::vector<SObjChunkCorner> corners;
+			std::vector<uint32_t>        face_corner_counts;
+			std::vector<SObjChunkEvent>  events;
+			std::string                  material_library;
+
+			std::vector<SVertexInstance>  vertices;
+			std::vector<IndexType>        indices;
+			std::vector<SObjIndexSegment> segments;
+
+			uint64_t position_base{ 0 };
+			uint64_t uv_base{ 0 };
+			uint64_t normal_base{ 0 };
+			uint64_t vertex_base{ 0 };
+			uint64_t index_base{ 0 };
+		};
+
+		void ParseChunk(SObjChunk& chunk)
+		{
+			const char* p   = chunk.begin;
+			const char* end = chunk.end;
+			SObjAttributes& attributes = chunk.attributes;
+			while (p < end)
+			{
+				p = SkipBlank(p, end);
+				if (p >= end)
+				{
+					break;
+				}
+
+				const char c = *p;
+				if (c == 'v' && p + 1 < end)
+				{
+					const char c1 = p[1];
+					if (IsBlank(c1))
+					{
+						p = ParseFloats(p + 2, end, attributes.positions, 3);
+					}
+					else if (c1 == 't' && p + 2 < end && IsBlank(p[2]))
+					{
+						p = ParseFloats(p + 3, end, attributes.uvs, 2);
+					}
+					else if (c1 == 'n' && p + 2 < end && IsBlank(p[2]))
+					{
+						p = ParseFloats(p + 3, end, attributes.normals, 3);
+					}
+				}
+				else if (c == 'f' && p + 1 < end && IsBlank(p[1]))
+				{
+					const int64_t position_count = static_cast<int64_t>(attributes.PositionCount());
+					const int64_t uv_count       = static_cast<int64_t>(attributes.UvCount());
+					const int64_t normal_count   = static_cast<int64_t>(attributes.NormalCount());
+					uint32_t corner_count = 0;
+					p = ParseFaceCorners(p + 2, end, [&](const SObjCorner& raw) {
+						SObjChunkCorner& chunk_corner = chunk.corners.emplace_back();
+						chunk_corner.relative_mask = 0;
+						const int32_t raw_values[3] = { raw.position, raw.uv, raw.normal };
+						const int64_t counts[3]     = { position_count, uv_count, normal_count };
+						int32_t*      values[3]     = { &chunk_corner.corner.position, &chunk_corner.corner.uv, &chunk_corner.corner.normal };
+						for (uint32_t i = 0; i < 3; ++i)
+						{
+							if (raw_values[i] < 0)
+							{
+								*values[i] = static_cast<int32_t>(counts[i] + raw_values[i]);
+								chunk_corner.relative_mask |= 1u << i;
+							}
+							else
+							{
+								*values[i] = raw_values[i] - 1;
+							}
+						}
+						++corner_count;
+					});
+					chunk.face_corner_counts.emplace_back(corner_count);
+				}
+				else if ((c == 'o' || c == 'g') && p + 1 < end && IsBlank(p[1]))
+				{
+					const char* line_end = LineEnd(p, end);
+					chunk.events.push_back({ EObjChunkEvent::Group, static_cast<uint32_t>(chunk.face_corner_counts.size()), std::string(TrimmedTail(p + 2, line_end)) });
+					p = line_end;
+				}
+				else if (MatchKeyword(p, end, "usemtl", 6))
+				{
+					const char* line_end = LineEnd(p, end);
+					chunk.events.push_back({ EObjChunkEvent::Material, static_cast<uint32_t>(chunk.face_corner_counts.size()), std::string(TrimmedTail(p + 7, line_end)) });
+					p = line_end;
+				}
+				else if (MatchKeyword(p, end, "mtllib", 6))
+				{
+					const char* line_end = LineEnd(p, end);
+					chunk.material_library = TrimmedTail(p + 7, line_end);
+					p = line_end;
+				}
+				p = SkipLine(p, end);
+			}
+		}
+
+		void EmitChunk(SObjChunk& chunk, const SObjAttributes& attributes)
+		{
+			const int64_t bases[3]  = { static_cast<int64_t>(chunk.position_base), static_cast<int64_t>(chunk.uv_base), static_cast<int64_t>(chunk.normal_base) };
+			const int64_t counts[3] = { static_cast<int64_t>(attributes.PositionCount()), static_cast<int64_t>(attributes.UvCount()), static_cast<int64_t>(attributes.NormalCount()) };
+
+			chunk.vertices.reserve(chunk.corners.size());
+			chunk.indices.reserve(chunk.corners.size());
+
+			std::vector<SObjCorner> face_corners;
+			size_t corner_cursor = 0;
+			size_t event_cursor  = 0;
+			for (uint32_t face_index = 0; face_index <= chunk.face_corner_counts.size(); ++face_index)
+			{
+				while (event_cursor < chunk.events.size() && chunk.events[event_cursor].face_index == face_index)
+				{
+					chunk.events[event_cursor].local_vertex_count = static_cast<uint32_t>(chunk.vertices.size());
+					chunk.events[event_cursor].local_index_count  = static_cast<uint32_t>(chunk.indices.size());
+					++event_cursor;
+				}
+				if (face_index == chunk.face_corner_counts.size())
+				{
+					break;
+				}
+
+				const uint32_t corner_count = chunk.face_corner_counts[face_index];
+				face_corners.clear();
+				for (uint32_t i = 0; i < corner_count; ++i)
+				{
+					const SObjChunkCorner& chunk_corner = chunk.corners[corner_cursor + i];
+					int32_t                values[3] = { chunk_corner.corner.position, chunk_corner.corner.uv, chunk_corner.corner.normal };
+					for (uint32_t component = 0; component < 3; ++component)
+					{
+						int64_t value = values[component];
+						if (chunk_corner.relative_mask & (1u << component))
+						{
+							value += bases[component];
+						}
+						values[component] = (value < 0 || value >= counts[component]) ? -1 : static_cast<int32_t>(value);
+					}
+					face_corners.push_back({ values[0], values[1], values[2] });
+				}
+				corner_cursor += corner_count;
+				EmitFace(face_corners.data(), face_corners.size(), attributes, static_cast<IndexType>(chunk.vertices.size()), chunk.vertices, chunk.indices);
+			}
+
+			chunk.corners = std::vector<SObjChunkCorner>();
+			chunk.face_corner_counts = std::vector<uint32_t>();
+		}
+	}
+
+	bool ReadObj(const SByteView& buffer, SObjMeshData& out_mesh)
+	{
+		out_mesh = SObjMeshData();
+		if (buffer.Empty())
+		{
+			return false;
+		}
+
+		const char* p   = buffer.CharBegin();
+		const char* end = buffer.CharEnd();
+
+		SObjParseState  state;
+		SObjAttributes& attributes = state.attributes;
+		// 按文件大小粗略预估, 避免大文件反复扩容
+		const size_t estimated_lines = buffer.size / 32;
+		attributes.positions.reserve(estimated_lines);
+		out_mesh.vertices.reserve(estimated_lines / 2);
+		out_mesh.indices.reserve(estimated_lines / 2);
+
+		while (p < end)
+		{
+			p = SkipBlank(p, end);
+			if (p >= end)
+			{
+				break;
+			}
+
+			const char c = *p;
+			if (c == 'v' && p + 1 < end)
+			{
+				const char c1 = p[1];
+				if (IsBlank(c1))
+				{
+					p = ParseFloats(p + 2, end, attributes.positions, 3);
+				}
+				else if (c1 == 't' && p + 2 < end && IsBlank(p[2]))
+				{
+					p = ParseFloats(p + 3, end, attributes.uvs, 2);
+				}
+				else if (c1 == 'n' && p + 2 < end && IsBlank(p[2]))
+				{
+					p = ParseFloats(p + 3, end, attributes.normals, 3);
+				}
+			}
+			else if (c == 'f' && p + 1 < end && IsBlank(p[1]))
+			{
+				const size_t position_count = attributes.PositionCount();
+				const size_t uv_count       = attributes.UvCount();
+				const size_t normal_count   = attributes.NormalCount();
+				state.corners.clear();
+				p = ParseFaceCorners(p + 2, end, [&](const SObjCorner& raw) {
+					state.corners.push_back({ ResolveIndex(raw.position, position_count), ResolveIndex(raw.uv, uv_count), ResolveIndex(raw.normal, normal_count) });
+				});
+				const IndexType first_index = static_cast<IndexType>(out_mesh.vertices.size() - state.current.vertex_offset);
+				EmitFace(state.corners.data(), state.corners.size(), attributes, first_index, out_mesh.vertices, out_mesh.indices);
+			}
+			else if ((c == 'o' || c == 'g') && p + 1 < end && IsBlank(p[1]))
+			{
+				FlushGeometry(state.current, state.current_name, static_cast<uint32_t>(out_mesh.vertices.size()), static_cast<uint32_t>(out_mesh.indices.size()), out_mesh);
+				const char* line_end = LineEnd(p, end);
+				state.current_name = TrimmedTail(p + 2, line_end);
+				p = line_end;
+			}
+			else if (MatchKeyword(p, end, "usemtl", 6))
+			{
+				FlushGeometry(state.current, state.current_name, static_cast<uint32_t>(out_mesh.vertices.size()), static_cast<uint32_t>(out_mesh.indices.size()), out_mesh);
+				const char* line_end = LineEnd(p, end);
+				state.current.material_index = FindOrAddMaterial(TrimmedTail(p + 7, line_end), out_mesh);
+				p = line_end;
+			}
+			else if (MatchKeyword(p, end, "mtllib", 6))
+			{
+				const char* line_end = LineEnd(p, end);
+				out_mesh.material_library = TrimmedTail(p + 7, line_end);
+				p = line_end;
+			}
+			p = SkipLine(p, end);
+		}
+		FlushGeometry(state.current, state.current_name, static_cast<uint32_t>(out_mesh.vertices.size()), static_cast<uint32_t>(out_mesh.indices.size()), out_mesh);
+
+		return !out_mesh.geometries.empty();
+	}
+
+	bool ReadObjParallel(const SByteView& buffer, CJobSystem& job_system, SObjMeshData& out_mesh)
+	{
+		constexpr uint64_t min_chunk_size = 1ull << 20;
+		const uint64_t max_chunk_count = (job_system.GetWorkerCount() + 1) * 4ull;
+		const uint64_t chunk_count = std::min(max_chunk_count, buffer.size / min_chunk_size);
+		if (chunk_count <= 1)
+		{
+			return ReadObj(buffer, out_mesh);
+		}
+		out_mesh = SObjMeshData();
+
+		// 在换行处切块, 每块都从一行的开头开始
+		std::vector<SObjChunk> chunks(chunk_count);
+		{
+			const char* begin = buffer.CharBegin();
+			const char* end   = buffer.CharEnd();
+			const char* cursor = begin;
+			for (uint64_t i = 0; i < chunk_count; ++i)
+			{
+				const char* target = (i + 1 == chunk_count) ? end : begin + buffer.size * (i + 1) / chunk_count;
+				target = std::max(target, cursor);
+				chunks[i].begin = cursor;
+				chunks[i].end = (target < end) ? SkipLine(target, end) : end;
+				cursor = chunks[i].end;
+			}
+		}
+
+		// 第一阶段: 各块独立解析属性, 面只记录原始索引
+		job_system.ParallelFor(static_cast<uint32_t>(chunk_count), [&chunks](uint32_t chunk_index) {
+			ParseChunk(chunks[chunk_index]);
+		});
+
+		// 第二阶段: 属性数量前缀和得到每块的全局基址, 再并行拼接属性
+		SObjAttributes attributes;
+		{
+			uint64_t position_total = 0;
+			uint64_t uv_total = 0;
+			uint64_t normal_total = 0;
+			for (SObjChunk& chunk : chunks)
+			{
+				chunk.position_base = position_total;
+				chunk.uv_base = uv_total;
+				chunk.normal_base = normal_total;
+				position_total += chunk.attributes.PositionCount();
+				uv_total += chunk.attributes.UvCount();
+				normal_total += chunk.attributes.NormalCount();
+			}
+			attributes.positions.resize(position_total * 3);
+			attributes.uvs.resize(uv_total * 2);
+			attributes.normals.resize(normal_total * 3);
+			job_system.ParallelFor(static_cast<uint32_t>(chunk_count), [&chunks, &attributes](uint32_t chunk_index) {
+				SObjAttributes& local = chunks[chunk_index].attributes;
+				std::copy(local.positions.begin(), local.positions.end(), attributes.positions.begin() + chunks[chunk_index].position_base * 3);
+				std::copy(local.uvs.begin(), local.uvs.end(), attributes.uvs.begin() + chunks[chunk_index].uv_base * 2);
+				std::copy(local.normals.begin(), local.normals.end(), attributes.normals.begin() + chunks[chunk_index].normal_base * 3);
+				local = SObjAttributes();
+			});
+		}
+
+		// 第三阶段: 各块解析全局索引并输出顶点, 索引暂时相对于块内第一个顶点
+		job_system.ParallelFor(static_cast<uint32_t>(chunk_count), [&chunks, &attributes](uint32_t chunk_index) {
+			EmitChunk(chunks[chunk_index], attributes);
+		});
+
+		// 第四阶段: 串行走一遍所有 o/g/usemtl 事件, 按单线程的规则切分子网格并算出每段索引的修正量
+		uint64_t vertex_total = 0;
+		uint64_t index_total = 0;
+		{
+			SGeometryDesc current{};
+			std::string   current_name;
+			for (SObjChunk& chunk : chunks)
+			{
+				chunk.vertex_base = vertex_total;
+				chunk.index_base = index_total;
+
+				uint32_t segment_begin = 0;
+				for (const SObjChunkEvent& event : chunk.events)
+				{
+					chunk.segments.push_back({ segment_begin, event.local_index_count, static_cast<int64_t>(chunk.vertex_base) - current.vertex_offset });
+					segment_begin = event.local_index_count;
+
+					FlushGeometry(current, current_name, static_cast<uint32_t>(chunk.vertex_base + event.local_vertex_count), static_cast<uint32_t>(chunk.index_base + event.local_index_count), out_mesh);
+					if (event.type == EObjChunkEvent::Group)
+					{
+						current_name = event.name;
+					}
+					else
+					{
+						current.material_index = FindOrAddMaterial(event.name, out_mesh);
+					}
+				}
+				chunk.segments.push_back({ segment_begin, static_cast<uint32_t>(chunk.indices.size()), static_cast<int64_t>(chunk.vertex_base) - current.vertex_offset });
+
+				if (!chunk.material_library.empty())
+				{
+					out_mesh.material_library = chunk.material_library;
+				}
+				vertex_total += chunk.vertices.size();
+				index_total += chunk.indices.size();
+			}
+			FlushGeometry(current, current_name, static_cast<uint32_t>(vertex_total), static_cast<uint32_t>(index_total), out_mesh);
+		}
+
+		// 第五阶段: 并行拷贝到最终数组, 同时修正索引
+		out_mesh.vertices.resize(vertex_total);
+		out_mesh.indices.resize(index_total);
+		job_system.ParallelFor(static_cast<uint32_t>(chunk_count), [&chunks, &out_mesh](uint32_t chunk_index) {
+			SObjChunk& chunk = chunks[chunk_index];
+			std::copy(chunk.vertices.begin(), chunk.vertices.end(), out_mesh.vertices.begin() + chunk.vertex_base);
+			IndexType* out_indices = out_mesh.indices.data() + chunk.index_base;
+			for (const SObjIndexSegment& segment : chunk.segments)
+			{
+				const IndexType fixup = static_cast<IndexType>(segment.fixup);
+				for (uint32_t i = segment.index_begin; i < segment.index_end; ++i)
+				{
+					out_indices[i] = chunk.indices[i] + fixup;
+				}
+			}
+			chunk.vertices = std::vector<SVertexInstance>();
+			chunk.indices = std::vector<IndexType>();
+		});
+
+		return !out_mesh.geometries.empty();
+	}
+}
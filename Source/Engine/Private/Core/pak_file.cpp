@@ -0,0 +1,510 @@
+﻿#include "Core/pak_file.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "Core/deflate.h"
+#include "Core/inflate.h"
+#include "Core/job_system.h"
+#include "Core/lz_codec.h"
+
+namespace FireEngine
+{
+	namespace
+	{
+		constexpr uint64_t c_fnv_offset_basis = 14695981039346656037ull;
+		constexpr uint64_t c_fnv_prime = 1099511628211ull;
+
+		uint64_t AlignOffset(uint64_t offset, uint64_t alignment)
+		{
+			return (offset + alignment - 1) & ~(alignment - 1);
+		}
+
+		void WritePadding(std::ofstream& file, uint64_t target_offset)
+		{
+			static const char zeros[c_pak_entry_alignment] = {};
+			const uint64_t current = static_cast<uint64_t>(file.tellp());
+			file.write(zeros, static_cast<std::streamsize>(target_offset - current));
+		}
+
+		size_t SkipPathPrefix(std::string_view path)
+		{
+			size_t begin = 0;
+			while (begin < path.size())
+			{
+				if (path[begin] == '/' || path[begin] == '\\')
+				{
+					++begin;
+				}
+				else if (path[begin] == '.' && begin + 1 < path.size() && (path[begin + 1] == '/' || path[begin + 1] == '\\'))
+				{
+					begin += 2;
+				}
+				else
+				{
+					break;
+				}
+			}
+			return begin;
+		}
+
+		struct SPendingEntry
+		{
+			SPakEntry            entry;
+			std::string          path;
+			std::vector<uint8_t> data;
+		};
+
+		// 每块独立压缩, 压不小的块原样存储
+		bool CompressLzChunks(const std::vector<uint8_t>& data, std::vector<uint8_t>& out_data, CJobSystem* job_system)
+		{
+			const uint64_t chunk_count = (data.size() + c_pak_chunk_size - 1) / c_pak_chunk_size;
+			if (chunk_count > UINT32_MAX)
+			{
+				return false;
+			}
+			std::vector<std::vector<uint8_t>> chunks(chunk_count);
+			auto compress_chunk = [&](uint32_t chunk) {
+				const uint64_t begin = static_cast<uint64_t>(chunk) * c_pak_chunk_size;
+				const uint64_t size = std::min<uint64_t>(c_pak_chunk_size, data.size() - begin);
+				std::vector<uint8_t>& compressed = chunks[chunk];
+				compressed.resize(LzCompressBound(size));
+				const uint64_t compressed_size = LzCompress(data.data() + begin, size, compressed.data(), compressed.size());
+				if (compressed_size == 0 || compressed_size >= size)
+				{
+					compressed.assign(data.begin() + begin, data.begin() + begin + size);
+				}
+				else
+				{
+					compressed.resize(compressed_size);
+				}
+			};
+			if (job_system && chunk_count > 1)
+			{
+				job_system->ParallelFor(static_cast<uint32_t>(chunk_count), compress_chunk);
+			}
+			else
+			{
+				for (uint32_t chunk = 0; chunk < chunk_count; ++chunk)
+				{
+					compress_chunk(chunk);
+				}
+			}
+
+			const SPakChunkTable table{ c_pak_chunk_size, static_cast<uint32_t>(chunk_count) };
+			std::vector<uint64_t> chunk_offsets(chunk_count + 1);
+			chunk_offsets[0] = sizeof(SPakChunkTable) + chunk_offsets.size() * sizeof(uint64_t);
+			for (uint64_t chunk = 0; chunk < chunk_count; ++chunk)
+			{
+				chunk_offsets[chunk + 1] = chunk_offsets[chunk] + chunks[chunk].size();
+			}
+			const auto* table_bytes = reinterpret_cast<const uint8_t*>(&table);
+			const auto* offset_bytes = reinterpret_cast<const uint8_t*>(chunk_offsets.data());
+			out_data.clear();
+			out_data.reserve(chunk_offsets.back());
+			out_data.insert(out_data.end(), table_bytes, table_bytes + sizeof(table));
+			out_data.insert(out_data.end(), offset_bytes, offset_bytes + chunk_offsets.size() * sizeof(uint64_t));
+			for (const std::vector<uint8_t>& chunk : chunks)
+			{
+				out_data.insert(out_data.end(), chunk.begin(), chunk.end());
+			}
+			return true;
+		}
+
+		// 校验分块表头, 块偏移在解压每个块时再检查
+		bool GetChunkTable(const SByteView& stored, uint64_t uncompressed_size, SPakChunkTable& out_table, const uint64_t*& out_offsets)
+		{
+			// LZ 的压缩比不超过255, 先排除明显伪造的大小, 避免按它分配内存
+			if (stored.size < sizeof(SPakChunkTable) || uncompressed_size / 255 > stored.size)
+			{
+				return false;
+			}
+			memcpy(&out_table, stored.data, sizeof(out_table));
+			if (out_table.chunk_size == 0 || out_table.chunk_size > c_lz_max_block_size
+				|| out_table.chunk_count != (uncompressed_size + out_table.chunk_size - 1) / out_table.chunk_size
+				|| (out_table.chunk_count + 1ull) * sizeof(uint64_t) > stored.size - sizeof(SPakChunkTable))
+			{
+				return false;
+			}
+			// 条目按页对齐, 偏移表紧跟8字节的表头, 是8字节对齐的
+			out_offsets = reinterpret_cast<const uint64_t*>(stored.data + sizeof(SPakChunkTable));
+			return true;
+		}
+
+		bool DecompressChunk(const SByteView& stored, const SPakChunkTable& table, const uint64_t* chunk_offsets, uint64_t uncompressed_size, uint32_t chunk, uint8_t* out_data)
+		{
+			const uint64_t begin = chunk_offsets[chunk];
+			const uint64_t end = chunk_offsets[chunk + 1];
+			if (begin > end || end > stored.size)
+			{
+				return false;
+			}
+			const uint64_t chunk_begin = static_cast<uint64_t>(chunk) * table.chunk_size;
+			const uint64_t chunk_size = std::min<uint64_t>(table.chunk_size, uncompressed_size - chunk_begin);
+			if (end - begin == chunk_size)
+			{
+				memcpy(out_data, stored.data + begin, chunk_size);
+				return true;
+			}
+			return LzDecompress(stored.data + begin, end - begin, out_data, chunk_size);
+		}
+
+		// 解压 [first_chunk, first_chunk + count) 到 get_output(chunk) 指向的位置, 块数多于一个时并行
+		template <typename FGetOutput>
+		bool DecompressChunks(const SByteView& stored, const SPakChunkTable& table, const uint64_t* chunk_offsets, uint64_t uncompressed_size,
+			uint32_t first_chunk, uint32_t count, CJobSystem* job_system, const FGetOutput& get_output)
+		{
+			std::atomic<bool> success{ true };
+			auto decompress_chunk = [&](uint32_t index) {
+				const uint32_t chunk = first_chunk + index;
+				if (!DecompressChunk(stored, table, chunk_offsets, uncompressed_size, chunk, get_output(chunk)))
+				{
+					success.store(false, std::memory_order_relaxed);
+				}
+			};
+			if (job_system && count > 1)
+			{
+				job_system->ParallelFor(count, decompress_chunk);
+			}
+			else
+			{
+				for (uint32_t index = 0; index < count; ++index)
+				{
+					decompress_chunk(index);
+				}
+			}
+			return success.load(std::memory_order_relaxed);
+		}
+	}
+
+	std::string NormalizePath(std::string_view path)
+	{
+		std::string normalized(path.substr(SkipPathPrefix(path)));
+		std::replace(normalized.begin(), normalized.end(), '\\', '/');
+		return normalized;
+	}
+
+	FPathHash HashPath(std::string_view path)
+	{
+		uint64_t hash = c_fnv_offset_basis;
+		for (size_t i = SkipPathPrefix(path); i < path.size(); ++i)
+		{
+			char c = path[i];
+			if (c == '\\')
+			{
+				c = '/';
+			}
+			else if (c >= 'A' && c <= 'Z')
+			{
+				c = static_cast<char>(c - 'A' + 'a');
+			}
+			hash = (hash ^ static_cast<uint8_t>(c)) * c_fnv_prime;
+		}
+		return hash;
+	}
+
+	bool WritePak(const std::string& pak_file_name, const std::vector<SPakSource>& sources, EPakCompression compression, CJobSystem* job_system)
+	{
+		// 先把所有文件读进内存并按哈希排序, 目录表和数据区的顺序一致
+		std::vector<SPendingEntry> pending(sources.size());
+		for (size_t i = 0; i < sources.size(); ++i)
+		{
+			SPendingEntry& item = pending[i];
+			item.path = NormalizePath(sources[i].path);
+			item.entry = {};
+			item.entry.path_hash = HashPath(item.path);
+			item.entry.compression = static_cast<uint32_t>(EPakCompression::None);
+
+			CMappedFile file;
+			if (!file.Open(sources[i].file_name))
+			{
+				printf("[error]:pak source %s open failed!\n", sources[i].file_name.c_str());
+				return false;
+			}
+			item.entry.uncompressed_size = file.GetSize();
+			item.data.assign(file.GetData(), file.GetData() + file.GetSize());
+			std::vector<uint8_t> compressed;
+			const bool compressed_ok = compression == EPakCompression::Zlib ? ZlibDeflate(item.data.data(), item.data.size(), compressed)
+				: compression == EPakCompression::Lz ? CompressLzChunks(item.data, compressed, job_system) : false;
+			if (!item.data.empty() && compressed_ok && compressed.size() <= item.data.size() - item.data.size() / 8)
+			{
+				item.data = std::move(compressed);
+				item.entry.compression = static_cast<uint32_t>(compression);
+			}
+			item.entry.size = item.data.size();
+		}
+		std::sort(pending.begin(), pending.end(), [](const SPendingEntry& a, const SPendingEntry& b) { return a.entry.path_hash < b.entry.path_hash; });
+		for (size_t i = 1; i < pending.size(); ++i)
+		{
+			if (pending[i].entry.path_hash == pending[i - 1].entry.path_hash)
+			{
+				printf("[error]:pak path %s collides with %s!\n", pending[i].path.c_str(), pending[i - 1].path.c_str());
+				return false;
+			}
+		}
+
+		SPakHeader header{};
+		header.magic = c_pak_magic;
+		header.version = c_pak_version;
+		header.entry_count = static_cast<uint32_t>(pending.size());
+		header.entry_stride = sizeof(SPakEntry);
+		header.entry_offset = AlignOffset(sizeof(SPakHeader), alignof(SPakEntry));
+		header.string_offset = header.entry_offset + pending.size() * sizeof(SPakEntry);
+		for (SPendingEntry& item : pending)
+		{
+			item.entry.name_offset = static_cast<uint32_t>(header.string_size);
+			header.string_size += item.path.size() + 1;
+		}
+		uint64_t offset = header.string_offset + header.string_size;
+		for (SPendingEntry& item : pending)
+		{
+			item.entry.offset = AlignOffset(offset, c_pak_entry_alignment);
+			offset = item.entry.offset + item.entry.size;
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(pak_file_name).parent_path(), error);
+
+		// 先写唯一命名的临时文件再改名, 避免运行时映射到写了一半的文件, 也避免并发打包互相覆盖
+		const std::string temp_file_name = MakeTempFileName(pak_file_name);
+		{
+			std::ofstream file(temp_file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				printf("[error]:pak %s create failed!\n", temp_file_name.c_str());
+				return false;
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			WritePadding(file, header.entry_offset);
+			for (const SPendingEntry& item : pending)
+			{
+				file.write(reinterpret_cast<const char*>(&item.entry), sizeof(SPakEntry));
+			}
+			for (const SPendingEntry& item : pending)
+			{
+				file.write(item.path.c_str(), static_cast<std::streamsize>(item.path.size() + 1));
+			}
+			for (const SPendingEntry& item : pending)
+			{
+				WritePadding(file, item.entry.offset);
+				file.write(reinterpret_cast<const char*>(item.data.data()), static_cast<std::streamsize>(item.data.size()));
+			}
+			file.close();
+			if (!file)
+			{
+				printf("[error]:pak %s write failed!\n", temp_file_name.c_str());
+				std::filesystem::remove(temp_file_name, error);
+				return false;
+			}
+		}
+		std::filesystem::rename(temp_file_name, pak_file_name, error);
+		if (error)
+		{
+			printf("[error]:pak %s rename failed: %s!\n", pak_file_name.c_str(), error.message().c_str());
+			std::filesystem::remove(temp_file_name, error);
+			return false;
+		}
+		return true;
+	}
+
+	bool WritePakFromDirectory(const std::string& pak_file_name, const std::string& directory, EPakCompression compression, CJobSystem* job_system)
+	{
+		std::vector<SPakSource> sources;
+		std::error_code error;
+		for (auto it = std::filesystem::recursive_directory_iterator(directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+		{
+			if (it->is_regular_file(error))
+			{
+				const std::filesystem::path relative_path = std::filesystem::relative(it->path(), directory, error);
+				sources.push_back({ relative_path.generic_string(), it->path().string() });
+			}
+		}
+		if (error)
+		{
+			printf("[error]:pak directory %s walk failed!\n", directory.c_str());
+			return false;
+		}
+		return WritePak(pak_file_name, sources, compression, job_system);
+	}
+
+	bool CPakFile::Open(const std::string& pak_file_name)
+	{
+		m_header = nullptr;
+		m_entries = nullptr;
+		if (!m_mapped_file.Open(pak_file_name))
+		{
+			return false;
+		}
+
+		const uint64_t file_size = m_mapped_file.GetSize();
+		if (file_size < sizeof(SPakHeader))
+		{
+			m_mapped_file.Close();
+			return false;
+		}
+
+		// 只校验文件头和表的范围, 条目的范围在读取时校验, 挂载的代价与条目数无关
+		const auto* header = reinterpret_cast<const SPakHeader*>(m_mapped_file.GetData());
+		const bool valid = header->magic == c_pak_magic
+			&& header->version == c_pak_version
+			&& header->entry_stride == sizeof(SPakEntry)
+			&& header->entry_offset % alignof(SPakEntry) == 0
+			&& header->entry_offset <= file_size
+			&& header->entry_count <= (file_size - header->entry_offset) / sizeof(SPakEntry)
+			&& header->string_offset <= file_size
+			&& header->string_size <= file_size - header->string_offset;
+		if (!valid)
+		{
+			m_mapped_file.Close();
+			return false;
+		}
+		m_header = header;
+		m_entries = reinterpret_cast<const SPakEntry*>(m_mapped_file.GetData() + header->entry_offset);
+		return true;
+	}
+
+	const SPakEntry* CPakFile::Find(FPathHash path_hash) const
+	{
+		if (!m_header)
+		{
+			return nullptr;
+		}
+		const SPakEntry* end = m_entries + m_header->entry_count;
+		const SPakEntry* it = std::lower_bound(m_entries, end, path_hash, [](const SPakEntry& entry, FPathHash hash) { return entry.path_hash < hash; });
+		return it != end && it->path_hash == path_hash ? it : nullptr;
+	}
+
+	bool CPakFile::Read(const SPakEntry& entry, SFileData& out_file, CJobSystem* job_system) const
+	{
+		out_file.mapped_file.Close();
+		out_file.buffer.clear();
+		out_file.view = {};
+
+		const uint64_t file_size = m_mapped_file.GetSize();
+		if (!m_header || entry.offset > file_size || entry.size > file_size - entry.offset)
+		{
+			return false;
+		}
+		const SByteView stored{ m_mapped_file.GetData() + entry.offset, entry.size };
+		switch (static_cast<EPakCompression>(entry.compression))
+		{
+		case EPakCompression::None:
+			if (entry.size != entry.uncompressed_size)
+			{
+				return false;
+			}
+			out_file.view = stored;
+			return true;
+		case EPakCompression::Zlib:
+		{
+			// 不信任文件中的大小, 解压结果必须正好填满
+			if (entry.uncompressed_size > entry.size * 1032 + 64)
+			{
+				return false;
+			}
+			out_file.buffer.resize(entry.uncompressed_size);
+			uint64_t out_size = 0;
+			if (!ZlibInflate(stored, out_file.buffer.data(), out_file.buffer.size(), out_size) || out_size != entry.uncompressed_size)
+			{
+				out_file.buffer.clear();
+				return false;
+			}
+			out_file.view = { out_file.buffer.data(), out_file.buffer.size() };
+			return true;
+		}
+		case EPakCompression::Lz:
+		{
+			// 每块都直接解压到 buffer 中的最终位置
+			SPakChunkTable  table;
+			const uint64_t* chunk_offsets = nullptr;
+			if (!GetChunkTable(stored, entry.uncompressed_size, table, chunk_offsets))
+			{
+				return false;
+			}
+			out_file.buffer.resize(entry.uncompressed_size);
+			uint8_t* out_data = out_file.buffer.data();
+			if (!DecompressChunks(stored, table, chunk_offsets, entry.uncompressed_size, 0, table.chunk_count, job_system,
+				[out_data, &table](uint32_t chunk) { return out_data + static_cast<uint64_t>(chunk) * table.chunk_size; }))
+			{
+				out_file.buffer.clear();
+				return false;
+			}
+			out_file.view = { out_file.buffer.data(), out_file.buffer.size() };
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+
+	bool CPakFile::ReadRange(const SPakEntry& entry, uint64_t offset, uint64_t size, uint8_t* out_data, CJobSystem* job_system) const
+	{
+		const uint64_t file_size = m_mapped_file.GetSize();
+		if (!m_header || entry.offset > file_size || entry.size > file_size - entry.offset
+			|| offset > entry.uncompressed_size || size > entry.uncompressed_size - offset)
+		{
+			return false;
+		}
+		if (size == 0)
+		{
+			return true;
+		}
+		const SByteView stored{ m_mapped_file.GetData() + entry.offset, entry.size };
+		if (static_cast<EPakCompression>(entry.compression) != EPakCompression::Lz)
+		{
+			if (static_cast<EPakCompression>(entry.compression) == EPakCompression::None)
+			{
+				memcpy(out_data, stored.data + offset, size);
+				return true;
+			}
+			SFileData file;
+			if (!Read(entry, file, job_system))
+			{
+				return false;
+			}
+			memcpy(out_data, file.view.data + offset, size);
+			return true;
+		}
+
+		SPakChunkTable  table;
+		const uint64_t* chunk_offsets = nullptr;
+		if (!GetChunkTable(stored, entry.uncompressed_size, table, chunk_offsets))
+		{
+			return false;
+		}
+		const uint32_t first_chunk = static_cast<uint32_t>(offset / table.chunk_size);
+		const uint32_t last_chunk = static_cast<uint32_t>((offset + size - 1) / table.chunk_size);
+		const uint64_t range_begin = static_cast<uint64_t>(first_chunk) * table.chunk_size;
+		const uint64_t range_end = std::min<uint64_t>(static_cast<uint64_t>(last_chunk + 1) * table.chunk_size, entry.uncompressed_size);
+		// 范围正好落在块边界上时直接解压到 out_data, 否则先解压到临时缓冲再拷出需要的部分
+		if (range_begin == offset && range_end == offset + size)
+		{
+			return DecompressChunks(stored, table, chunk_offsets, entry.uncompressed_size, first_chunk, last_chunk - first_chunk + 1, job_system,
+				[out_data, range_begin, &table](uint32_t chunk) { return out_data + static_cast<uint64_t>(chunk) * table.chunk_size - range_begin; });
+		}
+		std::vector<uint8_t> chunk_data(range_end - range_begin);
+		if (!DecompressChunks(stored, table, chunk_offsets, entry.uncompressed_size, first_chunk, last_chunk - first_chunk + 1, job_system,
+			[&chunk_data, range_begin, &table](uint32_t chunk) { return chunk_data.data() + static_cast<uint64_t>(chunk) * table.chunk_size - range_begin; }))
+		{
+			return false;
+		}
+		memcpy(out_data, chunk_data.data() + (offset - range_begin), size);
+		return true;
+	}
+
+	const char* CPakFile::GetEntryName(const SPakEntry& entry) const
+	{
+		if (!m_header || entry.name_offset >= m_header->string_size)
+		{
+			return "";
+		}
+		const char* name = reinterpret_cast<const char*>(m_mapped_file.GetData() + m_header->string_offset + entry.name_offset);
+		// 最后一个字符串可能被截断, 没有结尾的 '\0' 时不返回
+		const char* end = reinterpret_cast<const char*>(m_mapped_file.GetData() + m_header->string_offset + m_header->string_size);
+		return std::find(name, end, '\0') != end ? name : "";
+	}
+}
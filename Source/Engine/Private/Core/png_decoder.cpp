@@ -0,0 +1,608 @@
+﻿#include "Core/png_decoder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FIRE_ENGINE_PNG_SSE2 1
+#include <emmintrin.h>
+#else
+#define FIRE_ENGINE_PNG_SSE2 0
+#endif
+
+#include "Core/inflate.h"
+#include "Core/job_system.h"
+
+namespace FireEngine
+{
+	namespace
+	{
+		constexpr uint8_t  c_png_signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		constexpr uint32_t c_expand_block_rows = 64;
+		constexpr uint32_t c_min_segment_rows = 64;
+
+		enum EPngColorType : uint8_t
+		{
+			Gray = 0,
+			Rgb = 2,
+			Palette = 3,
+			GrayAlpha = 4,
+			Rgba = 6,
+		};
+
+		enum EPngFilter : uint8_t
+		{
+			FilterNone = 0,
+			FilterSub = 1,
+			FilterUp = 2,
+			FilterAverage = 3,
+			FilterPaeth = 4,
+		};
+
+		inline uint32_t LoadBigEndian32(const uint8_t* data)
+		{
+			return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) | data[3];
+		}
+
+		inline uint8_t Paeth(int32_t left, int32_t up, int32_t up_left)
+		{
+			const int32_t estimate = left + up - up_left;
+			const int32_t distance_left = std::abs(estimate - left);
+			const int32_t distance_up = std::abs(estimate - up);
+			const int32_t distance_up_left = std::abs(estimate - up_left);
+			if (distance_left <= distance_up && distance_left <= distance_up_left)
+			{
+				return static_cast<uint8_t>(left);
+			}
+			return static_cast<uint8_t>(distance_up <= distance_up_left ? up : up_left);
+		}
+
+#if FIRE_ENGINE_PNG_SSE2
+		// 一次处理一个像素(3/4/6/8字节), 像素之间的依赖无法在行内并行, 只能在像素内的通道间并行
+		// 像素大小作为模板参数, 3/6字节的像素拆成定长的读写在寄存器里拼接, 避免经过栈上的临时变量
+		template <uint32_t Bpp>
+		inline __m128i LoadPixel(const uint8_t* pixel)
+		{
+			uint32_t low = 0;
+			uint32_t high = 0;
+			if (Bpp == 3)
+			{
+				uint16_t word;
+				memcpy(&word, pixel, 2);
+				low = word | (static_cast<uint32_t>(pixel[2]) << 16);
+			}
+			else if (Bpp == 6)
+			{
+				uint16_t word;
+				memcpy(&low, pixel, 4);
+				memcpy(&word, pixel + 4, 2);
+				high = word;
+			}
+			else
+			{
+				memcpy(&low, pixel, 4);
+				if (Bpp == 8)
+				{
+					memcpy(&high, pixel + 4, 4);
+				}
+			}
+			return _mm_unpacklo_epi32(_mm_cvtsi32_si128(static_cast<int32_t>(low)), _mm_cvtsi32_si128(static_cast<int32_t>(high)));
+		}
+
+		template <uint32_t Bpp>
+		inline void StorePixel(uint8_t* pixel, __m128i value)
+		{
+			const uint32_t low = static_cast<uint32_t>(_mm_cvtsi128_si32(value));
+			if (Bpp == 3)
+			{
+				const uint16_t word = static_cast<uint16_t>(low);
+				memcpy(pixel, &word, 2);
+				pixel[2] = static_cast<uint8_t>(low >> 16);
+				return;
+			}
+			memcpy(pixel, &low, 4);
+			if (Bpp > 4)
+			{
+				const uint32_t high = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(value, 4)));
+				memcpy(pixel + 4, &high, Bpp - 4);
+			}
+		}
+
+		void UnfilterUpSse2(const uint8_t* src, const uint8_t* prev, uint8_t* dst, uint32_t row_bytes)
+		{
+			uint32_t i = 0;
+			for (; i + 16 <= row_bytes; i += 16)
+			{
+				const __m128i value = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), value);
+			}
+			for (; i < row_bytes; ++i)
+			{
+				dst[i] = static_cast<uint8_t>(src[i] + prev[i]);
+			}
+		}
+
+		template <uint32_t Bpp>
+		void UnfilterSubSse2(const uint8_t* src, uint8_t* dst, uint32_t row_bytes)
+		{
+			__m128i left = _mm_setzero_si128();
+			for (uint32_t i = 0; i < row_bytes; i += Bpp)
+			{
+				left = _mm_add_epi8(left, LoadPixel<Bpp>(src + i));
+				StorePixel<Bpp>(dst + i, left);
+			}
+		}
+
+		template <uint32_t Bpp>
+		void UnfilterAverageSse2(const uint8_t* src, const uint8_t* prev, uint8_t* dst, uint32_t row_bytes)
+		{
+			// _mm_avg_epu8 向上取整, 两数奇偶不同时减一得到向下取整
+			const __m128i one = _mm_set1_epi8(1);
+			__m128i left = _mm_setzero_si128();
+			for (uint32_t i = 0; i < row_bytes; i += Bpp)
+			{
+				const __m128i up = LoadPixel<Bpp>(prev + i);
+				__m128i average = _mm_avg_epu8(left, up);
+				average = _mm_sub_epi8(average, _mm_and_si128(_mm_xor_si128(left, up), one));
+				left = _mm_add_epi8(LoadPixel<Bpp>(src + i), average);
+				StorePixel<Bpp>(dst + i, left);
+			}
+		}
+
+		inline __m128i AbsEpi16(__m128i value)
+		{
+			return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+		}
+
+		inline __m128i Select(__m128i mask, __m128i if_true, __m128i if_false)
+		{
+			return _mm_or_si128(_mm_and_si128(mask, if_true), _mm_andnot_si128(mask, if_false));
+		}
+
+		template <uint32_t Bpp>
+		void UnfilterPaethSse2(const uint8_t* src, const uint8_t* prev, uint8_t* dst, uint32_t row_bytes)
+		{
+			// 展开成16位计算预测距离, 平局时依次偏向 左/上/左上
+			const __m128i zero = _mm_setzero_si128();
+			__m128i left = zero;
+			__m128i up_left = zero;
+			for (uint32_t i = 0; i < row_bytes; i += Bpp)
+			{
+				const __m128i up = _mm_unpacklo_epi8(LoadPixel<Bpp>(prev + i), zero);
+				const __m128i up_minus_up_left = _mm_sub_epi16(up, up_left);
+				const __m128i left_minus_up_left = _mm_sub_epi16(left, up_left);
+				const __m128i distance_left = AbsEpi16(up_minus_up_left);
+				const __m128i distance_up = AbsEpi16(left_minus_up_left);
+				const __m128i distance_up_left = AbsEpi16(_mm_add_epi16(up_minus_up_left, left_minus_up_left));
+				const __m128i smallest = _mm_min_epi16(distance_up_left, _mm_min_epi16(distance_left, distance_up));
+				const __m128i predictor = Select(_mm_cmpeq_epi16(smallest, distance_left), left,
+					Select(_mm_cmpeq_epi16(smallest, distance_up), up, up_left));
+				// 按字节相加才能得到模256的结果, 高字节始终为0
+				left = _mm_add_epi8(_mm_unpacklo_epi8(LoadPixel<Bpp>(src + i), zero), predictor);
+				StorePixel<Bpp>(dst + i, _mm_packus_epi16(left, left));
+				up_left = up;
+			}
+		}
+
+		template <uint32_t Bpp>
+		bool UnfilterRowSse2(uint8_t filter, const uint8_t* src, const uint8_t* prev, uint8_t* dst, uint32_t row_bytes)
+		{
+			switch (filter)
+			{
+			case FilterSub:
+				UnfilterSubSse2<Bpp>(src, dst, row_bytes);
+				return true;
+			case FilterAverage:
+				UnfilterAverageSse2<Bpp>(src, prev, dst, row_bytes);
+				return true;
+			case FilterPaeth:
+				UnfilterPaethSse2<Bpp>(src, prev, dst, row_bytes);
+				return true;
+			default:
+				return false;
+			}
+		}
+#endif
+
+		// src 与 dst 可以是同一行; prev 为空时按全零的上一行处理
+		bool UnfilterRow(uint8_t filter, const uint8_t* src, const uint8_t* prev, uint8_t* dst, uint32_t row_bytes, uint32_t bpp)
+		{
+#if FIRE_ENGINE_PNG_SSE2
+			if (prev && filter == FilterUp)
+			{
+				UnfilterUpSse2(src, prev, dst, row_bytes);
+				return true;
+			}
+			// Avg/Paeth 的第一行没有上一行, 交给标量版本
+			if (prev || filter == FilterSub)
+			{
+				switch (bpp)
+				{
+				case 3: if (UnfilterRowSse2<3>(filter, src, prev, dst, row_bytes)) return true; break;
+				case 4: if (UnfilterRowSse2<4>(filter, src, prev, dst, row_bytes)) return true; break;
+				case 6: if (UnfilterRowSse2<6>(filter, src, prev, dst, row_bytes)) return true; break;
+				case 8: if (UnfilterRowSse2<8>(filter, src, prev, dst, row_bytes)) return true; break;
+				default: break;
+				}
+			}
+#endif
+			switch (filter)
+			{
+			case FilterNone:
+				if (dst != src)
+				{
+					memcpy(dst, src, row_bytes);
+				}
+				return true;
+			case FilterSub:
+				for (uint32_t i = 0; i < bpp && i < row_bytes; ++i)
+				{
+					dst[i] = src[i];
+				}
+				for (uint32_t i = bpp; i < row_bytes; ++i)
+				{
+					dst[i] = static_cast<uint8_t>(src[i] + dst[i - bpp]);
+				}
+				return true;
+			case FilterUp:
+				if (!prev)
+				{
+					return UnfilterRow(FilterNone, src, prev, dst, row_bytes, bpp);
+				}
+				for (uint32_t i = 0; i < row_bytes; ++i)
+				{
+					dst[i] = static_cast<uint8_t>(src[i] + prev[i]);
+				}
+				return true;
+			case FilterAverage:
+				for (uint32_t i = 0; i < row_bytes; ++i)
+				{
+					const uint32_t left = i >= bpp ? dst[i - bpp] : 0;
+					const uint32_t up = prev ? prev[i] : 0;
+					dst[i] = static_cast<uint8_t>(src[i] + ((left + up) >> 1));
+				}
+				return true;
+			case FilterPaeth:
+				if (!prev)
+				{
+					return UnfilterRow(FilterSub, src, prev, dst, row_bytes, bpp);
+				}
+				for (uint32_t i = 0; i < row_bytes; ++i)
+				{
+					const int32_t left = i >= bpp ? dst[i - bpp] : 0;
+					const int32_t up_left = i >= bpp ? prev[i - bpp] : 0;
+					dst[i] = static_cast<uint8_t>(src[i] + Paeth(left, prev[i], up_left));
+				}
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		struct SPngChunks
+		{
+			const uint8_t*              palette{ nullptr };
+			uint32_t                    palette_size{ 0 };
+			const uint8_t*              transparency{ nullptr };
+			uint32_t                    transparency_size{ 0 };
+			std::vector<SByteView>      image_data;
+		};
+
+		bool CollectChunks(const SByteView& data, SPngChunks& out_chunks)
+		{
+			uint64_t offset = sizeof(c_png_signature);
+			while (offset + 12 <= data.size)
+			{
+				const uint32_t       length = LoadBigEndian32(data.data + offset);
+				const uint8_t*       type = data.data + offset + 4;
+				const uint8_t*       chunk_data = data.data + offset + 8;
+				if (length > data.size - offset - 12)
+				{
+					return false;
+				}
+				if (memcmp(type, "IDAT", 4) == 0)
+				{
+					out_chunks.image_data.push_back({ chunk_data, length });
+				}
+				else if (memcmp(type, "PLTE", 4) == 0)
+				{
+					out_chunks.palette = chunk_data;
+					out_chunks.palette_size = length / 3;
+				}
+				else if (memcmp(type, "tRNS", 4) == 0)
+				{
+					out_chunks.transparency = chunk_data;
+					out_chunks.transparency_size = length;
+				}
+				else if (memcmp(type, "IEND", 4) == 0)
+				{
+					return !out_chunks.image_data.empty();
+				}
+				offset += 12ull + length;
+			}
+			return !out_chunks.image_data.empty();
+		}
+
+		// 把反滤波后的一行展开成 RGBA8
+		class CRowExpander
+		{
+		public:
+			CRowExpander(const SPngInfo& info, const SPngChunks& chunks) : m_info(info)
+			{
+				if (info.color_type == Palette)
+				{
+					for (uint32_t i = 0; i < 256; ++i)
+					{
+						m_palette[i][0] = m_palette[i][1] = m_palette[i][2] = 0;
+						m_palette[i][3] = 255;
+					}
+					for (uint32_t i = 0; i < chunks.palette_size && i < 256; ++i)
+					{
+						memcpy(m_palette[i], chunks.palette + i * 3, 3);
+					}
+					for (uint32_t i = 0; i < chunks.transparency_size && i < 256; ++i)
+					{
+						m_palette[i][3] = chunks.transparency[i];
+					}
+				}
+				else if (chunks.transparency && (info.color_type == Gray || info.color_type == Rgb))
+				{
+					// 颜色键按16位存放, 8位图只用低字节
+					const uint32_t key_count = info.color_type == Gray ? 1 : 3;
+					if (chunks.transparency_size >= key_count * 2)
+					{
+						m_has_color_key = true;
+						for (uint32_t i = 0; i < key_count; ++i)
+						{
+							m_color_key[i] = static_cast<uint16_t>((chunks.transparency[i * 2] << 8) | chunks.transparency[i * 2 + 1]);
+						}
+					}
+				}
+			}
+
+			void Expand(const uint8_t* src, uint8_t* dst) const
+			{
+				const uint32_t width = m_info.width;
+				const uint32_t sample_bytes = m_info.bit_depth / 8;
+				auto sample = [sample_bytes](const uint8_t* p) -> uint16_t {
+					return sample_bytes == 2 ? static_cast<uint16_t>((p[0] << 8) | p[1]) : p[0];
+				};
+
+				switch (m_info.color_type)
+				{
+				case Gray:
+					for (uint32_t x = 0; x < width; ++x, dst += 4)
+					{
+						const uint16_t value = sample(src + x * sample_bytes);
+						dst[0] = dst[1] = dst[2] = src[x * sample_bytes];
+						dst[3] = m_has_color_key && value == m_color_key[0] ? 0 : 255;
+					}
+					break;
+				case Rgb:
+					for (uint32_t x = 0; x < width; ++x, dst += 4)
+					{
+						const uint8_t* pixel = src + x * 3 * sample_bytes;
+						dst[0] = pixel[0];
+						dst[1] = pixel[sample_bytes];
+						dst[2] = pixel[sample_bytes * 2];
+						dst[3] = 255;
+						if (m_has_color_key && sample(pixel) == m_color_key[0] && sample(pixel + sample_bytes) == m_color_key[1] && sample(pixel + sample_bytes * 2) == m_color_key[2])
+						{
+							dst[3] = 0;
+						}
+					}
+					break;
+				case Palette:
+					for (uint32_t x = 0; x < width; ++x, dst += 4)
+					{
+						memcpy(dst, m_palette[src[x]], 4);
+					}
+					break;
+				case GrayAlpha:
+					for (uint32_t x = 0; x < width; ++x, dst += 4)
+					{
+						const uint8_t* pixel = src + x * 2 * sample_bytes;
+						dst[0] = dst[1] = dst[2] = pixel[0];
+						dst[3] = pixel[sample_bytes];
+					}
+					break;
+				case Rgba:
+					if (sample_bytes == 1)
+					{
+						memcpy(dst, src, static_cast<size_t>(width) * 4);
+						break;
+					}
+					// 16位只保留高字节
+					for (uint32_t x = 0; x < width * 4; ++x)
+					{
+						dst[x] = src[x * 2];
+					}
+					break;
+				default:
+					break;
+				}
+			}
+
+		private:
+			const SPngInfo& m_info;
+			uint8_t         m_palette[256][4];
+			bool            m_has_color_key{ false };
+			uint16_t        m_color_key[3]{};
+		};
+	}
+
+	bool ReadPngInfo(const SByteView& data, SPngInfo& out_info)
+	{
+		// 签名(8) + IHDR 长度和类型(8) + IHDR(13)
+		if (data.size < 29 || memcmp(data.data, c_png_signature, sizeof(c_png_signature)) != 0 || memcmp(data.data + 12, "IHDR", 4) != 0)
+		{
+			return false;
+		}
+		const uint8_t* ihdr = data.data + 16;
+		out_info.width = LoadBigEndian32(ihdr);
+		out_info.height = LoadBigEndian32(ihdr + 4);
+		out_info.bit_depth = ihdr[8];
+		out_info.color_type = ihdr[9];
+		out_info.interlace = ihdr[12];
+		switch (out_info.color_type)
+		{
+		case Gray:      out_info.channels = 1; break;
+		case Rgb:       out_info.channels = 3; break;
+		case Palette:   out_info.channels = 3; break;
+		case GrayAlpha: out_info.channels = 2; break;
+		case Rgba:      out_info.channels = 4; break;
+		default:        return false;
+		}
+		// 与 stb 一致, 带 tRNS 的灰度/RGB/调色板图多算一个透明通道
+		if (out_info.color_type == Gray || out_info.color_type == Rgb || out_info.color_type == Palette)
+		{
+			SPngChunks chunks;
+			if (CollectChunks(data, chunks) && chunks.transparency)
+			{
+				out_info.channels = out_info.color_type == Palette ? 4 : out_info.channels + 1;
+			}
+		}
+		// 损坏或恶意的文件头不能让调用者按 IHDR 的尺寸分配内存
+		return out_info.width > 0 && out_info.height > 0 && out_info.width <= c_png_max_dimension && out_info.height <= c_png_max_dimension
+			&& static_cast<uint64_t>(out_info.width) * out_info.height * 4 <= c_png_max_decoded_size;
+	}
+
+	bool IsPngDecodable(const SPngInfo& info)
+	{
+		if (info.interlace != 0)
+		{
+			return false;
+		}
+		if (info.color_type == Palette)
+		{
+			return info.bit_depth == 8;
+		}
+		return info.bit_depth == 8 || info.bit_depth == 16;
+	}
+
+	bool DecodePng(const SByteView& data, const SPngInfo& info, uint8_t* out_pixels, CJobSystem* job_system)
+	{
+		SPngChunks chunks;
+		if (!IsPngDecodable(info) || !CollectChunks(data, chunks))
+		{
+			return false;
+		}
+		// info 可能不是 ReadPngInfo 给的, 这里再检查一次, 之后的尺寸运算都不会溢出
+		if (info.width == 0 || info.height == 0 || info.width > c_png_max_dimension || info.height > c_png_max_dimension
+			|| static_cast<uint64_t>(info.width) * info.height * 4 > c_png_max_decoded_size)
+		{
+			return false;
+		}
+
+		// 调色板图每个像素只存一个下标, 颜色键不占文件里的通道
+		const uint32_t file_channels = info.color_type == Palette ? 1 : info.color_type == Rgb ? 3 : info.color_type == Gray ? 1 : info.channels;
+		const uint32_t bpp = file_channels * info.bit_depth / 8;
+		const uint64_t row_bytes = static_cast<uint64_t>(info.width) * bpp;
+		const uint64_t filtered_size = (row_bytes + 1) * info.height;
+
+		// 多个 IDAT 需要先拼起来; 只有一个时直接在原数据上解压
+		std::vector<uint8_t> compressed;
+		SByteView            compressed_view = chunks.image_data[0];
+		if (chunks.image_data.size() > 1)
+		{
+			uint64_t compressed_size = 0;
+			for (const SByteView& chunk : chunks.image_data)
+			{
+				compressed_size += chunk.size;
+			}
+			compressed.reserve(compressed_size);
+			for (const SByteView& chunk : chunks.image_data)
+			{
+				compressed.insert(compressed.end(), chunk.data, chunk.data + chunk.size);
+			}
+			compressed_view = { compressed.data(), compressed.size() };
+		}
+
+		std::vector<uint8_t> filtered(filtered_size);
+		uint64_t inflated_size = 0;
+		if (!ZlibInflate(compressed_view, filtered.data(), filtered_size, inflated_size) || inflated_size != filtered_size)
+		{
+			return false;
+		}
+
+		// None/Sub 滤波的行不依赖上一行, 从这些行切开的各段可以同时反滤波
+		// 8位RGBA直接反滤波到输出里, 其它格式先原地反滤波再展开
+		const bool       direct_output = info.color_type == Rgba && info.bit_depth == 8;
+		const uint32_t   height = info.height;
+		const uint32_t   worker_count = job_system ? job_system->GetWorkerCount() + 1 : 1;
+		const uint32_t   target_rows = std::max(c_min_segment_rows, height / (worker_count * 4));
+		std::vector<uint32_t> segment_starts;
+		segment_starts.emplace_back(0);
+		for (uint32_t y = 1; y < height; ++y)
+		{
+			const uint8_t filter = filtered[y * (row_bytes + 1)];
+			if ((filter == FilterNone || filter == FilterSub) && y - segment_starts.back() >= target_rows)
+			{
+				segment_starts.emplace_back(y);
+			}
+		}
+		segment_starts.emplace_back(height);
+
+		auto row_source = [&](uint32_t y) { return filtered.data() + y * (row_bytes + 1) + 1; };
+		auto row_target = [&](uint32_t y) { return direct_output ? out_pixels + static_cast<uint64_t>(y) * row_bytes : row_source(y); };
+		std::vector<uint8_t> segment_ok(segment_starts.size() - 1, 1);
+		auto unfilter_segment = [&](uint32_t segment) {
+			for (uint32_t y = segment_starts[segment]; y < segment_starts[segment + 1]; ++y)
+			{
+				const uint8_t  filter = row_source(y)[-1];
+				// 段首行是第0行或 None/Sub 行, 不需要上一行
+				const uint8_t* prev = y == segment_starts[segment] ? nullptr : row_target(y - 1);
+				if (!UnfilterRow(filter, row_source(y), prev, row_target(y), static_cast<uint32_t>(row_bytes), bpp))
+				{
+					segment_ok[segment] = 0;
+					return;
+				}
+			}
+		};
+		const uint32_t segment_count = static_cast<uint32_t>(segment_starts.size() - 1);
+		if (job_system && segment_count > 1)
+		{
+			job_system->ParallelFor(segment_count, unfilter_segment);
+		}
+		else
+		{
+			for (uint32_t segment = 0; segment < segment_count; ++segment)
+			{
+				unfilter_segment(segment);
+			}
+		}
+		if (std::find(segment_ok.begin(), segment_ok.end(), 0) != segment_ok.end())
+		{
+			return false;
+		}
+		if (direct_output)
+		{
+			return true;
+		}
+
+		CRowExpander   expander(info, chunks);
+		const uint32_t block_count = (height + c_expand_block_rows - 1) / c_expand_block_rows;
+		auto expand_block = [&](uint32_t block) {
+			const uint32_t row_end = std::min(height, (block + 1) * c_expand_block_rows);
+			for (uint32_t y = block * c_expand_block_rows; y < row_end; ++y)
+			{
+				expander.Expand(row_source(y), out_pixels + static_cast<uint64_t>(y) * info.width * 4);
+			}
+		};
+		if (job_system && block_count > 1)
+		{
+			job_system->ParallelFor(block_count, expand_block);
+		}
+		else
+		{
+			for (uint32_t block = 0; block < block_count; ++block)
+			{
+				expand_block(block);
+			}
+		}
+		return true;
+	}
+}
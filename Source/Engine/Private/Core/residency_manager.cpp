@@ -0,0 +1,190 @@
+﻿#include "Core/residency_manager.h"
+
+#include <cstdio>
+#include <utility>
+
+namespace FireEngine
+{
+	void CResidencyManager::SetBudget(EResidencyCategory category, uint64_t budget)
+	{
+		m_stats[static_cast<uint32_t>(category)].budget = budget;
+	}
+
+	void CResidencyManager::PrintStats() const
+	{
+		static const char* names[c_residency_category_count] = { "cpu payload", "gpu buffer", "gpu texture" };
+		for (uint32_t i = 0; i < c_residency_category_count; ++i)
+		{
+			const SResidencyStats& stats = m_stats[i];
+			const double budget = stats.budget == UINT64_MAX ? 0.0 : stats.budget / (1024.0 * 1024.0);
+			printf("[residency]:%s current %.1f MB, peak %.1f MB, budget %.1f MB, evicted %u (%.1f MB)\n", names[i],
+				stats.current / (1024.0 * 1024.0), stats.peak / (1024.0 * 1024.0), budget, stats.evicted_count, stats.evicted_bytes / (1024.0 * 1024.0));
+		}
+	}
+
+	FResidencyHandle CResidencyManager::Track(EResidencyCategory category, uint64_t size, FResidencyEvictCallback on_evict)
+	{
+		SEntry entry;
+		entry.category = category;
+		entry.size = size;
+		entry.last_access_frame = m_frame;
+		entry.on_evict = std::move(on_evict);
+		const FResidencyHandle handle = m_entries.Insert(std::move(entry));
+		Link(handle, *m_entries.Get(handle));
+
+		SResidencyStats& stats = m_stats[static_cast<uint32_t>(category)];
+		stats.current += size;
+		if (stats.current > stats.peak)
+		{
+			stats.peak = stats.current;
+		}
+		return handle;
+	}
+
+	void CResidencyManager::Untrack(FResidencyHandle handle)
+	{
+		if (SEntry* entry = m_entries.Get(handle))
+		{
+			Remove(handle, *entry);
+		}
+	}
+
+	void CResidencyManager::Resize(FResidencyHandle handle, uint64_t size)
+	{
+		SEntry* entry = m_entries.Get(handle);
+		if (!entry)
+		{
+			return;
+		}
+		SResidencyStats& stats = m_stats[static_cast<uint32_t>(entry->category)];
+		stats.current = stats.current - entry->size + size;
+		if (stats.current > stats.peak)
+		{
+			stats.peak = stats.current;
+		}
+		entry->size = size;
+	}
+
+	void CResidencyManager::Touch(FResidencyHandle handle)
+	{
+		SEntry* entry = m_entries.Get(handle);
+		if (!entry)
+		{
+			return;
+		}
+		entry->last_access_frame = m_frame;
+		if (entry->pin_count == 0)
+		{
+			Unlink(*entry);
+			Link(handle, *entry);
+		}
+	}
+
+	void CResidencyManager::Pin(FResidencyHandle handle)
+	{
+		SEntry* entry = m_entries.Get(handle);
+		if (entry && entry->pin_count++ == 0)
+		{
+			Unlink(*entry);
+		}
+	}
+
+	void CResidencyManager::Unpin(FResidencyHandle handle)
+	{
+		SEntry* entry = m_entries.Get(handle);
+		if (entry && entry->pin_count > 0 && --entry->pin_count == 0)
+		{
+			entry->last_access_frame = m_frame;
+			Link(handle, *entry);
+		}
+	}
+
+	bool CResidencyManager::IsPinned(FResidencyHandle handle) const
+	{
+		const SEntry* entry = m_entries.Get(handle);
+		return entry && entry->pin_count > 0;
+	}
+
+	EResidencyCategory CResidencyManager::GetCategory(FResidencyHandle handle) const
+	{
+		const SEntry* entry = m_entries.Get(handle);
+		return entry ? entry->category : EResidencyCategory::Count;
+	}
+
+	uint64_t CResidencyManager::GetLastAccessFrame(FResidencyHandle handle) const
+	{
+		const SEntry* entry = m_entries.Get(handle);
+		return entry ? entry->last_access_frame : 0;
+	}
+
+	void CResidencyManager::EnforceBudgets()
+	{
+		for (uint32_t i = 0; i < c_residency_category_count; ++i)
+		{
+			SResidencyStats& stats = m_stats[i];
+			while (stats.current > stats.budget && m_lru_lists[i].head.IsValid())
+			{
+				// 先移除再回调, 回调里卸载资源时对同一条目的 Untrack 直接失效
+				const FResidencyHandle handle = m_lru_lists[i].head;
+				SEntry* entry = m_entries.Get(handle);
+				FResidencyEvictCallback on_evict = std::move(entry->on_evict);
+				stats.evicted_bytes += entry->size;
+				++stats.evicted_count;
+				Remove(handle, *entry);
+				if (on_evict)
+				{
+					on_evict();
+				}
+			}
+		}
+	}
+
+	void CResidencyManager::Link(FResidencyHandle handle, SEntry& entry)
+	{
+		SLruList& list = m_lru_lists[static_cast<uint32_t>(entry.category)];
+		entry.prev = list.tail;
+		entry.next = {};
+		if (SEntry* tail = m_entries.Get(list.tail))
+		{
+			tail->next = handle;
+		}
+		else
+		{
+			list.head = handle;
+		}
+		list.tail = handle;
+	}
+
+	void CResidencyManager::Unlink(SEntry& entry)
+	{
+		SLruList& list = m_lru_lists[static_cast<uint32_t>(entry.category)];
+		if (SEntry* prev = m_entries.Get(entry.prev))
+		{
+			prev->next = entry.next;
+		}
+		else
+		{
+			list.head = entry.next;
+		}
+		if (SEntry* next = m_entries.Get(entry.next))
+		{
+			next->prev = entry.prev;
+		}
+		else
+		{
+			list.tail = entry.prev;
+		}
+		entry.prev = {};
+		entry.next = {};
+	}
+
+	void CResidencyManager::Remove(FResidencyHandle handle, SEntry& entry)
+	{
+		if (entry.pin_count == 0)
+		{
+			Unlink(entry);
+		}
+		m_stats[static_cast<uint32_t>(entry.category)].current -= entry.size;
+		m_entries.Erase(handle);
+	}
+}
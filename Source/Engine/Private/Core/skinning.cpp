@@ -0,0 +1,164 @@
+﻿#include "Core/skinning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "Core/job_system.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FIRE_ENGINE_SKINNING_SSE2 1
+#include <emmintrin.h>
+#else
+#define FIRE_ENGINE_SKINNING_SSE2 0
+#endif
+
+namespace FireEngine
+{
+	namespace
+	{
+		// 每批顶点数, 足够摊薄任务调度的开销
+		constexpr uint32_t c_skinning_batch_size = 16 * 1024;
+		constexpr float    c_weight_scale = 1.0f / 255.0f;
+		// normal 之后的 uv/color 原样拷贝
+		constexpr size_t   c_passthrough_offset = offsetof(SVertexInstance, uv);
+		constexpr size_t   c_passthrough_size = sizeof(SVertexInstance) - c_passthrough_offset;
+		static_assert(c_passthrough_offset == offsetof(SVertexInstance, normal) + sizeof(float) * 3, "normal must be followed by uv");
+	}
+
+	SSkinWeight QuantizeSkinWeight(const uint32_t* bone_indices, const float* weights, uint32_t influence_count)
+	{
+		uint32_t top_bones[c_max_bone_influences] = {};
+		float    top_weights[c_max_bone_influences] = {};
+		for (uint32_t i = 0; i < influence_count; ++i)
+		{
+			float    weight = weights[i];
+			uint32_t bone = bone_indices[i];
+			if (!(weight > 0.0f))
+			{
+				continue;
+			}
+			// 插入排序, 保持降序
+			for (uint32_t slot = 0; slot < c_max_bone_influences; ++slot)
+			{
+				if (weight > top_weights[slot])
+				{
+					std::swap(weight, top_weights[slot]);
+					std::swap(bone, top_bones[slot]);
+				}
+			}
+		}
+
+		SSkinWeight skin_weight = {};
+		const float total = top_weights[0] + top_weights[1] + top_weights[2] + top_weights[3];
+		if (total <= 0.0f)
+		{
+			skin_weight.weights[0] = 255;
+			return skin_weight;
+		}
+
+		// 四舍五入后的误差补到最大的权重上, 保证和为 255
+		uint32_t quantized_total = 0;
+		for (uint32_t slot = 0; slot < c_max_bone_influences; ++slot)
+		{
+			const uint32_t quantized = static_cast<uint32_t>(top_weights[slot] / total * 255.0f + 0.5f);
+			skin_weight.weights[slot] = static_cast<uint8_t>(std::min(quantized, 255u));
+			skin_weight.bone_indices[slot] = quantized > 0 ? static_cast<uint16_t>(top_bones[slot]) : 0;
+			quantized_total += skin_weight.weights[slot];
+		}
+		skin_weight.weights[0] = static_cast<uint8_t>(static_cast<int32_t>(skin_weight.weights[0]) + 255 - static_cast<int32_t>(quantized_total));
+		return skin_weight;
+	}
+
+	void SkinVertices(const SSkinningJob& job, uint32_t vertex_begin, uint32_t vertex_end)
+	{
+		const SSkinMatrix* matrices = job.skin_matrices;
+		for (uint32_t v = vertex_begin; v < vertex_end; ++v)
+		{
+			const SVertexInstance& source = job.bind_vertices[v];
+			const SSkinWeight&     skin_weight = job.skin_weights[v];
+			SVertexInstance&       target = job.out_vertices[v];
+
+#if FIRE_ENGINE_SKINNING_SSE2
+			// 先按权重混合4个矩阵, 再一次变换位置和法线
+			__m128 column0 = _mm_setzero_ps();
+			__m128 column1 = _mm_setzero_ps();
+			__m128 column2 = _mm_setzero_ps();
+			__m128 column3 = _mm_setzero_ps();
+			for (uint32_t i = 0; i < c_max_bone_influences; ++i)
+			{
+				const __m128       weight = _mm_set1_ps(static_cast<float>(skin_weight.weights[i]) * c_weight_scale);
+				const SSkinMatrix& matrix = matrices[skin_weight.bone_indices[i]];
+				column0 = _mm_add_ps(column0, _mm_mul_ps(weight, _mm_load_ps(matrix.columns[0])));
+				column1 = _mm_add_ps(column1, _mm_mul_ps(weight, _mm_load_ps(matrix.columns[1])));
+				column2 = _mm_add_ps(column2, _mm_mul_ps(weight, _mm_load_ps(matrix.columns[2])));
+				column3 = _mm_add_ps(column3, _mm_mul_ps(weight, _mm_load_ps(matrix.columns[3])));
+			}
+
+			__m128 position = _mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(source.position[0])), _mm_mul_ps(column1, _mm_set1_ps(source.position[1])));
+			position = _mm_add_ps(position, _mm_add_ps(_mm_mul_ps(column2, _mm_set1_ps(source.position[2])), column3));
+
+			__m128 normal = _mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(source.normal[0])), _mm_mul_ps(column1, _mm_set1_ps(source.normal[1])));
+			normal = _mm_add_ps(normal, _mm_mul_ps(column2, _mm_set1_ps(source.normal[2])));
+			__m128 length_sq = _mm_mul_ps(normal, normal);
+			length_sq = _mm_add_ps(length_sq, _mm_shuffle_ps(length_sq, length_sq, _MM_SHUFFLE(2, 3, 0, 1)));
+			length_sq = _mm_add_ps(length_sq, _mm_shuffle_ps(length_sq, length_sq, _MM_SHUFFLE(1, 0, 3, 2)));
+			// rsqrt 加一次牛顿迭代, 零向量保持为零
+			const __m128 rsqrt = _mm_rsqrt_ps(_mm_max_ps(length_sq, _mm_set1_ps(1e-30f)));
+			const __m128 refined = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), rsqrt), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(length_sq, rsqrt), rsqrt)));
+			normal = _mm_mul_ps(normal, refined);
+
+			// 列的第4个分量为0, 位置的w由平移列带入后改回1
+			_mm_storeu_ps(target.position, position);
+			target.position[3] = 1.0f;
+			// 4个float的写入会顺带覆盖 uv[0], 随后被原样拷贝的 uv/color 覆盖
+			_mm_storeu_ps(target.normal, normal);
+#else
+			float columns[4][3] = {};
+			for (uint32_t i = 0; i < c_max_bone_influences; ++i)
+			{
+				const float        weight = static_cast<float>(skin_weight.weights[i]) * c_weight_scale;
+				const SSkinMatrix& matrix = matrices[skin_weight.bone_indices[i]];
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					columns[c][0] += weight * matrix.columns[c][0];
+					columns[c][1] += weight * matrix.columns[c][1];
+					columns[c][2] += weight * matrix.columns[c][2];
+				}
+			}
+			float normal[3];
+			for (uint32_t r = 0; r < 3; ++r)
+			{
+				target.position[r] = columns[0][r] * source.position[0] + columns[1][r] * source.position[1] + columns[2][r] * source.position[2] + columns[3][r];
+				normal[r] = columns[0][r] * source.normal[0] + columns[1][r] * source.normal[1] + columns[2][r] * source.normal[2];
+			}
+			target.position[3] = 1.0f;
+			const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			const float inv_length = length > 0.0f ? 1.0f / length : 0.0f;
+			target.normal[0] = normal[0] * inv_length;
+			target.normal[1] = normal[1] * inv_length;
+			target.normal[2] = normal[2] * inv_length;
+#endif
+			memcpy(reinterpret_cast<uint8_t*>(&target) + c_passthrough_offset, reinterpret_cast<const uint8_t*>(&source) + c_passthrough_offset, c_passthrough_size);
+		}
+	}
+
+	void SkinVertices(const SSkinningJob* jobs, uint32_t job_count, CJobSystem& job_system)
+	{
+		// batch_offsets[i] 是第i个角色的第一批在所有批次里的序号
+		std::vector<uint32_t> batch_offsets(job_count + 1, 0);
+		for (uint32_t i = 0; i < job_count; ++i)
+		{
+			batch_offsets[i + 1] = batch_offsets[i] + (jobs[i].vertex_count + c_skinning_batch_size - 1) / c_skinning_batch_size;
+		}
+
+		job_system.ParallelFor(batch_offsets[job_count], [&](uint32_t batch) {
+			const uint32_t job_index = static_cast<uint32_t>(std::upper_bound(batch_offsets.begin(), batch_offsets.end(), batch) - batch_offsets.begin()) - 1;
+			const SSkinningJob& job = jobs[job_index];
+			const uint32_t vertex_begin = (batch - batch_offsets[job_index]) * c_skinning_batch_size;
+			SkinVertices(job, vertex_begin, std::min(vertex_begin + c_skinning_batch_size, job.vertex_count));
+		});
+	}
+}
@@ -0,0 +1,625 @@
+﻿#include "Core/texture_compressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FIRE_ENGINE_TEXTURE_COMPRESSOR_SSE2 1
+#include <emmintrin.h>
+#else
+#define FIRE_ENGINE_TEXTURE_COMPRESSOR_SSE2 0
+#endif
+
+#define STB_DXT_IMPLEMENTATION
+#define STB_DXT_STATIC
+#include "stb_dxt.h"
+#include "Core/job_system.h"
+
+namespace FireEngine
+{
+	namespace
+	{
+		constexpr uint32_t c_block_size = 4;
+		constexpr uint32_t c_block_pixels = 16;
+		// 每个任务处理的块行数, 4K 贴图约256个任务
+		constexpr uint32_t c_block_rows_per_job = 4;
+		constexpr uint8_t  c_bc7_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		uint32_t GetBlockBytes(ETextureFormat format)
+		{
+			switch (format)
+			{
+			case ETextureFormat::BC1: return 8;
+			case ETextureFormat::BC3: return 16;
+			case ETextureFormat::BC5: return 16;
+			case ETextureFormat::BC7: return 16;
+			default:                  return 0;
+			}
+		}
+
+		// 取出一个4x4块, 超出图像的部分复制边缘像素
+		void GatherBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y, uint8_t out_block[c_block_pixels * 4])
+		{
+			for (uint32_t y = 0; y < c_block_size; ++y)
+			{
+				const uint32_t source_y = std::min(block_y * c_block_size + y, height - 1);
+				const uint8_t* row = rgba + static_cast<uint64_t>(source_y) * width * 4;
+				const uint32_t source_x = block_x * c_block_size;
+				if (source_x + c_block_size <= width)
+				{
+					memcpy(out_block + y * 16, row + source_x * 4, 16);
+					continue;
+				}
+				for (uint32_t x = 0; x < c_block_size; ++x)
+				{
+					memcpy(out_block + (y * 4 + x) * 4, row + std::min(source_x + x, width - 1) * 4, 4);
+				}
+			}
+		}
+
+		// BC7 mode 6: 一个子集, RGBA 端点各7位加每端点1个 p 位, 4位索引
+		class CBc7Mode6Encoder
+		{
+		public:
+			explicit CBc7Mode6Encoder(ECompressionQuality quality)
+			{
+				switch (quality)
+				{
+				case ECompressionQuality::Fast:
+					m_power_iterations = 2;
+					m_refine_iterations = 0;
+					m_search_p_bits = false;
+					break;
+				case ECompressionQuality::Normal:
+					m_power_iterations = 4;
+					m_refine_iterations = 1;
+					m_search_p_bits = false;
+					break;
+				case ECompressionQuality::High:
+					m_power_iterations = 8;
+					m_refine_iterations = 3;
+					m_search_p_bits = true;
+					break;
+				}
+			}
+
+			void Encode(const uint8_t block[c_block_pixels * 4], uint8_t out_block[16]) const
+			{
+				SBlockPixels pixels;
+				for (uint32_t i = 0; i < c_block_pixels; ++i)
+				{
+					for (uint32_t c = 0; c < 4; ++c)
+					{
+						pixels.channels[c][i] = block[i * 4 + c];
+					}
+				}
+
+				float endpoints[2][4];
+				FitPrincipalAxis(pixels, endpoints);
+
+				SCandidate best;
+				best.error = QuantizeAndIndex(pixels, endpoints, best);
+				for (uint32_t iteration = 0; iteration < m_refine_iterations; ++iteration)
+				{
+					float refined[2][4];
+					if (!RefineEndpoints(pixels, best.indices, refined))
+					{
+						break;
+					}
+					SCandidate candidate;
+					candidate.error = QuantizeAndIndex(pixels, refined, candidate);
+					if (candidate.error >= best.error)
+					{
+						break;
+					}
+					best = candidate;
+				}
+				Pack(best, out_block);
+			}
+
+		private:
+			struct SBlockPixels
+			{
+				// 按通道存放, 方便一次比较4个像素
+				alignas(16) float channels[4][c_block_pixels];
+			};
+
+			struct SCandidate
+			{
+				uint8_t endpoints[2][4]{};   // 7位端点
+				uint8_t p_bits[2]{};
+				uint8_t indices[c_block_pixels]{};
+				float   error{ 0.0f };
+			};
+
+			void FitPrincipalAxis(const SBlockPixels& pixels, float out_endpoints[2][4]) const
+			{
+				float mean[4] = {};
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					for (uint32_t i = 0; i < c_block_pixels; ++i)
+					{
+						mean[c] += pixels.channels[c][i];
+					}
+					mean[c] /= c_block_pixels;
+				}
+				float covariance[4][4] = {};
+				for (uint32_t i = 0; i < c_block_pixels; ++i)
+				{
+					float delta[4];
+					for (uint32_t c = 0; c < 4; ++c)
+					{
+						delta[c] = pixels.channels[c][i] - mean[c];
+					}
+					for (uint32_t a = 0; a < 4; ++a)
+					{
+						for (uint32_t b = a; b < 4; ++b)
+						{
+							covariance[a][b] += delta[a] * delta[b];
+						}
+					}
+				}
+
+				// 幂迭代求主轴, 初值取方差最大的那一列
+				uint32_t start = 0;
+				for (uint32_t c = 1; c < 4; ++c)
+				{
+					if (covariance[c][c] > covariance[start][start])
+					{
+						start = c;
+					}
+				}
+				float axis[4];
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					axis[c] = c < start ? covariance[c][start] : covariance[start][c];
+				}
+				for (uint32_t iteration = 0; iteration < m_power_iterations; ++iteration)
+				{
+					float next[4] = {};
+					for (uint32_t a = 0; a < 4; ++a)
+					{
+						for (uint32_t b = 0; b < 4; ++b)
+						{
+							next[a] += (a <= b ? covariance[a][b] : covariance[b][a]) * axis[b];
+						}
+					}
+					const float length = std::max(std::max(std::fabs(next[0]), std::fabs(next[1])), std::max(std::fabs(next[2]), std::fabs(next[3])));
+					if (length < 1e-6f)
+					{
+						break;
+					}
+					for (uint32_t c = 0; c < 4; ++c)
+					{
+						axis[c] = next[c] / length;
+					}
+				}
+				const float axis_length_sq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3];
+				if (axis_length_sq < 1e-12f)
+				{
+					// 纯色块
+					for (uint32_t c = 0; c < 4; ++c)
+					{
+						out_endpoints[0][c] = out_endpoints[1][c] = mean[c];
+					}
+					return;
+				}
+
+				float min_t = 1e30f;
+				float max_t = -1e30f;
+				for (uint32_t i = 0; i < c_block_pixels; ++i)
+				{
+					float t = 0.0f;
+					for (uint32_t c = 0; c < 4; ++c)
+					{
+						t += (pixels.channels[c][i] - mean[c]) * axis[c];
+					}
+					min_t = std::min(min_t, t);
+					max_t = std::max(max_t, t);
+				}
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					out_endpoints[0][c] = std::clamp(mean[c] + axis[c] * min_t / axis_length_sq, 0.0f, 255.0f);
+					out_endpoints[1][c] = std::clamp(mean[c] + axis[c] * max_t / axis_length_sq, 0.0f, 255.0f);
+				}
+			}
+
+			static void QuantizeEndpoint(const float endpoint[4], uint32_t p_bit, uint8_t out_endpoint[4])
+			{
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					const float value = std::round((endpoint[c] - static_cast<float>(p_bit)) * 0.5f);
+					out_endpoint[c] = static_cast<uint8_t>(std::clamp(value, 0.0f, 127.0f));
+				}
+			}
+
+			static float EndpointError(const float endpoint[4], const uint8_t quantized[4], uint32_t p_bit)
+			{
+				float error = 0.0f;
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					const float delta = static_cast<float>((quantized[c] << 1) | p_bit) - endpoint[c];
+					error += delta * delta;
+				}
+				return error;
+			}
+
+			float QuantizeAndIndex(const SBlockPixels& pixels, const float endpoints[2][4], SCandidate& out_candidate) const
+			{
+				if (!m_search_p_bits)
+				{
+					// 每个端点单独挑误差小的 p 位
+					for (uint32_t e = 0; e < 2; ++e)
+					{
+						uint8_t quantized[2][4];
+						QuantizeEndpoint(endpoints[e], 0, quantized[0]);
+						QuantizeEndpoint(endpoints[e], 1, quantized[1]);
+						const uint32_t p_bit = EndpointError(endpoints[e], quantized[1], 1) < EndpointError(endpoints[e], quantized[0], 0) ? 1 : 0;
+						memcpy(out_candidate.endpoints[e], quantized[p_bit], 4);
+						out_candidate.p_bits[e] = static_cast<uint8_t>(p_bit);
+					}
+					return SelectIndices(pixels, out_candidate);
+				}
+
+				// 高质量: 四种 p 位组合都按整块误差比较
+				float best_error = 1e30f;
+				for (uint32_t combination = 0; combination < 4; ++combination)
+				{
+					SCandidate candidate;
+					for (uint32_t e = 0; e < 2; ++e)
+					{
+						candidate.p_bits[e] = static_cast<uint8_t>((combination >> e) & 1);
+						QuantizeEndpoint(endpoints[e], candidate.p_bits[e], candidate.endpoints[e]);
+					}
+					const float error = SelectIndices(pixels, candidate);
+					if (error < best_error)
+					{
+						best_error = error;
+						out_candidate = candidate;
+					}
+				}
+				return best_error;
+			}
+
+			// 对16个调色板颜色穷举, 返回整块的平方误差
+			static float SelectIndices(const SBlockPixels& pixels, SCandidate& candidate)
+			{
+				float palette[16][4];
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					const int32_t low = (candidate.endpoints[0][c] << 1) | candidate.p_bits[0];
+					const int32_t high = (candidate.endpoints[1][c] << 1) | candidate.p_bits[1];
+					for (uint32_t k = 0; k < 16; ++k)
+					{
+						palette[k][c] = static_cast<float>(((64 - c_bc7_weights[k]) * low + c_bc7_weights[k] * high + 32) >> 6);
+					}
+				}
+
+#if FIRE_ENGINE_TEXTURE_COMPRESSOR_SSE2
+				float total = 0.0f;
+				for (uint32_t group = 0; group < c_block_pixels; group += 4)
+				{
+					const __m128 red = _mm_load_ps(pixels.channels[0] + group);
+					const __m128 green = _mm_load_ps(pixels.channels[1] + group);
+					const __m128 blue = _mm_load_ps(pixels.channels[2] + group);
+					const __m128 alpha = _mm_load_ps(pixels.channels[3] + group);
+					__m128  best_error = _mm_set1_ps(1e30f);
+					__m128i best_index = _mm_setzero_si128();
+					for (uint32_t k = 0; k < 16; ++k)
+					{
+						const __m128 delta_red = _mm_sub_ps(red, _mm_set1_ps(palette[k][0]));
+						const __m128 delta_green = _mm_sub_ps(green, _mm_set1_ps(palette[k][1]));
+						const __m128 delta_blue = _mm_sub_ps(blue, _mm_set1_ps(palette[k][2]));
+						const __m128 delta_alpha = _mm_sub_ps(alpha, _mm_set1_ps(palette[k][3]));
+						const __m128 error = _mm_add_ps(_mm_add_ps(_mm_mul_ps(delta_red, delta_red), _mm_mul_ps(delta_green, delta_green)),
+							_mm_add_ps(_mm_mul_ps(delta_blue, delta_blue), _mm_mul_ps(delta_alpha, delta_alpha)));
+						const __m128i better = _mm_castps_si128(_mm_cmplt_ps(error, best_error));
+						best_error = _mm_min_ps(error, best_error);
+						best_index = _mm_or_si128(_mm_and_si128(better, _mm_set1_epi32(static_cast<int32_t>(k))), _mm_andnot_si128(better, best_index));
+					}
+					alignas(16) float   errors[4];
+					alignas(16) int32_t indices[4];
+					_mm_store_ps(errors, best_error);
+					_mm_store_si128(reinterpret_cast<__m128i*>(indices), best_index);
+					for (uint32_t i = 0; i < 4; ++i)
+					{
+						candidate.indices[group + i] = static_cast<uint8_t>(indices[i]);
+						total += errors[i];
+					}
+				}
+				return total;
+#else
+				float total = 0.0f;
+				for (uint32_t i = 0; i < c_block_pixels; ++i)
+				{
+					float best_error = 1e30f;
+					for (uint32_t k = 0; k < 16; ++k)
+					{
+						float error = 0.0f;
+						for (uint32_t c = 0; c < 4; ++c)
+						{
+							const float delta = pixels.channels[c][i] - palette[k][c];
+							error += delta * delta;
+						}
+						if (error < best_error)
+						{
+							best_error = error;
+							candidate.indices[i] = static_cast<uint8_t>(k);
+						}
+					}
+					total += best_error;
+				}
+				return total;
+#endif
+			}
+
+			// 固定索引后对两个端点做最小二乘
+			static bool RefineEndpoints(const SBlockPixels& pixels, const uint8_t indices[c_block_pixels], float out_endpoints[2][4])
+			{
+				float aa = 0.0f;
+				float ab = 0.0f;
+				float bb = 0.0f;
+				float rhs_low[4] = {};
+				float rhs_high[4] = {};
+				for (uint32_t i = 0; i < c_block_pixels; ++i)
+				{
+					const float weight = c_bc7_weights[indices[i]] / 64.0f;
+					const float inverse = 1.0f - weight;
+					aa += inverse * inverse;
+					ab += inverse * weight;
+					bb += weight * weight;
+					for (uint32_t c = 0; c < 4; ++c)
+					{
+						rhs_low[c] += inverse * pixels.channels[c][i];
+						rhs_high[c] += weight * pixels.channels[c][i];
+					}
+				}
+				const float determinant = aa * bb - ab * ab;
+				if (std::fabs(determinant) < 1e-6f)
+				{
+					return false;
+				}
+				const float inverse_determinant = 1.0f / determinant;
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					out_endpoints[0][c] = std::clamp((bb * rhs_low[c] - ab * rhs_high[c]) * inverse_determinant, 0.0f, 255.0f);
+					out_endpoints[1][c] = std::clamp((aa * rhs_high[c] - ab * rhs_low[c]) * inverse_determinant, 0.0f, 255.0f);
+				}
+				return true;
+			}
+
+			static void Pack(SCandidate candidate, uint8_t out_block[16])
+			{
+				// 第一个像素的索引最高位隐含为0, 否则交换端点并翻转索引
+				if (candidate.indices[0] & 8)
+				{
+					std::swap(candidate.endpoints[0], candidate.endpoints[1]);
+					std::swap(candidate.p_bits[0], candidate.p_bits[1]);
+					for (uint8_t& index : candidate.indices)
+					{
+						index = static_cast<uint8_t>(15 - index);
+					}
+				}
+
+				uint64_t bits[2] = {};
+				uint32_t position = 0;
+				auto write = [&bits, &position](uint32_t value, uint32_t count) {
+					for (uint32_t i = 0; i < count; ++i, ++position)
+					{
+						bits[position >> 6] |= static_cast<uint64_t>((value >> i) & 1) << (position & 63);
+					}
+				};
+				write(1u << 6, 7);
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					write(candidate.endpoints[0][c], 7);
+					write(candidate.endpoints[1][c], 7);
+				}
+				write(candidate.p_bits[0], 1);
+				write(candidate.p_bits[1], 1);
+				write(candidate.indices[0], 3);
+				for (uint32_t i = 1; i < c_block_pixels; ++i)
+				{
+					write(candidate.indices[i], 4);
+				}
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					out_block[i] = static_cast<uint8_t>(bits[i >> 3] >> ((i & 7) * 8));
+				}
+			}
+
+			uint32_t m_power_iterations{ 4 };
+			uint32_t m_refine_iterations{ 1 };
+			bool     m_search_p_bits{ false };
+		};
+
+		inline uint16_t PackRgb565(int32_t r, int32_t g, int32_t b)
+		{
+			return static_cast<uint16_t>(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+		}
+
+		inline void UnpackRgb565(uint16_t color, int32_t out_rgb[3])
+		{
+			const int32_t r = color >> 11;
+			const int32_t g = (color >> 5) & 63;
+			const int32_t b = color & 31;
+			out_rgb[0] = (r << 3) | (r >> 2);
+			out_rgb[1] = (g << 2) | (g >> 4);
+			out_rgb[2] = (b << 3) | (b >> 2);
+		}
+
+		// Fast 档的 BC1/BC3 颜色块: 端点直接取包围盒, 不做主轴分析和端点迭代
+		// 不向内收缩包围盒, 否则只有两种颜色的块(界面、遮罩)也会有误差
+		void EncodeColorBlockFast(const uint8_t block[c_block_pixels * 4], uint8_t out_block[8])
+		{
+			int32_t low[3] = { 255, 255, 255 };
+			int32_t high[3] = { 0, 0, 0 };
+			for (uint32_t i = 0; i < c_block_pixels; ++i)
+			{
+				for (uint32_t c = 0; c < 3; ++c)
+				{
+					low[c] = std::min<int32_t>(low[c], block[i * 4 + c]);
+					high[c] = std::max<int32_t>(high[c], block[i * 4 + c]);
+				}
+			}
+			const uint16_t color0 = PackRgb565(high[0], high[1], high[2]);
+			const uint16_t color1 = PackRgb565(low[0], low[1], low[2]);
+			out_block[0] = static_cast<uint8_t>(color0);
+			out_block[1] = static_cast<uint8_t>(color0 >> 8);
+			out_block[2] = static_cast<uint8_t>(color1);
+			out_block[3] = static_cast<uint8_t>(color1 >> 8);
+
+			uint32_t bits = 0;
+			if (color0 != color1)
+			{
+				// 每个分量都是 high >= low, 所以 color0 > color1, 是4色模式
+				int32_t palette[4][3];
+				UnpackRgb565(color0, palette[0]);
+				UnpackRgb565(color1, palette[1]);
+				for (uint32_t c = 0; c < 3; ++c)
+				{
+					palette[2][c] = (palette[0][c] * 2 + palette[1][c]) / 3;
+					palette[3][c] = (palette[0][c] + palette[1][c] * 2) / 3;
+				}
+				for (uint32_t i = 0; i < c_block_pixels; ++i)
+				{
+					uint32_t best_index = 0;
+					int32_t  best_error = INT32_MAX;
+					for (uint32_t index = 0; index < 4; ++index)
+					{
+						const int32_t dr = block[i * 4] - palette[index][0];
+						const int32_t dg = block[i * 4 + 1] - palette[index][1];
+						const int32_t db = block[i * 4 + 2] - palette[index][2];
+						const int32_t error = dr * dr + dg * dg + db * db;
+						if (error < best_error)
+						{
+							best_error = error;
+							best_index = index;
+						}
+					}
+					bits |= best_index << (i * 2);
+				}
+			}
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				out_block[4 + i] = static_cast<uint8_t>(bits >> (i * 8));
+			}
+		}
+
+		void CompressBlock(const uint8_t block[c_block_pixels * 4], ETextureFormat format, ECompressionQuality quality, const CBc7Mode6Encoder& bc7_encoder, uint8_t* out_block)
+		{
+			const bool fast = quality == ECompressionQuality::Fast;
+			const int  stb_mode = quality == ECompressionQuality::High ? STB_DXT_HIGHQUAL : STB_DXT_NORMAL;
+			switch (format)
+			{
+			case ETextureFormat::BC1:
+				if (fast)
+				{
+					EncodeColorBlockFast(block, out_block);
+					break;
+				}
+				stb_compress_dxt_block(out_block, block, 0, stb_mode);
+				break;
+			case ETextureFormat::BC3:
+				if (fast)
+				{
+					// stb 的 alpha 块本来就是包围盒端点, 没有迭代, 直接复用
+					uint8_t alpha[c_block_pixels];
+					for (uint32_t i = 0; i < c_block_pixels; ++i)
+					{
+						alpha[i] = block[i * 4 + 3];
+					}
+					stb_compress_bc4_block(out_block, alpha);
+					EncodeColorBlockFast(block, out_block + 8);
+					break;
+				}
+				stb_compress_dxt_block(out_block, block, 1, stb_mode);
+				break;
+			case ETextureFormat::BC5:
+			{
+				// stb 的 BC4/BC5 取包围盒端点, 索引直接算出最优值, 已经是最便宜的做法, 三个档位相同
+				uint8_t red_green[c_block_pixels * 2];
+				for (uint32_t i = 0; i < c_block_pixels; ++i)
+				{
+					red_green[i * 2] = block[i * 4];
+					red_green[i * 2 + 1] = block[i * 4 + 1];
+				}
+				stb_compress_bc5_block(out_block, red_green);
+				break;
+			}
+			case ETextureFormat::BC7:
+				bc7_encoder.Encode(block, out_block);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	bool IsBlockCompressed(ETextureFormat format)
+	{
+		return format != ETextureFormat::RGBA8;
+	}
+
+	uint64_t GetTextureRowPitch(ETextureFormat format, uint32_t width)
+	{
+		if (!IsBlockCompressed(format))
+		{
+			return static_cast<uint64_t>(width) * 4;
+		}
+		return static_cast<uint64_t>((width + c_block_size - 1) / c_block_size) * GetBlockBytes(format);
+	}
+
+	uint32_t GetTextureRowCount(ETextureFormat format, uint32_t height)
+	{
+		return IsBlockCompressed(format) ? (height + c_block_size - 1) / c_block_size : height;
+	}
+
+	uint64_t GetTextureDataSize(ETextureFormat format, uint32_t width, uint32_t height)
+	{
+		return GetTextureRowPitch(format, width) * GetTextureRowCount(format, height);
+	}
+
+	bool CompressTexture(const uint8_t* rgba, uint32_t width, uint32_t height, ETextureFormat format, ECompressionQuality quality,
+		std::vector<uint8_t>& out_data, CJobSystem* job_system)
+	{
+		if (!rgba || width == 0 || height == 0 || !IsBlockCompressed(format))
+		{
+			return false;
+		}
+
+		const uint32_t         block_bytes = GetBlockBytes(format);
+		const uint32_t         blocks_x = (width + c_block_size - 1) / c_block_size;
+		const uint32_t         blocks_y = (height + c_block_size - 1) / c_block_size;
+		const CBc7Mode6Encoder bc7_encoder(quality);
+		out_data.resize(GetTextureDataSize(format, width, height));
+		uint8_t* out_blocks = out_data.data();
+
+		const uint32_t job_count = (blocks_y + c_block_rows_per_job - 1) / c_block_rows_per_job;
+		auto compress_rows = [&](uint32_t job) {
+			const uint32_t row_end = std::min(blocks_y, (job + 1) * c_block_rows_per_job);
+			uint8_t block[c_block_pixels * 4];
+			for (uint32_t block_y = job * c_block_rows_per_job; block_y < row_end; ++block_y)
+			{
+				for (uint32_t block_x = 0; block_x < blocks_x; ++block_x)
+				{
+					GatherBlock(rgba, width, height, block_x, block_y, block);
+					CompressBlock(block, format, quality, bc7_encoder, out_blocks + (static_cast<uint64_t>(block_y) * blocks_x + block_x) * block_bytes);
+				}
+			}
+		};
+		if (job_system)
+		{
+			job_system->ParallelFor(job_count, compress_rows);
+		}
+		else
+		{
+			for (uint32_t job = 0; job < job_count; ++job)
+			{
+				compress_rows(job);
+			}
+		}
+		return true;
+	}
+}
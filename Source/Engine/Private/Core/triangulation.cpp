@@ -0,0 +1,341 @@
+﻿#include "Core/triangulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace FireEngine
+{
+	namespace
+	{
+		// 超过这个顶点数才建立 z-order 索引, 小多边形直接遍历更快
+		constexpr uint32_t c_z_order_threshold = 64;
+
+		struct SPolygonNode
+		{
+			uint32_t      index;
+			float         x;
+			float         y;
+			uint32_t      z;
+			SPolygonNode* prev;
+			SPolygonNode* next;
+			SPolygonNode* prev_z;
+			SPolygonNode* next_z;
+		};
+
+		struct STriangulationScratch
+		{
+			std::vector<SPolygonNode>  nodes;
+			std::vector<SPolygonNode*> z_sorted;
+		};
+
+		// 逆时针时为正
+		inline float Cross(const SPolygonNode* a, const SPolygonNode* b, const SPolygonNode* c)
+		{
+			return (b->x - a->x) * (c->y - a->y) - (b->y - a->y) * (c->x - a->x);
+		}
+
+		inline bool PointInTriangle(const SPolygonNode* a, const SPolygonNode* b, const SPolygonNode* c, const SPolygonNode* p)
+		{
+			return Cross(a, b, p) >= 0.0f && Cross(b, c, p) >= 0.0f && Cross(c, a, p) >= 0.0f;
+		}
+
+		inline bool SamePoint(const SPolygonNode* a, const SPolygonNode* b)
+		{
+			return a->x == b->x && a->y == b->y;
+		}
+
+		// 坐标量化到 16 位后交错成 32 位的 Morton 码
+		inline uint32_t ZOrder(float x, float y, float min_x, float min_y, float inv_size)
+		{
+			uint32_t ix = static_cast<uint32_t>((x - min_x) * inv_size);
+			uint32_t iy = static_cast<uint32_t>((y - min_y) * inv_size);
+			ix = (ix | (ix << 8)) & 0x00FF00FF;
+			ix = (ix | (ix << 4)) & 0x0F0F0F0F;
+			ix = (ix | (ix << 2)) & 0x33333333;
+			ix = (ix | (ix << 1)) & 0x55555555;
+			iy = (iy | (iy << 8)) & 0x00FF00FF;
+			iy = (iy | (iy << 4)) & 0x0F0F0F0F;
+			iy = (iy | (iy << 2)) & 0x33333333;
+			iy = (iy | (iy << 1)) & 0x55555555;
+			return ix | (iy << 1);
+		}
+
+		class CEarClipper
+		{
+		public:
+			CEarClipper(STriangulationScratch& scratch, std::vector<IndexType>& out_indices, IndexType index_base)
+				: m_scratch(scratch), m_out_indices(out_indices), m_index_base(index_base)
+			{
+			}
+
+			void Run(SPolygonNode* start, uint32_t vertex_count)
+			{
+				if (vertex_count > c_z_order_threshold)
+				{
+					BuildZOrder(start, vertex_count);
+				}
+
+				SPolygonNode* ear = start;
+				SPolygonNode* stop = ear;
+				uint32_t      pass = 0;
+				while (ear->prev != ear->next)
+				{
+					SPolygonNode* prev = ear->prev;
+					SPolygonNode* next = ear->next;
+					const bool is_ear = pass < 2 ? (m_use_z_order ? IsEarZOrder(ear) : IsEar(ear)) : Cross(prev, ear, next) > 0.0f;
+					if (is_ear || pass == 3)
+					{
+						Emit(prev, ear, next);
+						Remove(ear);
+						// 跳过下一个顶点能减少细长三角形
+						ear = next->next;
+						stop = ear;
+						continue;
+					}
+
+					ear = next;
+					if (ear == stop)
+					{
+						// 一圈都没有找到耳朵: 先去掉共线/重合点, 再放宽条件, 最后强制切除保证结束
+						if (pass == 0)
+						{
+							ear = FilterPoints(ear);
+						}
+						++pass;
+						stop = ear;
+						if (ear->prev == ear->next)
+						{
+							break;
+						}
+					}
+				}
+			}
+
+		private:
+			void Emit(const SPolygonNode* a, const SPolygonNode* b, const SPolygonNode* c)
+			{
+				m_out_indices.emplace_back(m_index_base + a->index);
+				m_out_indices.emplace_back(m_index_base + b->index);
+				m_out_indices.emplace_back(m_index_base + c->index);
+			}
+
+			void Remove(SPolygonNode* node)
+			{
+				node->next->prev = node->prev;
+				node->prev->next = node->next;
+				if (node->prev_z)
+				{
+					node->prev_z->next_z = node->next_z;
+				}
+				if (node->next_z)
+				{
+					node->next_z->prev_z = node->prev_z;
+				}
+			}
+
+			SPolygonNode* FilterPoints(SPolygonNode* start)
+			{
+				SPolygonNode* node = start;
+				SPolygonNode* end = start;
+				bool          again = false;
+				do
+				{
+					again = false;
+					if (node->prev != node->next && (SamePoint(node, node->next) || Cross(node->prev, node, node->next) == 0.0f))
+					{
+						// 删除后回退一个点重新检查, 连续的重复点和共线点都要删掉
+						Remove(node);
+						node = end = node->prev;
+						if (node == node->next)
+						{
+							break;
+						}
+						again = true;
+					}
+					else
+					{
+						node = node->next;
+					}
+				} while (again || node != end);
+				return end;
+			}
+
+			bool IsEar(const SPolygonNode* ear) const
+			{
+				const SPolygonNode* a = ear->prev;
+				const SPolygonNode* b = ear;
+				const SPolygonNode* c = ear->next;
+				if (Cross(a, b, c) <= 0.0f)
+				{
+					return false;
+				}
+				for (const SPolygonNode* p = c->next; p != a; p = p->next)
+				{
+					if (!SamePoint(p, a) && !SamePoint(p, b) && !SamePoint(p, c) && PointInTriangle(a, b, c, p) && Cross(p->prev, p, p->next) <= 0.0f)
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+
+			bool IsEarZOrder(const SPolygonNode* ear) const
+			{
+				const SPolygonNode* a = ear->prev;
+				const SPolygonNode* b = ear;
+				const SPolygonNode* c = ear->next;
+				if (Cross(a, b, c) <= 0.0f)
+				{
+					return false;
+				}
+
+				const float    min_x = std::min({ a->x, b->x, c->x });
+				const float    min_y = std::min({ a->y, b->y, c->y });
+				const float    max_x = std::max({ a->x, b->x, c->x });
+				const float    max_y = std::max({ a->y, b->y, c->y });
+				const uint32_t min_z = ZOrder(min_x, min_y, m_min_x, m_min_y, m_inv_size);
+				const uint32_t max_z = ZOrder(max_x, max_y, m_min_x, m_min_y, m_inv_size);
+
+				auto blocks = [a, b, c](const SPolygonNode* p) {
+					return p != a && p != c && !SamePoint(p, a) && !SamePoint(p, b) && !SamePoint(p, c) && PointInTriangle(a, b, c, p) && Cross(p->prev, p, p->next) <= 0.0f;
+				};
+				for (const SPolygonNode* p = ear->next_z; p && p->z <= max_z; p = p->next_z)
+				{
+					if (blocks(p))
+					{
+						return false;
+					}
+				}
+				for (const SPolygonNode* p = ear->prev_z; p && p->z >= min_z; p = p->prev_z)
+				{
+					if (blocks(p))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+
+			void BuildZOrder(SPolygonNode* start, uint32_t vertex_count)
+			{
+				m_min_x = start->x;
+				m_min_y = start->y;
+				float max_x = start->x;
+				float max_y = start->y;
+				SPolygonNode* node = start;
+				do
+				{
+					m_min_x = std::min(m_min_x, node->x);
+					m_min_y = std::min(m_min_y, node->y);
+					max_x = std::max(max_x, node->x);
+					max_y = std::max(max_y, node->y);
+					node = node->next;
+				} while (node != start);
+				const float size = std::max(max_x - m_min_x, max_y - m_min_y);
+				m_inv_size = size > 0.0f ? 65535.0f / size : 0.0f;
+
+				auto& sorted = m_scratch.z_sorted;
+				sorted.clear();
+				sorted.reserve(vertex_count);
+				node = start;
+				do
+				{
+					node->z = ZOrder(node->x, node->y, m_min_x, m_min_y, m_inv_size);
+					sorted.emplace_back(node);
+					node = node->next;
+				} while (node != start);
+				std::sort(sorted.begin(), sorted.end(), [](const SPolygonNode* lhs, const SPolygonNode* rhs) { return lhs->z < rhs->z; });
+				for (size_t i = 0; i < sorted.size(); ++i)
+				{
+					sorted[i]->prev_z = i > 0 ? sorted[i - 1] : nullptr;
+					sorted[i]->next_z = i + 1 < sorted.size() ? sorted[i + 1] : nullptr;
+				}
+				m_use_z_order = true;
+			}
+
+			STriangulationScratch&  m_scratch;
+			std::vector<IndexType>& m_out_indices;
+			IndexType               m_index_base;
+			bool                    m_use_z_order{ false };
+			float                   m_min_x{ 0.0f };
+			float                   m_min_y{ 0.0f };
+			float                   m_inv_size{ 0.0f };
+		};
+	}
+
+	void TriangulatePolygon(const float* positions, uint32_t position_stride, uint32_t vertex_count, std::vector<IndexType>& out_indices, IndexType index_base)
+	{
+		if (vertex_count < 3)
+		{
+			return;
+		}
+		if (vertex_count == 3)
+		{
+			out_indices.emplace_back(index_base);
+			out_indices.emplace_back(index_base + 1);
+			out_indices.emplace_back(index_base + 2);
+			return;
+		}
+
+		// Newell 法线, 丢掉绝对值最大的分量投影到二维
+		float normal[3] = { 0.0f, 0.0f, 0.0f };
+		for (uint32_t i = 0; i < vertex_count; ++i)
+		{
+			const float* current = positions + i * position_stride;
+			const float* next = positions + ((i + 1) % vertex_count) * position_stride;
+			normal[0] += (current[1] - next[1]) * (current[2] + next[2]);
+			normal[1] += (current[2] - next[2]) * (current[0] + next[0]);
+			normal[2] += (current[0] - next[0]) * (current[1] + next[1]);
+		}
+		uint32_t drop_axis = 2;
+		if (std::fabs(normal[0]) > std::fabs(normal[1]) && std::fabs(normal[0]) > std::fabs(normal[2]))
+		{
+			drop_axis = 0;
+		}
+		else if (std::fabs(normal[1]) > std::fabs(normal[2]))
+		{
+			drop_axis = 1;
+		}
+		const uint32_t axis_u = (drop_axis + 1) % 3;
+		const uint32_t axis_v = (drop_axis + 2) % 3;
+		// 镜像u轴让投影后的多边形总是逆时针, 顶点顺序不变所以输出绕序也不变
+		const float flip = normal[drop_axis] < 0.0f ? -1.0f : 1.0f;
+
+		thread_local STriangulationScratch scratch;
+		auto& nodes = scratch.nodes;
+		nodes.resize(vertex_count);
+		for (uint32_t i = 0; i < vertex_count; ++i)
+		{
+			const float*  position = positions + i * position_stride;
+			SPolygonNode& node = nodes[i];
+			node.index = i;
+			node.x = position[axis_u] * flip;
+			node.y = position[axis_v];
+			node.z = 0;
+			node.prev = &nodes[(i + vertex_count - 1) % vertex_count];
+			node.next = &nodes[(i + 1) % vertex_count];
+			node.prev_z = nullptr;
+			node.next_z = nullptr;
+		}
+
+		// 所有角都严格凸时直接扇形展开; 重合点和共线点的叉积为0, 会掩盖旁边的凹角, 交给耳切去过滤
+		bool convex = true;
+		for (uint32_t i = 0; i < vertex_count && convex; ++i)
+		{
+			convex = Cross(nodes[i].prev, &nodes[i], nodes[i].next) > 0.0f;
+		}
+		if (convex)
+		{
+			for (uint32_t i = 1; i + 1 < vertex_count; ++i)
+			{
+				out_indices.emplace_back(index_base);
+				out_indices.emplace_back(index_base + i);
+				out_indices.emplace_back(index_base + i + 1);
+			}
+			return;
+		}
+
+		CEarClipper ear_clipper(scratch, out_indices, index_base);
+		ear_clipper.Run(&nodes[0], vertex_count);
+	}
+}
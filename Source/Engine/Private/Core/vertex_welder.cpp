@@ -0,0 +1,127 @@
+﻿#include "Core/vertex_welder.h"
+
+#include <cstring>
+
+namespace FireEngine
+{
+	namespace
+	{
+		constexpr uint32_t c_empty_slot = 0xffffffffu;
+		constexpr uint32_t c_vertex_words = sizeof(SVertexInstance) / sizeof(uint32_t);
+
+		// -0.0f 与 0.0f 视为同一个值
+		inline void CanonicalWords(const SVertexInstance& vertex, uint32_t (&out_words)[c_vertex_words])
+		{
+			memcpy(out_words, &vertex, sizeof(SVertexInstance));
+			for (uint32_t& word : out_words)
+			{
+				if (word == 0x80000000u)
+				{
+					word = 0;
+				}
+			}
+		}
+
+		inline uint64_t HashWords(const uint32_t (&words)[c_vertex_words])
+		{
+			uint64_t hash = 0x9e3779b97f4a7c15ull;
+			for (uint32_t word : words)
+			{
+				hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+				hash ^= hash >> 32;
+			}
+			return hash;
+		}
+
+		class CVertexHashTable
+		{
+		public:
+			void Reset(uint32_t vertex_count)
+			{
+				uint32_t capacity = 16;
+				while (capacity < vertex_count * 2)
+				{
+					capacity <<= 1;
+				}
+				m_mask = capacity - 1;
+				m_slots.assign(capacity, c_empty_slot);
+			}
+
+			// 找到相同顶点时返回它的下标, 否则把 candidate 插入并返回 candidate
+			uint32_t FindOrInsert(const std::vector<SVertexInstance>& vertices, const SVertexInstance& vertex, uint32_t candidate)
+			{
+				uint32_t words[c_vertex_words];
+				CanonicalWords(vertex, words);
+				uint32_t slot = static_cast<uint32_t>(HashWords(words)) & m_mask;
+				while (true)
+				{
+					const uint32_t existing = m_slots[slot];
+					if (existing == c_empty_slot)
+					{
+						m_slots[slot] = candidate;
+						return candidate;
+					}
+					uint32_t existing_words[c_vertex_words];
+					CanonicalWords(vertices[existing], existing_words);
+					if (memcmp(words, existing_words, sizeof(words)) == 0)
+					{
+						return existing;
+					}
+					slot = (slot + 1) & m_mask;
+				}
+			}
+
+		private:
+			std::vector<uint32_t> m_slots;
+			uint32_t              m_mask{ 0 };
+		};
+	}
+
+	uint32_t WeldVertices(std::vector<SVertexInstance>& vertices, std::vector<IndexType>& indices)
+	{
+		std::vector<SGeometryDesc> geometries(1);
+		geometries[0].vertex_offset = 0;
+		geometries[0].vertex_count  = static_cast<uint32_t>(vertices.size());
+		geometries[0].index_offset  = 0;
+		geometries[0].index_count   = static_cast<uint32_t>(indices.size());
+		geometries[0].material_index = 0;
+		return WeldVertices(vertices, indices, geometries);
+	}
+
+	uint32_t WeldVertices(std::vector<SVertexInstance>& vertices, std::vector<IndexType>& indices, std::vector<SGeometryDesc>& geometries)
+	{
+		CVertexHashTable      hash_table;
+		std::vector<uint32_t> remap;
+		uint32_t              write_cursor = 0;
+
+		// 写指针永远不超过读指针, 可以原地压缩
+		for (SGeometryDesc& geometry : geometries)
+		{
+			const uint32_t new_offset = write_cursor;
+			hash_table.Reset(geometry.vertex_count);
+			remap.resize(geometry.vertex_count);
+			for (uint32_t i = 0; i < geometry.vertex_count; ++i)
+			{
+				const SVertexInstance vertex = vertices[geometry.vertex_offset + i];
+				const uint32_t        welded = hash_table.FindOrInsert(vertices, vertex, write_cursor);
+				if (welded == write_cursor)
+				{
+					vertices[write_cursor++] = vertex;
+				}
+				remap[i] = welded - new_offset;
+			}
+
+			for (uint32_t i = 0; i < geometry.index_count; ++i)
+			{
+				IndexType& index = indices[geometry.index_offset + i];
+				index = index < geometry.vertex_count ? remap[index] : 0;
+			}
+			geometry.vertex_offset = new_offset;
+			geometry.vertex_count  = write_cursor - new_offset;
+		}
+
+		vertices.resize(write_cursor);
+		vertices.shrink_to_fit();
+		return write_cursor;
+	}
+}
@@ -2,8 +2,12 @@
 #include "EngineCore/engine.h"
 
 #include <chrono>
+#include <cstdlib>
+#include <filesystem>
 
+#include "Core/derived_data_cache.h"
 #include "Core/file_system.h"
+#include "Core/job_system.h"
 #include "Window/window_system.h"
 #include "Window/GenericWindow.h"
 #include "Level/level_manager.h"
@@ -21,8 +25,24 @@ namespace FireEngine
 		g_global_singleton_context = new CGlobalSingletonContext();
 
 
+		g_global_singleton_context->m_job_system = std::make_shared<CJobSystem>();
 		g_global_singleton_context->m_file_system = std::make_shared<CFileSystem>(resource_path);
+		// 有打包好的 Resource.pak 时优先从包里读, 资源目录作为后备
+		const std::string pak_file_name = g_global_singleton_context->m_file_system->GetFullPath("Resource.pak");
+		if (std::filesystem::exists(pak_file_name))
+		{
+			g_global_singleton_context->m_file_system->MountPak(pak_file_name);
+		}
+		// 设置了 FIRE_ENGINE_DDC_PATH 时使用共享的派生数据缓存目录, 否则放在资源根目录下
+		const char* shared_cache_path = std::getenv("FIRE_ENGINE_DDC_PATH");
+		const std::string cache_path = shared_cache_path && shared_cache_path[0] ? std::string(shared_cache_path) : g_global_singleton_context->m_file_system->GetFullPath("DerivedDataCache");
+		g_global_singleton_context->m_derived_data_cache = std::make_shared<CDerivedDataCache>(cache_path);
 		g_global_singleton_context->m_asset_system = std::make_shared<CAssetSystem>();
+		// 超出预算时按最久未访问淘汰, CPU 副本在上传后通常可以丢弃
+		CResidencyManager& residency = g_global_singleton_context->m_asset_system->GetResidency();
+		residency.SetBudget(EResidencyCategory::CpuPayload, 512ull << 20);
+		residency.SetBudget(EResidencyCategory::GpuBuffer, 1024ull << 20);
+		residency.SetBudget(EResidencyCategory::GpuTexture, 2048ull << 20);
 		g_global_singleton_context->m_window_system = std::make_shared<CWindowSystem>();
 		g_global_singleton_context->m_level_manager = std::make_shared<CLevelManager>();
 		g_global_singleton_context->m_rendering_system = std::make_shared<CRenderingSystem>(g_global_singleton_context->m_window_system.get());
@@ -62,6 +82,8 @@ namespace FireEngine
 			}
 			float dt = CalculateDeltaTime();
 			g_global_singleton_context->m_window_system->PollEvents();
+			g_global_singleton_context->m_asset_system->PumpCompletions();
+			g_global_singleton_context->m_asset_system->UpdateResidency();
 
 			//single thread
 			LogicTick(dt);
@@ -74,6 +96,7 @@ namespace FireEngine
 
 	void ShutDownEngine()
 	{
+		g_global_singleton_context->m_asset_system->GetResidency().PrintStats();
 		delete g_global_singleton_context;
 	}
 }
@@ -1,6 +1,12 @@
 #include "Function/FbxImporter.h"
 
+#include <algorithm>
+#include <cmath>
 #include <list>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Core/triangulation.h"
 
 namespace FireEngine
 {
@@ -23,8 +29,6 @@ namespace FireEngine
 		//Load plugins from the executable directory (optional)
 		FbxString path = FbxGetApplicationDirectory();
 		m_fbx_manager->LoadPluginsDirectory(path.Buffer());
-
-        m_geometry_converter = new FbxGeometryConverter(m_fbx_manager);
 	}
 
 	CFbxImporter::CFbxImporter()
@@ -34,8 +38,6 @@ namespace FireEngine
 
 	CFbxImporter::~CFbxImporter()
 	{
-		delete m_geometry_converter;
-        m_geometry_converter = nullptr;
 		if (m_fbx_manager)
 		{
             m_fbx_manager->Destroy();
@@ -189,40 +191,125 @@ namespace FireEngine
         return lStatus;
     }
 
-	void CFbxImporter::LoadStaticMesh(CMesh* out_mesh)
+	void CFbxImporter::CollectMeshes(std::vector<FbxMesh*>& out_meshes) const
 	{
-		if (!m_fbx_scene)
-		{
-			return;
-		}
-
 		FbxNode* root_node = m_fbx_scene->GetRootNode();
        
-        std::vector<FbxMesh*> meshes;
-		{
-            std::vector<FbxNode*> node_stack;
-            node_stack.emplace_back(root_node);
-            uint64_t node_index = 0;
-            while (node_index < node_stack.size())
+        std::vector<FbxNode*> node_stack;
+        node_stack.emplace_back(root_node);
+        uint64_t node_index = 0;
+        while (node_index < node_stack.size())
+        {
+            auto fbx_node = node_stack[node_index];
+            int32_t child_count = fbx_node->GetChildCount();
+            for (int32_t child_index = 0; child_index < child_count; ++child_index)
             {
-                auto fbx_node = node_stack[node_index];
-                int32_t child_count = fbx_node->GetChildCount();
-                for (int32_t child_index = 0; child_index < child_count; ++child_index)
+                node_stack.emplace_back(fbx_node->GetChild(child_index));
+            }
+            int32_t attr_count = fbx_node->GetNodeAttributeCount();
+            for (int32_t attr_index = 0; attr_index < attr_count; ++attr_index)
+            {
+                auto node_attr = fbx_node->GetNodeAttributeByIndex(attr_index);
+                if (node_attr->GetAttributeType() == FbxNodeAttribute::EType::eMesh)
                 {
-                    node_stack.emplace_back(fbx_node->GetChild(child_index));
+                    out_meshes.emplace_back(reinterpret_cast<FbxMesh*>(node_attr));
                 }
-                int32_t attr_count = fbx_node->GetNodeAttributeCount();
-                for (int32_t attr_index = 0; attr_index < attr_count; ++attr_index)
+            }
+            ++node_index;
+        }
+	}
+
+	void CFbxImporter::AppendMeshGeometry(FbxMesh* mesh, CMesh* out_mesh)
+	{
+        auto& vertex_instances = out_mesh->m_vretices;
+        auto& indices = out_mesh->m_indices;
+        // 不再调用 FbxGeometryConverter::Triangulate, 它会复制整个 mesh; 多边形直接在这里三角化
+        std::vector<float>     corner_positions;
+        std::vector<IndexType> local_indices;
+
+        const IndexType vertex_base = static_cast<IndexType>(vertex_instances.size());
+        int32_t     control_point_count = mesh->GetControlPointsCount();
+        FbxVector4* control_points = mesh->GetControlPoints();
+       
+        for (int32_t control_point_idx = 0; control_point_idx < control_point_count; ++control_point_idx)
+        {
+            auto& cp = control_points[control_point_idx];
+
+            SVertexInstance& vert = vertex_instances.emplace_back();
+            memset(&vert, 0, sizeof(SVertexInstance));
+            vert.position[0] = static_cast<float>(cp[0]);
+            vert.position[1] = static_cast<float>(cp[1]);
+            vert.position[2] = static_cast<float>(cp[2]);
+            vert.position[3] = 1.0f;
+        }
+
+        int32_t polygon_count = mesh->GetPolygonCount();
+        for (int32_t polygon_index = 0; polygon_index < polygon_count; ++polygon_index)
+        {
+            const int32_t polygon_size = mesh->GetPolygonSize(polygon_index);
+            corner_positions.resize(static_cast<size_t>(polygon_size) * 3);
+            bool valid_polygon = polygon_size >= 3;
+            for (int32_t corner = 0; corner < polygon_size && valid_polygon; ++corner)
+            {
+                const int32_t control_point_index = mesh->GetPolygonVertex(polygon_index, corner);
+                if (control_point_index < 0 || control_point_index >= control_point_count)
                 {
-                    auto node_attr = fbx_node->GetNodeAttributeByIndex(attr_index);
-                    if (node_attr->GetAttributeType() == FbxNodeAttribute::EType::eMesh)
-                    {
-                        meshes.emplace_back(reinterpret_cast<FbxMesh*>(node_attr));
-                    }
+                    valid_polygon = false;
+                    break;
                 }
+                const float* position = vertex_instances[vertex_base + control_point_index].position;
+                corner_positions[corner * 3] = position[0];
+                corner_positions[corner * 3 + 1] = position[1];
+                corner_positions[corner * 3 + 2] = position[2];
+            }
+            if (!valid_polygon)
+            {
+                printf("[error]:invalid polygon %d!\n", polygon_index);
+                continue;
             }
+
+            // 顶点按控制点存放, 法线取各个角的平均
+            for (int32_t corner = 0; corner < polygon_size; ++corner)
+            {
+                FbxVector4 normal;
+                if (mesh->GetPolygonVertexNormal(polygon_index, corner, normal))
+                {
+                    float* vert_normal = vertex_instances[vertex_base + mesh->GetPolygonVertex(polygon_index, corner)].normal;
+                    vert_normal[0] += static_cast<float>(normal[0]);
+                    vert_normal[1] += static_cast<float>(normal[1]);
+                    vert_normal[2] += static_cast<float>(normal[2]);
+                }
+            }
+
+            local_indices.clear();
+            TriangulatePolygon(corner_positions.data(), 3, static_cast<uint32_t>(polygon_size), local_indices);
+            for (IndexType local_index : local_indices)
+            {
+                indices.emplace_back(vertex_base + mesh->GetPolygonVertex(polygon_index, static_cast<int32_t>(local_index)));
+            }
+        }
+
+        for (size_t vertex_index = vertex_base; vertex_index < vertex_instances.size(); ++vertex_index)
+        {
+            float*      normal = vertex_instances[vertex_index].normal;
+            const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            const float inv_length = length > 0.0f ? 1.0f / length : 0.0f;
+            normal[0] *= inv_length;
+            normal[1] *= inv_length;
+            normal[2] *= inv_length;
+        }
+	}
+
+	void CFbxImporter::LoadStaticMesh(CMesh* out_mesh)
+	{
+		if (!m_fbx_scene)
+		{
+			return;
 		}
 
+        std::vector<FbxMesh*> meshes;
+        CollectMeshes(meshes);
+
         int64_t total_control_count = 0;
 		for (FbxMesh* mesh : meshes)
 		{
@@ -230,48 +317,239 @@ namespace FireEngine
             total_control_count = total_control_count + control_point_count;
 		}
         out_mesh->m_vretices.reserve(total_control_count);
-        auto& vertex_instances = out_mesh->m_vretices;
         for (FbxMesh* mesh : meshes)
         {
-            int32_t     control_point_count = mesh->GetControlPointsCount();
-            FbxVector4* control_points = mesh->GetControlPoints();
-           
-            for (int32_t control_point_idx = 0; control_point_idx < control_point_count; ++control_point_idx)
-            {
-                auto& cp = control_points[control_point_idx];
+            AppendMeshGeometry(mesh, out_mesh);
+        }
+	}
 
-                SVertexInstance& vert = vertex_instances.emplace_back();
-                memset(&vert, 0, sizeof(SVertexInstance));
-                vert.position[0] = static_cast<float>(cp[0]);
-                vert.position[1] = static_cast<float>(cp[1]);
-                vert.position[2] = static_cast<float>(cp[2]);
+	namespace
+	{
+		// FbxAMatrix 的平移在 mData[3], 即按列存放, 逐列拷贝成列向量约定的 FMatrix
+		FMatrix ToMatrix(const FbxAMatrix& matrix)
+		{
+			FMatrix result;
+			for (int32_t column = 0; column < 4; ++column)
+			{
+				for (int32_t row = 0; row < 4; ++row)
+				{
+					result(row, column) = static_cast<float>(matrix.Get(column, row));
+				}
+			}
+			return result;
+		}
+
+		SBoneTransform ToBoneTransform(const FbxAMatrix& matrix)
+		{
+			const FbxVector4    translation = matrix.GetT();
+			const FbxQuaternion rotation = matrix.GetQ();
+			const FbxVector4    scaling = matrix.GetS();
+
+			SBoneTransform transform;
+			transform.translation = FVector(static_cast<float>(translation[0]), static_cast<float>(translation[1]), static_cast<float>(translation[2]));
+			transform.rotation = FQuat(static_cast<float>(rotation[3]), static_cast<float>(rotation[0]), static_cast<float>(rotation[1]), static_cast<float>(rotation[2]));
+			transform.rotation.normalize();
+			transform.scaling = FVector(static_cast<float>(scaling[0]), static_cast<float>(scaling[1]), static_cast<float>(scaling[2]));
+			return transform;
+		}
+	}
+
+	void CFbxImporter::ImportSkeletalMesh(CSkeletalMesh* out_mesh)
+	{
+		if (!m_fbx_scene)
+		{
+			return;
+		}
+
+        std::vector<FbxMesh*> meshes;
+        CollectMeshes(meshes);
+
+        // 骨骼节点加上被蒙皮簇引用的节点, 深度优先收集保证父骨骼在前
+        std::unordered_set<FbxNode*> cluster_links;
+        for (FbxMesh* mesh : meshes)
+        {
+            const int32_t skin_count = mesh->GetDeformerCount(FbxDeformer::eSkin);
+            for (int32_t skin_index = 0; skin_index < skin_count; ++skin_index)
+            {
+                FbxSkin* skin = static_cast<FbxSkin*>(mesh->GetDeformer(skin_index, FbxDeformer::eSkin));
+                for (int32_t cluster_index = 0; cluster_index < skin->GetClusterCount(); ++cluster_index)
+                {
+                    if (FbxNode* link = skin->GetCluster(cluster_index)->GetLink())
+                    {
+                        cluster_links.insert(link);
+                    }
+                }
             }
+        }
 
-            if (!mesh->IsTriangleMesh())
+        std::vector<FbxNode*>                 bone_nodes;
+        std::unordered_map<FbxNode*, int32_t> bone_lookup;
+        auto& bones = out_mesh->m_bones;
+        bones.clear();
+        {
+            std::vector<FbxNode*> node_stack;
+            node_stack.emplace_back(m_fbx_scene->GetRootNode());
+            while (!node_stack.empty())
             {
-                auto converted_node = m_geometry_converter->Triangulate(mesh, true);
-                if (converted_node != NULL && converted_node->GetAttributeType() == FbxNodeAttribute::eMesh)
+                FbxNode* fbx_node = node_stack.back();
+                node_stack.pop_back();
+                for (int32_t child_index = fbx_node->GetChildCount() - 1; child_index >= 0; --child_index)
                 {
-                    mesh = converted_node->GetNode()->GetMesh();
+                    node_stack.emplace_back(fbx_node->GetChild(child_index));
                 }
-                else
+                if (!fbx_node->GetSkeleton() && cluster_links.count(fbx_node) == 0)
                 {
-                    printf("[error]:triangle failed!");
+                    continue;
                 }
+
+                SBone& bone = bones.emplace_back();
+                bone.name = fbx_node->GetName();
+                for (FbxNode* parent = fbx_node->GetParent(); parent; parent = parent->GetParent())
+                {
+                    auto found = bone_lookup.find(parent);
+                    if (found != bone_lookup.end())
+                    {
+                        bone.parent_index = found->second;
+                        break;
+                    }
+                }
+                bone_lookup.emplace(fbx_node, static_cast<int32_t>(bone_nodes.size()));
+                bone_nodes.emplace_back(fbx_node);
             }
+        }
+        if (bones.size() > UINT16_MAX)
+        {
+            printf("[error]:too many bones %zu!\n", bones.size());
+            bones.clear();
+            return;
+        }
+
+        // 蒙皮簇给出绑定时的骨骼全局变换, 没有簇的骨骼用默认姿势
+        std::vector<FMatrix> global_bind_poses(bones.size());
+        std::vector<bool>    has_cluster(bones.size(), false);
 
-            int32_t polygon_count = mesh->GetPolygonCount();
-            for (int32_t polygon_index = 0; polygon_index < polygon_count; ++polygon_index)
+        std::vector<uint32_t> influence_bones;
+        std::vector<float>    influence_weights;
+        auto& skin_weights = out_mesh->m_skin_weights;
+        for (FbxMesh* mesh : meshes)
+        {
+            const size_t  vertex_base = out_mesh->m_vretices.size();
+            const int32_t control_point_count = mesh->GetControlPointsCount();
+            AppendMeshGeometry(mesh, out_mesh);
+
+            // 先把每个控制点的所有影响按控制点归类, 再取前4个量化
+            std::vector<std::vector<std::pair<uint32_t, float>>> influences(control_point_count);
+            const int32_t skin_count = mesh->GetDeformerCount(FbxDeformer::eSkin);
+            for (int32_t skin_index = 0; skin_index < skin_count; ++skin_index)
             {
-                // mesh->GetPolygonVertex()
+                FbxSkin* skin = static_cast<FbxSkin*>(mesh->GetDeformer(skin_index, FbxDeformer::eSkin));
+                for (int32_t cluster_index = 0; cluster_index < skin->GetClusterCount(); ++cluster_index)
+                {
+                    FbxCluster* cluster = skin->GetCluster(cluster_index);
+                    FbxNode*    link = cluster->GetLink();
+                    if (!link)
+                    {
+                        continue;
+                    }
+                    const int32_t bone_index = bone_lookup[link];
+
+                    FbxAMatrix mesh_bind_pose;
+                    FbxAMatrix link_bind_pose;
+                    cluster->GetTransformMatrix(mesh_bind_pose);
+                    cluster->GetTransformLinkMatrix(link_bind_pose);
+                    bones[bone_index].inverse_bind_pose = ToMatrix(link_bind_pose.Inverse() * mesh_bind_pose);
+                    global_bind_poses[bone_index] = ToMatrix(link_bind_pose);
+                    has_cluster[bone_index] = true;
+
+                    const int32_t  index_count = cluster->GetControlPointIndicesCount();
+                    const int32_t* control_point_indices = cluster->GetControlPointIndices();
+                    const double*  weights = cluster->GetControlPointWeights();
+                    for (int32_t i = 0; i < index_count; ++i)
+                    {
+                        if (control_point_indices[i] >= 0 && control_point_indices[i] < control_point_count)
+                        {
+                            influences[control_point_indices[i]].emplace_back(static_cast<uint32_t>(bone_index), static_cast<float>(weights[i]));
+                        }
+                    }
+                }
             }
 
+            skin_weights.resize(vertex_base);
+            for (const auto& vertex_influences : influences)
+            {
+                influence_bones.clear();
+                influence_weights.clear();
+                for (const auto& influence : vertex_influences)
+                {
+                    influence_bones.emplace_back(influence.first);
+                    influence_weights.emplace_back(influence.second);
+                }
+                skin_weights.emplace_back(QuantizeSkinWeight(influence_bones.data(), influence_weights.data(), static_cast<uint32_t>(influence_bones.size())));
+            }
         }
-	}
 
-	void CFbxImporter::ImportSkeletalMesh(CMesh* out_mesh)
-	{
+        for (size_t bone_index = 0; bone_index < bones.size(); ++bone_index)
+        {
+            SBone& bone = bones[bone_index];
+            if (!has_cluster[bone_index])
+            {
+                global_bind_poses[bone_index] = ToMatrix(bone_nodes[bone_index]->EvaluateGlobalTransform());
+                bone.inverse_bind_pose = global_bind_poses[bone_index].inverse();
+            }
+        }
+        for (size_t bone_index = 0; bone_index < bones.size(); ++bone_index)
+        {
+            SBone&  bone = bones[bone_index];
+            FMatrix local = bone.parent_index >= 0 ? FMatrix(global_bind_poses[bone.parent_index].inverse() * global_bind_poses[bone_index]) : global_bind_poses[bone_index];
+            bone.bind_local.translation = local.block<3, 1>(0, 3);
+            bone.bind_local.scaling = FVector(local.block<3, 1>(0, 0).norm(), local.block<3, 1>(0, 1).norm(), local.block<3, 1>(0, 2).norm());
+            Eigen::Matrix3f rotation = local.block<3, 3>(0, 0);
+            for (int32_t axis = 0; axis < 3; ++axis)
+            {
+                if (bone.bind_local.scaling[axis] > 0.0f)
+                {
+                    rotation.col(axis) /= bone.bind_local.scaling[axis];
+                }
+            }
+            bone.bind_local.rotation = FQuat(rotation);
+            bone.bind_local.rotation.normalize();
+        }
 
+        // 每个动画栈按场景帧率逐帧采样所有骨骼的全局变换, 再换算到父骨骼空间
+        // 父骨骼是最近的骨骼祖先, 中间可能隔着非骨骼节点(如 Blender 的 Armature), 不能直接用 EvaluateLocalTransform
+        auto& animations = out_mesh->m_animations;
+        animations.clear();
+        const FbxTime::EMode time_mode = m_fbx_scene->GetGlobalSettings().GetTimeMode();
+        const int32_t        anim_stack_count = m_fbx_scene->GetSrcObjectCount<FbxAnimStack>();
+        for (int32_t anim_stack_index = 0; anim_stack_index < anim_stack_count; ++anim_stack_index)
+        {
+            FbxAnimStack* anim_stack = m_fbx_scene->GetSrcObject<FbxAnimStack>(anim_stack_index);
+            m_fbx_scene->SetCurrentAnimationStack(anim_stack);
+
+            const FbxTimeSpan time_span = anim_stack->GetLocalTimeSpan();
+            SAnimationClip&   clip = animations.emplace_back();
+            clip.name = anim_stack->GetName();
+            clip.frame_rate = static_cast<float>(FbxTime::GetFrameRate(time_mode));
+            clip.frame_count = static_cast<uint32_t>(std::max<FbxLongLong>(time_span.GetDuration().GetFrameCount(time_mode), 0) + 1);
+            clip.frames.resize(static_cast<size_t>(clip.frame_count) * bones.size());
+            std::vector<FbxAMatrix> global_poses(bones.size());
+            for (uint32_t frame = 0; frame < clip.frame_count; ++frame)
+            {
+                FbxTime time;
+                time.SetFrame(frame, time_mode);
+                time += time_span.GetStart();
+                for (size_t bone_index = 0; bone_index < bones.size(); ++bone_index)
+                {
+                    global_poses[bone_index] = bone_nodes[bone_index]->EvaluateGlobalTransform(time);
+                }
+                for (size_t bone_index = 0; bone_index < bones.size(); ++bone_index)
+                {
+                    const int32_t parent_index = bones[bone_index].parent_index;
+                    const FbxAMatrix local = parent_index >= 0 ? global_poses[parent_index].Inverse() * global_poses[bone_index] : global_poses[bone_index];
+                    clip.frames[frame * bones.size() + bone_index] = ToBoneTransform(local);
+                }
+            }
+        }
 	}
 
 	void CFbxImporter::ReleaseScene()
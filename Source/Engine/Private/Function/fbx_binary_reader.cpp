@@ -0,0 +1,581 @@
+﻿#include "Function/fbx_binary_reader.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "Core/inflate.h"
+#include "Core/triangulation.h"
+#include "Core/vertex_welder.h"
+
+namespace FireEngine
+{
+	namespace
+	{
+		constexpr char     c_fbx_magic[] = "Kaydara FBX Binary  ";
+		constexpr uint64_t c_fbx_header_size = 27;
+
+		template <typename T>
+		inline T LoadUnaligned(const uint8_t* data)
+		{
+			T value;
+			memcpy(&value, data, sizeof(T));
+			return value;
+		}
+
+		inline uint32_t ScalarSize(char type)
+		{
+			switch (type)
+			{
+			case 'C': return 1;
+			case 'Y': return 2;
+			case 'I':
+			case 'F': return 4;
+			case 'D':
+			case 'L': return 8;
+			default: return 0;
+			}
+		}
+
+		inline uint32_t ArrayElementSize(char type)
+		{
+			switch (type)
+			{
+			case 'b': return 1;
+			case 'i':
+			case 'f': return 4;
+			case 'd':
+			case 'l': return 8;
+			default: return 0;
+			}
+		}
+
+		template <typename T>
+		bool ConvertArray(const SFbxProperty& property, const uint8_t* source, std::vector<T>& out_values)
+		{
+			out_values.resize(property.array_length);
+			const uint32_t element_size = ArrayElementSize(property.type);
+			for (uint32_t i = 0; i < property.array_length; ++i)
+			{
+				const uint8_t* element = source + static_cast<uint64_t>(i) * element_size;
+				switch (property.type)
+				{
+				case 'b': out_values[i] = static_cast<T>(element[0]); break;
+				case 'i': out_values[i] = static_cast<T>(LoadUnaligned<int32_t>(element)); break;
+				case 'f': out_values[i] = static_cast<T>(LoadUnaligned<float>(element)); break;
+				case 'd': out_values[i] = static_cast<T>(LoadUnaligned<double>(element)); break;
+				case 'l': out_values[i] = static_cast<T>(LoadUnaligned<int64_t>(element)); break;
+				default: return false;
+				}
+			}
+			return true;
+		}
+
+		template <typename T>
+		bool DecodeArray(const SFbxProperty& property, std::vector<T>& out_values)
+		{
+			const uint32_t element_size = ArrayElementSize(property.type);
+			if (element_size == 0)
+			{
+				return false;
+			}
+			const uint64_t expected_size = static_cast<uint64_t>(property.array_length) * element_size;
+			if (property.encoding == 0)
+			{
+				return property.byte_length == expected_size && ConvertArray(property, property.data, out_values);
+			}
+			if (property.encoding != 1)
+			{
+				return false;
+			}
+
+			// 压缩数组在这里才解压, 没读到的数组永远不会占用内存
+			thread_local std::vector<uint8_t> inflated;
+			inflated.resize(expected_size);
+			uint64_t decoded_size = 0;
+			if (!ZlibInflate({ property.data, property.byte_length }, inflated.data(), expected_size, decoded_size) || decoded_size != expected_size)
+			{
+				return false;
+			}
+			return ConvertArray(property, inflated.data(), out_values);
+		}
+	}
+
+	bool CFbxBinaryReader::Open(const SByteView& data)
+	{
+		m_data = {};
+		if (data.size < c_fbx_header_size || memcmp(data.data, c_fbx_magic, sizeof(c_fbx_magic)) != 0)
+		{
+			return false;
+		}
+		m_data = data;
+		m_version = LoadUnaligned<uint32_t>(data.data + 23);
+		m_offset_size = m_version >= 7500 ? 8 : 4;
+		return true;
+	}
+
+	bool CFbxBinaryReader::ReadNode(const uint8_t* cursor, const uint8_t* parent_end, SFbxNode& out_node) const
+	{
+		const uint8_t* file_end = m_data.data + m_data.size;
+		const uint64_t header_size = m_offset_size * 3ull + 1;
+		if (cursor < m_data.data || cursor > parent_end || static_cast<uint64_t>(parent_end - cursor) < header_size)
+		{
+			return false;
+		}
+
+		uint64_t end_offset;
+		uint64_t property_count;
+		uint64_t property_bytes;
+		if (m_offset_size == 8)
+		{
+			end_offset = LoadUnaligned<uint64_t>(cursor);
+			property_count = LoadUnaligned<uint64_t>(cursor + 8);
+			property_bytes = LoadUnaligned<uint64_t>(cursor + 16);
+		}
+		else
+		{
+			end_offset = LoadUnaligned<uint32_t>(cursor);
+			property_count = LoadUnaligned<uint32_t>(cursor + 4);
+			property_bytes = LoadUnaligned<uint32_t>(cursor + 8);
+		}
+		// 全零的记录表示兄弟节点列表结束
+		if (end_offset == 0)
+		{
+			return false;
+		}
+
+		const uint8_t  name_length = cursor[header_size - 1];
+		const uint8_t* name = cursor + header_size;
+		const uint8_t* properties = name + name_length;
+		if (end_offset > m_data.size || properties > file_end || property_bytes > static_cast<uint64_t>(file_end - properties))
+		{
+			return false;
+		}
+		const uint8_t* children = properties + property_bytes;
+		const uint8_t* end = m_data.data + end_offset;
+		if (end < children || end > parent_end)
+		{
+			return false;
+		}
+
+		out_node.name = std::string_view(reinterpret_cast<const char*>(name), name_length);
+		out_node.property_count = property_count;
+		out_node.properties = properties;
+		out_node.children = children;
+		out_node.end = end;
+		out_node.parent_end = parent_end;
+		return true;
+	}
+
+	bool CFbxBinaryReader::FirstNode(SFbxNode& out_node) const
+	{
+		if (!m_data.data)
+		{
+			return false;
+		}
+		return ReadNode(m_data.data + c_fbx_header_size, m_data.data + m_data.size, out_node);
+	}
+
+	bool CFbxBinaryReader::FirstChild(const SFbxNode& parent, SFbxNode& out_child) const
+	{
+		return ReadNode(parent.children, parent.end, out_child);
+	}
+
+	bool CFbxBinaryReader::NextSibling(SFbxNode& node) const
+	{
+		const SFbxNode current = node;
+		return ReadNode(current.end, current.parent_end, node);
+	}
+
+	bool CFbxBinaryReader::FindChild(const SFbxNode& parent, std::string_view name, SFbxNode& out_child) const
+	{
+		SFbxNode child;
+		for (bool valid = FirstChild(parent, child); valid; valid = NextSibling(child))
+		{
+			if (child.name == name)
+			{
+				out_child = child;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool CFbxBinaryReader::GetProperty(const SFbxNode& node, uint32_t property_index, SFbxProperty& out_property) const
+	{
+		if (property_index >= node.property_count)
+		{
+			return false;
+		}
+
+		const uint8_t* cursor = node.properties;
+		for (uint32_t index = 0; index <= property_index; ++index)
+		{
+			if (cursor >= node.children)
+			{
+				return false;
+			}
+			SFbxProperty property;
+			property.type = static_cast<char>(*cursor++);
+			const uint64_t remain = static_cast<uint64_t>(node.children - cursor);
+			uint64_t       size = ScalarSize(property.type);
+			if (size != 0)
+			{
+				property.data = cursor;
+				property.byte_length = static_cast<uint32_t>(size);
+			}
+			else if (property.type == 'S' || property.type == 'R')
+			{
+				if (remain < 4)
+				{
+					return false;
+				}
+				property.byte_length = LoadUnaligned<uint32_t>(cursor);
+				property.data = cursor + 4;
+				size = 4ull + property.byte_length;
+			}
+			else if (ArrayElementSize(property.type) != 0)
+			{
+				if (remain < 12)
+				{
+					return false;
+				}
+				property.array_length = LoadUnaligned<uint32_t>(cursor);
+				property.encoding = LoadUnaligned<uint32_t>(cursor + 4);
+				property.byte_length = LoadUnaligned<uint32_t>(cursor + 8);
+				property.data = cursor + 12;
+				size = 12ull + property.byte_length;
+			}
+			else
+			{
+				return false;
+			}
+			if (size > remain)
+			{
+				return false;
+			}
+			if (index == property_index)
+			{
+				out_property = property;
+				return true;
+			}
+			cursor += size;
+		}
+		return false;
+	}
+
+	std::string_view CFbxBinaryReader::GetString(const SFbxNode& node, uint32_t property_index) const
+	{
+		SFbxProperty property;
+		if (!GetProperty(node, property_index, property) || (property.type != 'S' && property.type != 'R'))
+		{
+			return {};
+		}
+		return std::string_view(reinterpret_cast<const char*>(property.data), property.byte_length);
+	}
+
+	bool CFbxBinaryReader::ReadArray(const SFbxProperty& property, std::vector<double>& out_values) const
+	{
+		return DecodeArray(property, out_values);
+	}
+
+	bool CFbxBinaryReader::ReadArray(const SFbxProperty& property, std::vector<int32_t>& out_values) const
+	{
+		return DecodeArray(property, out_values);
+	}
+
+	namespace
+	{
+		enum class EFbxMapping : uint8_t
+		{
+			None,
+			ByPolygonVertex,
+			ByControlPoint,
+			ByPolygon,
+			AllSame,
+		};
+
+		// 一个 LayerElementXXX, 只取第一层
+		struct SFbxLayerElement
+		{
+			EFbxMapping          mapping{ EFbxMapping::None };
+			bool                 indexed{ false };
+			uint32_t             component_count{ 0 };
+			std::vector<double>  values;
+			std::vector<int32_t> indices;
+
+			const double* Lookup(uint32_t polygon_vertex, uint32_t control_point, uint32_t polygon) const
+			{
+				uint64_t element = 0;
+				switch (mapping)
+				{
+				case EFbxMapping::ByPolygonVertex: element = polygon_vertex; break;
+				case EFbxMapping::ByControlPoint:  element = control_point; break;
+				case EFbxMapping::ByPolygon:       element = polygon; break;
+				case EFbxMapping::AllSame:         element = 0; break;
+				default: return nullptr;
+				}
+				if (indexed)
+				{
+					if (element >= indices.size() || indices[element] < 0)
+					{
+						return nullptr;
+					}
+					element = static_cast<uint64_t>(indices[element]);
+				}
+				if ((element + 1) * component_count > values.size())
+				{
+					return nullptr;
+				}
+				return &values[element * component_count];
+			}
+		};
+
+		EFbxMapping ParseMapping(std::string_view mapping)
+		{
+			if (mapping == "ByPolygonVertex")
+			{
+				return EFbxMapping::ByPolygonVertex;
+			}
+			if (mapping == "ByVertice" || mapping == "ByVertex" || mapping == "ByControlPoint")
+			{
+				return EFbxMapping::ByControlPoint;
+			}
+			if (mapping == "ByPolygon")
+			{
+				return EFbxMapping::ByPolygon;
+			}
+			if (mapping == "AllSame")
+			{
+				return EFbxMapping::AllSame;
+			}
+			return EFbxMapping::None;
+		}
+
+		bool ReadArrayChild(const CFbxBinaryReader& reader, const SFbxNode& parent, std::string_view name, std::vector<double>& out_values)
+		{
+			SFbxNode     child;
+			SFbxProperty property;
+			return reader.FindChild(parent, name, child) && reader.GetProperty(child, 0, property) && reader.ReadArray(property, out_values);
+		}
+
+		bool ReadArrayChild(const CFbxBinaryReader& reader, const SFbxNode& parent, std::string_view name, std::vector<int32_t>& out_values)
+		{
+			SFbxNode     child;
+			SFbxProperty property;
+			return reader.FindChild(parent, name, child) && reader.GetProperty(child, 0, property) && reader.ReadArray(property, out_values);
+		}
+
+		void ReadLayerElement(const CFbxBinaryReader& reader, const SFbxNode& geometry, std::string_view element_name, std::string_view values_name, std::string_view indices_name, uint32_t component_count, SFbxLayerElement& out_element)
+		{
+			out_element.mapping = EFbxMapping::None;
+			SFbxNode element;
+			if (!reader.FindChild(geometry, element_name, element))
+			{
+				return;
+			}
+
+			SFbxNode mapping_node;
+			SFbxNode reference_node;
+			if (!reader.FindChild(element, "MappingInformationType", mapping_node) || !reader.FindChild(element, "ReferenceInformationType", reference_node))
+			{
+				return;
+			}
+			const std::string_view reference = reader.GetString(reference_node, 0);
+			out_element.indexed = reference == "IndexToDirect" || reference == "Index";
+			out_element.component_count = component_count;
+			if (!ReadArrayChild(reader, element, values_name, out_element.values))
+			{
+				return;
+			}
+			// 有的导出器标了 IndexToDirect 却不写索引数组, 此时按 Direct 读取
+			if (out_element.indexed && !ReadArrayChild(reader, element, indices_name, out_element.indices))
+			{
+				out_element.indexed = false;
+			}
+			out_element.mapping = ParseMapping(reader.GetString(mapping_node, 0));
+		}
+
+		bool ReadGeometry(const CFbxBinaryReader& reader, const SFbxNode& geometry, std::vector<SVertexInstance>& out_vertices, std::vector<IndexType>& out_indices)
+		{
+			std::vector<double>  control_points;
+			std::vector<int32_t> polygon_vertices;
+			if (!ReadArrayChild(reader, geometry, "Vertices", control_points) || !ReadArrayChild(reader, geometry, "PolygonVertexIndex", polygon_vertices))
+			{
+				return false;
+			}
+			const uint64_t control_point_count = control_points.size() / 3;
+
+			SFbxLayerElement normals;
+			SFbxLayerElement uvs;
+			SFbxLayerElement colors;
+			ReadLayerElement(reader, geometry, "LayerElementNormal", "Normals", "NormalsIndex", 3, normals);
+			ReadLayerElement(reader, geometry, "LayerElementUV", "UV", "UVIndex", 2, uvs);
+			ReadLayerElement(reader, geometry, "LayerElementColor", "Colors", "ColorIndex", 4, colors);
+
+			out_vertices.reserve(out_vertices.size() + polygon_vertices.size());
+			uint32_t polygon = 0;
+			uint32_t polygon_begin = 0;
+			for (uint32_t polygon_vertex = 0; polygon_vertex < polygon_vertices.size(); ++polygon_vertex)
+			{
+				// 多边形最后一个角的下标按位取反存放
+				if (polygon_vertices[polygon_vertex] >= 0)
+				{
+					continue;
+				}
+
+				const uint32_t corner_count = polygon_vertex + 1 - polygon_begin;
+				const size_t   vertex_begin = out_vertices.size();
+				bool           valid_polygon = corner_count >= 3;
+				bool           missing_normal = false;
+				for (uint32_t corner = 0; corner < corner_count && valid_polygon; ++corner)
+				{
+					const uint32_t pv = polygon_begin + corner;
+					const int32_t  raw_index = polygon_vertices[pv];
+					const uint32_t control_point = static_cast<uint32_t>(raw_index < 0 ? ~raw_index : raw_index);
+					if (control_point >= control_point_count)
+					{
+						valid_polygon = false;
+						break;
+					}
+
+					SVertexInstance& vert = out_vertices.emplace_back();
+					const double*    position = &control_points[control_point * 3ull];
+					vert.position[0] = static_cast<float>(position[0]);
+					vert.position[1] = static_cast<float>(position[1]);
+					vert.position[2] = static_cast<float>(position[2]);
+					vert.position[3] = 1.0f;
+
+					if (const double* normal = normals.Lookup(pv, control_point, polygon))
+					{
+						const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+						const double inv_length = length > 0.0 ? 1.0 / length : 0.0;
+						vert.normal[0] = static_cast<float>(normal[0] * inv_length);
+						vert.normal[1] = static_cast<float>(normal[1] * inv_length);
+						vert.normal[2] = static_cast<float>(normal[2] * inv_length);
+					}
+					else
+					{
+						missing_normal = true;
+					}
+					if (const double* uv = uvs.Lookup(pv, control_point, polygon))
+					{
+						vert.uv[0] = static_cast<float>(uv[0]);
+						vert.uv[1] = static_cast<float>(uv[1]);
+					}
+					if (const double* color = colors.Lookup(pv, control_point, polygon))
+					{
+						for (uint32_t i = 0; i < 4; ++i)
+						{
+							vert.color[i] = static_cast<float>(color[i]);
+						}
+					}
+				}
+
+				if (!valid_polygon)
+				{
+					out_vertices.resize(vertex_begin);
+					printf("[error]:fbx invalid polygon %u!\n", polygon);
+				}
+				else
+				{
+					// 缺法线时与OBJ一致使用面法线
+					if (missing_normal)
+					{
+						float face_normal[3] = { 0.0f, 0.0f, 0.0f };
+						for (uint32_t i = 0; i < corner_count; ++i)
+						{
+							const float* current = out_vertices[vertex_begin + i].position;
+							const float* next = out_vertices[vertex_begin + (i + 1) % corner_count].position;
+							face_normal[0] -= (current[1] - next[1]) * (current[2] + next[2]);
+							face_normal[1] -= (current[2] - next[2]) * (current[0] + next[0]);
+							face_normal[2] -= (current[0] - next[0]) * (current[1] + next[1]);
+						}
+						const float length = std::sqrt(face_normal[0] * face_normal[0] + face_normal[1] * face_normal[1] + face_normal[2] * face_normal[2]);
+						const float inv_length = length > 0.0f ? 1.0f / length : 0.0f;
+						for (uint32_t i = 0; i < corner_count; ++i)
+						{
+							float* normal = out_vertices[vertex_begin + i].normal;
+							normal[0] = face_normal[0] * inv_length;
+							normal[1] = face_normal[1] * inv_length;
+							normal[2] = face_normal[2] * inv_length;
+						}
+					}
+					TriangulatePolygon(out_vertices[vertex_begin].position, sizeof(SVertexInstance) / sizeof(float), corner_count, out_indices, static_cast<IndexType>(vertex_begin));
+				}
+
+				++polygon;
+				polygon_begin = polygon_vertex + 1;
+			}
+			return true;
+		}
+	}
+
+	bool ReadFbxMesh(const SByteView& data, CMesh& out_mesh)
+	{
+		CFbxBinaryReader reader;
+		if (!reader.Open(data))
+		{
+			printf("[error]:not a binary fbx!\n");
+			return false;
+		}
+
+		SFbxNode objects;
+		bool     found_objects = false;
+		for (bool valid = reader.FirstNode(objects); valid; valid = reader.NextSibling(objects))
+		{
+			if (objects.name == "Objects")
+			{
+				found_objects = true;
+				break;
+			}
+		}
+		if (!found_objects)
+		{
+			printf("[error]:fbx has no Objects!\n");
+			return false;
+		}
+
+		auto&    vertices = out_mesh.m_vretices;
+		auto&    indices = out_mesh.m_indices;
+		uint32_t mesh_count = 0;
+		SFbxNode object;
+		for (bool valid = reader.FirstChild(objects, object); valid; valid = reader.NextSibling(object))
+		{
+			if (object.name != "Geometry" || reader.GetString(object, 2) != "Mesh")
+			{
+				continue;
+			}
+			if (!ReadGeometry(reader, object, vertices, indices))
+			{
+				printf("[error]:fbx geometry %u is incomplete!\n", mesh_count);
+				return false;
+			}
+			++mesh_count;
+		}
+		if (mesh_count == 0)
+		{
+			printf("[error]:fbx has no mesh!\n");
+			return false;
+		}
+
+		WeldVertices(vertices, indices);
+		return true;
+	}
+
+	bool LoadFbxMesh(const std::string& file_name, CMesh* out_mesh)
+	{
+		CMappedFile mapped_file;
+		if (!mapped_file.Open(file_name))
+		{
+			printf("[error]:open %s failed!\n", file_name.c_str());
+			return false;
+		}
+		if (!ReadFbxMesh(mapped_file.GetView(), *out_mesh))
+		{
+			printf("[error]:parse %s failed!\n", file_name.c_str());
+			return false;
+		}
+		return true;
+	}
+}
@@ -22,4 +22,14 @@ namespace FireEngine
 	void CLevel::TickLevel(float dt)
 	{
 	}
+
+	FActorHandle CLevel::SpawnActor()
+	{
+		return m_actors.Emplace();
+	}
+
+	void CLevel::DestroyActor(FActorHandle actor)
+	{
+		m_actors.Erase(actor);
+	}
 }
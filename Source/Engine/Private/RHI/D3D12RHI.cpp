@@ -5,6 +5,7 @@
 #include "RayTracingHlslCompat.h"
 #include "Core/define.h"
 #include "Core/basic_math.h"
+#include "Classes/cooked_texture.h"
 namespace FireEngine
 {
 	const wchar_t* c_hitGroupNames_TriangleGeometry[] =
@@ -17,6 +18,22 @@ namespace FireEngine
 	{
 		L"MyMissShader", L"MyMissShader_ShadowRay"
 	};
+
+	static_assert(c_cooked_texture_row_pitch_alignment == D3D12_TEXTURE_DATA_PITCH_ALIGNMENT, ".fetex row pitch must match the upload heap");
+	static_assert(c_cooked_texture_placement_alignment == D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, ".fetex placement must match the upload heap");
+
+	static DXGI_FORMAT ToDxgiFormat(ETextureFormat format)
+	{
+		switch (format)
+		{
+		case ETextureFormat::BC1: return DXGI_FORMAT_BC1_UNORM;
+		case ETextureFormat::BC3: return DXGI_FORMAT_BC3_UNORM;
+		case ETextureFormat::BC5: return DXGI_FORMAT_BC5_UNORM;
+		case ETextureFormat::BC7: return DXGI_FORMAT_BC7_UNORM;
+		default:                  return DXGI_FORMAT_R8G8B8A8_UNORM;
+		}
+	}
+
 	D3D12RHI::D3D12RHI(const HWND& hwnd)
 	{
 		// 打开显示子系统的调试支持
@@ -376,7 +393,7 @@ namespace FireEngine
 		m_pipeline_states.emplace_back(pipeline_state_line);
 	}
 
-	void D3D12RHI::CreateRayTracingPipelineStateObject(const std::vector<uint8_t>& shader_byte_code)
+	bool D3D12RHI::CreateRayTracingPipelineStateObject(const SByteView& shader_byte_code)
 	{
 		std::vector<D3D12_STATE_SUBOBJECT> state_subobjects;
 		state_subobjects.resize(8);
@@ -418,8 +435,8 @@ namespace FireEngine
 
 		stRayGenDxilLibDesc.NumExports                  = _countof(stRayGenExportDesc);
 		stRayGenDxilLibDesc.pExports                    = stRayGenExportDesc;
-		stRayGenDxilLibDesc.DXILLibrary.pShaderBytecode = shader_byte_code.data();
-		stRayGenDxilLibDesc.DXILLibrary.BytecodeLength  = shader_byte_code.size();
+		stRayGenDxilLibDesc.DXILLibrary.pShaderBytecode = shader_byte_code.data;
+		stRayGenDxilLibDesc.DXILLibrary.BytecodeLength  = shader_byte_code.size;
 
 		D3D12_STATE_SUBOBJECT stSubObjDXILLib = {};
 		stSubObjDXILLib.Type                  = D3D12_STATE_SUBOBJECT_TYPE_DXIL_LIBRARY;
@@ -489,8 +506,27 @@ namespace FireEngine
 		stRaytracingPSOdesc.NumSubobjects           = (UINT)state_subobjects.size();
 		stRaytracingPSOdesc.pSubobjects             = state_subobjects.data();
 
-		// 创建管线状态对象
-		CHECK_RESULT(m_d3d12_device->CreateStateObject( &stRaytracingPSOdesc , IID_PPV_ARGS(&m_raytracing_state_object)))
+		// 创建管线状态对象, 失败时保留原来的管线, 热重载的着色器可能有错
+		ComPtr<ID3D12StateObject> raytracing_state_object;
+		if (FAILED(m_d3d12_device->CreateStateObject( &stRaytracingPSOdesc , IID_PPV_ARGS(&raytracing_state_object))))
+		{
+			printf("[error]:create raytracing pipeline state object failed!\n");
+			return false;
+		}
+		m_raytracing_state_object = raytracing_state_object;
+		return true;
+	}
+
+	bool D3D12RHI::ReloadRayTracingPipeline(const SByteView& shader_byte_code)
+	{
+		FlushCommandQueue();
+		if (!CreateRayTracingPipelineStateObject(shader_byte_code))
+		{
+			return false;
+		}
+		// 着色器标识符随管线变化, 着色器表要重新填写
+		CreateShaderTable();
+		return true;
 	}
 
 	void D3D12RHI::CreateRenderEndFence()
@@ -681,19 +717,153 @@ namespace FireEngine
 		}
 	}
 
-	void D3D12RHI::CreateTexture(std::vector<uint8_t>& texture_data, uint32_t width, uint32_t height)
+	FTextureHandle D3D12RHI::CreateTexture(const CTexture& texture)
 	{
-		ComPtr<ID3D12Resource> tex_upload_res;
-		ComPtr<ID3D12Resource> tex_res;
+		std::vector<STextureSubresource> subresources;
+		return CreateTexture(texture.GetView(subresources));
+	}
+
+	FTextureHandle D3D12RHI::CreateTexture(const STextureView& texture)
+	{
+		if (!texture.data || texture.subresource_count == 0)
+		{
+			printf("[error]:texture has no data!\n");
+			return {};
+		}
+		const UINT mip_count = texture.subresource_count;
+
+		ComPtr<ID3D12Resource> tex_res = CreateTextureResource(ToDxgiFormat(texture.format), texture.width, texture.height, static_cast<UINT16>(mip_count));
+		if (!tex_res)
+		{
+			return {};
+		}
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> stTxtLayouts;
+		ComPtr<ID3D12Resource> tex_upload_res = CreateTextureUploadBuffer(tex_res.Get(), texture, stTxtLayouts);
+		if (!tex_upload_res)
+		{
+			return {};
+		}
+
+		CHECK_RESULT(m_cmd_allocator->Reset())
+		CHECK_RESULT(m_cmd_list->Reset(m_cmd_allocator.Get(), nullptr))
+		RecordTextureUpload(tex_upload_res.Get(), stTxtLayouts, tex_res.Get());
+		FinishTextureCopy(tex_res.Get());
+		// 拷贝已经完成, 上传堆可以随 tex_upload_res 一起释放
+		return m_textures.Insert(tex_res);
+	}
+
+	void D3D12RHI::ReleaseTexture(FTextureHandle texture)
+	{
+		ComPtr<ID3D12Resource>* resource = m_textures.Get(texture);
+		if (!resource)
+		{
+			return;
+		}
+		RetireResource(std::move(*resource));
+		m_textures.Erase(texture);
+	}
+
+	uint64_t D3D12RHI::GetTextureMemorySize(FTextureHandle texture) const
+	{
+		const ComPtr<ID3D12Resource>* resource = m_textures.Get(texture);
+		if (!resource)
+		{
+			return 0;
+		}
+		const D3D12_RESOURCE_DESC desc = (*resource)->GetDesc();
+		return m_d3d12_device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+	}
+
+	bool D3D12RHI::ExtendTextureMips(FTextureHandle texture, const STextureView& finer_mips)
+	{
+		ComPtr<ID3D12Resource>* resource = m_textures.Get(texture);
+		if (!resource || !finer_mips.data || finer_mips.subresource_count == 0)
+		{
+			return false;
+		}
+		const D3D12_RESOURCE_DESC old_desc = (*resource)->GetDesc();
+		const UINT new_mip_count = finer_mips.subresource_count;
+		const UINT mip_count = new_mip_count + old_desc.MipLevels;
+		// finer_mips 的下一层必须正好是现有的最高层
+		const UINT64 next_width = finer_mips.width >> new_mip_count ? finer_mips.width >> new_mip_count : 1;
+		const UINT next_height = finer_mips.height >> new_mip_count ? finer_mips.height >> new_mip_count : 1;
+		if (mip_count > D3D12_REQ_MIP_LEVELS || next_width != old_desc.Width || next_height != old_desc.Height
+			|| ToDxgiFormat(finer_mips.format) != old_desc.Format)
+		{
+			printf("[error]:texture mips do not match the resident mips!\n");
+			return false;
+		}
 
+		ComPtr<ID3D12Resource> tex_res = CreateTextureResource(old_desc.Format, finer_mips.width, finer_mips.height, static_cast<UINT16>(mip_count));
+		if (!tex_res)
+		{
+			return false;
+		}
+		SPendingTextureCopy copy;
+		copy.upload = CreateTextureUploadBuffer(tex_res.Get(), finer_mips, copy.upload_layouts);
+		if (!copy.upload)
+		{
+			return false;
+		}
+
+		// 已经常驻的层级在 GPU 上拷贝, 旧贴图从 COMMON 隐式提升为 COPY_SOURCE
+		// 同一帧里对同一张贴图的多次修改按顺序记录, 后一次以前一次的新贴图为源
+		copy.src = std::move(*resource);
+		copy.src_first_mip = 0;
+		copy.dest = tex_res;
+		copy.dest_first_mip = new_mip_count;
+		copy.mip_count = old_desc.MipLevels;
+		m_pending_texture_copies.emplace_back(std::move(copy));
+		*resource = std::move(tex_res);
+		return true;
+	}
+
+	bool D3D12RHI::TrimTextureMips(FTextureHandle texture, uint32_t drop_count)
+	{
+		ComPtr<ID3D12Resource>* resource = m_textures.Get(texture);
+		if (!resource)
+		{
+			return false;
+		}
+		const D3D12_RESOURCE_DESC old_desc = (*resource)->GetDesc();
+		if (drop_count == 0)
+		{
+			return true;
+		}
+		if (drop_count >= old_desc.MipLevels)
+		{
+			return false;
+		}
+		const UINT   mip_count = old_desc.MipLevels - drop_count;
+		const UINT64 width = old_desc.Width >> drop_count ? old_desc.Width >> drop_count : 1;
+		const UINT   height = old_desc.Height >> drop_count ? old_desc.Height >> drop_count : 1;
+		ComPtr<ID3D12Resource> tex_res = CreateTextureResource(old_desc.Format, width, height, static_cast<UINT16>(mip_count));
+		if (!tex_res)
+		{
+			return false;
+		}
+
+		SPendingTextureCopy copy;
+		copy.src = std::move(*resource);
+		copy.src_first_mip = drop_count;
+		copy.dest = tex_res;
+		copy.dest_first_mip = 0;
+		copy.mip_count = mip_count;
+		m_pending_texture_copies.emplace_back(std::move(copy));
+		*resource = std::move(tex_res);
+		return true;
+	}
+
+	ComPtr<ID3D12Resource> D3D12RHI::CreateTextureResource(DXGI_FORMAT format, UINT64 width, UINT height, UINT16 mip_count)
+	{
 		D3D12_HEAP_PROPERTIES stTextureHeapProp = {};
 		stTextureHeapProp.Type                  = D3D12_HEAP_TYPE_DEFAULT;
 
 		D3D12_RESOURCE_DESC stTextureDesc = {};
 
 		stTextureDesc.Dimension          = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-		stTextureDesc.MipLevels          = 1;
-		stTextureDesc.Format             = DXGI_FORMAT_B8G8R8A8_UNORM;
+		stTextureDesc.MipLevels          = mip_count;
+		stTextureDesc.Format             = format;
 		stTextureDesc.Width              = width;
 		stTextureDesc.Height             = height;
 		stTextureDesc.Flags              = D3D12_RESOURCE_FLAG_NONE;
@@ -701,15 +871,23 @@ namespace FireEngine
 		stTextureDesc.SampleDesc.Count   = 1;
 		stTextureDesc.SampleDesc.Quality = 0;
 
+		ComPtr<ID3D12Resource> tex_res;
 		CHECK_RESULT(m_d3d12_device->CreateCommittedResource( &stTextureHeapProp , D3D12_HEAP_FLAG_NONE , &stTextureDesc //可以使用CD3DX12_RESOURCE_DESC::Tex2D来简化结构体的初始化
 			, D3D12_RESOURCE_STATE_COPY_DEST , nullptr , IID_PPV_ARGS(&tex_res)));
+		return tex_res;
+	}
+
+	ComPtr<ID3D12Resource> D3D12RHI::CreateTextureUploadBuffer(ID3D12Resource* dest, const STextureView& texture, std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>& out_layouts)
+	{
+		const UINT mip_count = texture.subresource_count;
 
 		//获取需要的上传堆资源缓冲的大小，这个尺寸通常大于实际图片的尺寸
-		D3D12_RESOURCE_DESC stDestDesc          = tex_res->GetDesc();
+		D3D12_RESOURCE_DESC stDestDesc          = dest->GetDesc();
 		UINT64              n64UploadBufferSize = 0;
-		m_d3d12_device->GetCopyableFootprints(&stDestDesc, 0, 1, 0, nullptr, nullptr, nullptr, &n64UploadBufferSize);
+		m_d3d12_device->GetCopyableFootprints(&stDestDesc, 0, mip_count, 0, nullptr, nullptr, nullptr, &n64UploadBufferSize);
 
-		stTextureHeapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+		D3D12_HEAP_PROPERTIES stUploadHeapProp = {};
+		stUploadHeapProp.Type                  = D3D12_HEAP_TYPE_UPLOAD;
 
 		D3D12_RESOURCE_DESC stUploadTextureDesc = {};
 
@@ -725,70 +903,150 @@ namespace FireEngine
 		stUploadTextureDesc.Layout             = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 		stUploadTextureDesc.Flags              = D3D12_RESOURCE_FLAG_NONE;
 
-		CHECK_RESULT(m_d3d12_device->CreateCommittedResource( &stTextureHeapProp , D3D12_HEAP_FLAG_NONE , &stUploadTextureDesc , D3D12_RESOURCE_STATE_GENERIC_READ , nullptr , IID_PPV_ARGS(&tex_upload_res)));
+		ComPtr<ID3D12Resource> tex_upload_res;
+		CHECK_RESULT(m_d3d12_device->CreateCommittedResource( &stUploadHeapProp , D3D12_HEAP_FLAG_NONE , &stUploadTextureDesc , D3D12_RESOURCE_STATE_GENERIC_READ , nullptr , IID_PPV_ARGS(&tex_upload_res)));
+		if (!tex_upload_res)
+		{
+			return nullptr;
+		}
 
-		UINT                               nNumSubresources   = 1u; //我们只有一副图片，即子资源个数为1
-		UINT                               nTextureRowNum     = 0u;
-		UINT64                             n64TextureRowSizes = 0u;
-		UINT64                             n64RequiredSize    = 0u;
-		D3D12_PLACED_SUBRESOURCE_FOOTPRINT stTxtLayouts       = {};
+		// 每个 mip 层级是一个子资源
+		out_layouts.resize(mip_count);
+		std::vector<UINT>   nTextureRowNums(mip_count);
+		std::vector<UINT64> n64TextureRowSizes(mip_count);
+		UINT64              n64RequiredSize = 0u;
 
-		m_d3d12_device->GetCopyableFootprints(&stDestDesc, 0, nNumSubresources, 0, &stTxtLayouts, &nTextureRowNum, &n64TextureRowSizes, &n64RequiredSize);
+		m_d3d12_device->GetCopyableFootprints(&stDestDesc, 0, mip_count, 0, out_layouts.data(), nTextureRowNums.data(), n64TextureRowSizes.data(), &n64RequiredSize);
 
 		BYTE* pData = nullptr;
 		CHECK_RESULT(tex_upload_res->Map(0, NULL, reinterpret_cast<void**>(&pData)));
 
-		BYTE*       dest_slice   = reinterpret_cast<BYTE*>(pData) + stTxtLayouts.Offset;
-		auto        image_data  = texture_data.data();
-		uint64_t    pic_row_pitch = (uint64_t)width * 4;
-		const BYTE* src_slice    = reinterpret_cast<const BYTE*>(image_data);
-		for (UINT y = 0; y < nTextureRowNum; ++y)
+		for (UINT mip = 0; mip < mip_count; ++mip)
 		{
-			memcpy(dest_slice + static_cast<SIZE_T>(stTxtLayouts.Footprint.RowPitch) * y, src_slice + pic_row_pitch * y, pic_row_pitch);
+			// 块压缩格式的一行是一行4x4的块, nTextureRowNums 也是块行数
+			const STextureSubresource& subresource = texture.subresources[mip];
+			BYTE*                      dest_slice = reinterpret_cast<BYTE*>(pData) + out_layouts[mip].Offset;
+			const BYTE*                src_slice = texture.data + subresource.offset;
+			const UINT64               dest_row_pitch = out_layouts[mip].Footprint.RowPitch;
+			if (subresource.row_pitch == dest_row_pitch)
+			{
+				memcpy(dest_slice, src_slice, static_cast<SIZE_T>(dest_row_pitch * (nTextureRowNums[mip] - 1) + n64TextureRowSizes[mip]));
+				continue;
+			}
+			for (UINT y = 0; y < nTextureRowNums[mip]; ++y)
+			{
+				memcpy(dest_slice + static_cast<SIZE_T>(dest_row_pitch) * y, src_slice + subresource.row_pitch * y, static_cast<SIZE_T>(subresource.row_size));
+			}
 		}
 		tex_upload_res->Unmap(0, nullptr);
+		return tex_upload_res;
+	}
 
-		D3D12_TEXTURE_COPY_LOCATION stDstCopyLocation = {};
-		stDstCopyLocation.pResource                   = tex_res.Get();
-		stDstCopyLocation.Type                        = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-		stDstCopyLocation.SubresourceIndex            = 0;
+	void D3D12RHI::RecordTextureUpload(ID3D12Resource* upload, const std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>& layouts, ID3D12Resource* dest)
+	{
+		for (UINT mip = 0; mip < static_cast<UINT>(layouts.size()); ++mip)
+		{
+			D3D12_TEXTURE_COPY_LOCATION stDstCopyLocation = {};
+			stDstCopyLocation.pResource                   = dest;
+			stDstCopyLocation.Type                        = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+			stDstCopyLocation.SubresourceIndex            = mip;
 
-		D3D12_TEXTURE_COPY_LOCATION stSrcCopyLocation = {};
-		stSrcCopyLocation.pResource                   = tex_upload_res.Get();
-		stSrcCopyLocation.Type                        = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-		stSrcCopyLocation.PlacedFootprint             = stTxtLayouts;
+			D3D12_TEXTURE_COPY_LOCATION stSrcCopyLocation = {};
+			stSrcCopyLocation.pResource                   = upload;
+			stSrcCopyLocation.Type                        = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+			stSrcCopyLocation.PlacedFootprint             = layouts[mip];
 
-		CHECK_RESULT(m_cmd_allocator->Reset())
-		CHECK_RESULT(m_cmd_list->Reset(m_cmd_allocator.Get(), nullptr))
-		m_cmd_list->CopyTextureRegion(&stDstCopyLocation, 0, 0, 0, &stSrcCopyLocation, nullptr);
+			m_cmd_list->CopyTextureRegion(&stDstCopyLocation, 0, 0, 0, &stSrcCopyLocation, nullptr);
+		}
+	}
 
-		D3D12_RESOURCE_BARRIER stResBar = {};
-		stResBar.Type                   = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-		stResBar.Flags                  = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-		stResBar.Transition.pResource   = tex_res.Get();
-		stResBar.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-		stResBar.Transition.StateAfter  = D3D12_RESOURCE_STATE_COMMON;
-		stResBar.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+	void D3D12RHI::CopyTextureMips(ID3D12Resource* src, UINT src_first_mip, ID3D12Resource* dest, UINT dest_first_mip, UINT mip_count)
+	{
+		for (UINT mip = 0; mip < mip_count; ++mip)
+		{
+			D3D12_TEXTURE_COPY_LOCATION dest_location = {};
+			dest_location.pResource = dest;
+			dest_location.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+			dest_location.SubresourceIndex = dest_first_mip + mip;
 
-		m_cmd_list->ResourceBarrier(1, &stResBar);
+			D3D12_TEXTURE_COPY_LOCATION src_location = {};
+			src_location.pResource = src;
+			src_location.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+			src_location.SubresourceIndex = src_first_mip + mip;
 
+			m_cmd_list->CopyTextureRegion(&dest_location, 0, 0, 0, &src_location, nullptr);
+		}
+	}
 
+	void D3D12RHI::RecordTextureCopyEnd(ID3D12Resource* texture)
+	{
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type                   = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barrier.Flags                  = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		barrier.Transition.pResource   = texture;
+		barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+		barrier.Transition.StateAfter  = D3D12_RESOURCE_STATE_COMMON;
+		barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+		m_cmd_list->ResourceBarrier(1, &barrier);
+	}
+
+	void D3D12RHI::FinishTextureCopy(ID3D12Resource* texture)
+	{
+		RecordTextureCopyEnd(texture);
 		CHECK_RESULT(m_cmd_list->Close())
+		ID3D12CommandList* command_lists[] = { m_cmd_list.Get() };
+		m_cmd_queue->ExecuteCommandLists(_countof(command_lists), command_lists);
+		FlushCommandQueue();
+	}
 
+	void D3D12RHI::RecordPendingTextureCopies()
+	{
+		for (SPendingTextureCopy& copy : m_pending_texture_copies)
+		{
+			if (copy.upload)
+			{
+				RecordTextureUpload(copy.upload.Get(), copy.upload_layouts, copy.dest.Get());
+			}
+			CopyTextureMips(copy.src.Get(), copy.src_first_mip, copy.dest.Get(), copy.dest_first_mip, copy.mip_count);
+			RecordTextureCopyEnd(copy.dest.Get());
+			// 三者都要活到本帧结束; 新贴图平时由槽位持有, 这里多留一个引用以防本帧前就被 ReleaseTexture 释放
+			RetireResource(std::move(copy.src));
+			RetireResource(std::move(copy.dest));
+			RetireResource(std::move(copy.upload));
+		}
+		m_pending_texture_copies.clear();
+	}
 
-		//执行命令列表
-		ID3D12CommandList* ppCommandLists[] = {m_cmd_list.Get()};
-		m_cmd_queue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	void D3D12RHI::RetireResource(ComPtr<ID3D12Resource> resource)
+	{
+		if (!resource)
+		{
+			return;
+		}
+		// m_fence_value 是下一次要提交的围栏值, 它在所有已经记录的命令之后才会到达
+		SRetiredResource& retired = m_retired_resources.emplace_back();
+		retired.fence_value = m_render_end_fence.m_fence_value;
+		retired.resource = std::move(resource);
+	}
 
-		//开始同步GPU与CPU的执行，先记录围栏标记值
+	void D3D12RHI::ReleaseRetiredResources()
+	{
+		const UINT64 completed_value = m_render_end_fence.m_fence->GetCompletedValue();
+		auto         first_pending = m_retired_resources.begin();
+		while (first_pending != m_retired_resources.end() && first_pending->fence_value <= completed_value)
+		{
+			++first_pending;
+		}
+		m_retired_resources.erase(m_retired_resources.begin(), first_pending);
+	}
+
+	void D3D12RHI::FlushCommandQueue()
+	{
 		const UINT64 n64CurrentFenceValue = m_render_end_fence.m_fence_value;
 		CHECK_RESULT(m_cmd_queue->Signal(m_render_end_fence.m_fence.Get(), n64CurrentFenceValue));
 		m_render_end_fence.m_fence_value++;
 		CHECK_RESULT(m_render_end_fence.m_fence->SetEventOnCompletion(n64CurrentFenceValue, m_render_end_fence.m_fence_event));
-
 		WaitForSingleObject(m_render_end_fence.m_fence_event, INFINITE);
-		m_textures.emplace_back(tex_upload_res);
-		m_textures.emplace_back(tex_res);
 	}
 
 	void D3D12RHI::WaitForFence() const
@@ -815,6 +1073,10 @@ namespace FireEngine
 			printf("[ERROR] Failed Reset CMD List!\n");
 		}
 
+		// 贴图流送的拷贝放在光追之前, 同一个队列上按顺序执行, 不需要额外等待
+		ReleaseRetiredResources();
+		RecordPendingTextureCopies();
+
 		{// 记录绘制指令
 			D3D12_DISPATCH_RAYS_DESC stDispatchRayDesc    = {};
 			stDispatchRayDesc.HitGroupTable.StartAddress  = m_hit_group_shader_table->GetGPUVirtualAddress();
@@ -928,9 +1190,10 @@ namespace FireEngine
 		return m_adapter_name;
 	}
 
-	void D3D12RHI::CreatePrimitives(const std::vector<SVertexInstance>& vertex_vector, const std::vector<IndexType>& vertex_indices)
+	FPrimitiveHandle D3D12RHI::CreatePrimitives(const std::vector<SVertexInstance>& vertex_vector, const std::vector<IndexType>& vertex_indices)
 	{
-		auto& primitive = m_render_primitives.emplace_back();
+		const FPrimitiveHandle primitive_handle = m_render_primitives.Emplace();
+		auto& primitive = *m_render_primitives.Get(primitive_handle);
 		{
 			ComPtr<ID3D12Resource2> vertex_buffer;
 			const UINT64            vertex_buffer_size = vertex_vector.size() * sizeof(SVertexInstance);
@@ -989,9 +1252,10 @@ namespace FireEngine
 			primitive.m_index_count  = static_cast<uint32_t>(vertex_indices.size());
 			primitive.m_index_stride = sizeof(IndexType);
 		}
+		return primitive_handle;
 	}
 
-	void D3D12RHI::CreatePrimitives(const std::vector<CMesh*>& meshes)
+	FPrimitiveHandle D3D12RHI::CreatePrimitives(const std::vector<CMesh*>& meshes)
 	{
 		uint64_t total_vertex_count = 0;
 		uint64_t total_index_count = 0;
@@ -1010,7 +1274,8 @@ namespace FireEngine
 
 		}
 
-		auto& primitive = m_render_primitives.emplace_back();
+		const FPrimitiveHandle primitive_handle = m_render_primitives.Emplace();
+		auto& primitive = *m_render_primitives.Get(primitive_handle);
 		primitive.m_index_count = total_index_count;
 		primitive.m_vertex_count = total_vertex_count;
 
@@ -1078,6 +1343,73 @@ namespace FireEngine
 			primitive.m_geometry_descs = geometry_desc_resource;
 		}
 		primitive.m_geometry_descs_cpu = std::move(geometry_descs);
+		return primitive_handle;
+	}
+
+	void D3D12RHI::ReleasePrimitives(FPrimitiveHandle primitive)
+	{
+		if (!m_render_primitives.Contains(primitive))
+		{
+			return;
+		}
+		FlushCommandQueue();
+		m_render_primitives.Erase(primitive);
+	}
+
+	uint64_t D3D12RHI::GetPrimitivesMemorySize(FPrimitiveHandle primitive) const
+	{
+		const SGeometryResource* resource = m_render_primitives.Get(primitive);
+		if (!resource)
+		{
+			return 0;
+		}
+		uint64_t size = 0;
+		for (ID3D12Resource2* buffer : { resource->m_vertex_buffer.Get(), resource->m_index_buffer.Get(), resource->m_geometry_descs.Get() })
+		{
+			if (buffer)
+			{
+				size += buffer->GetDesc().Width;
+			}
+		}
+		return size;
+	}
+
+	FPrimitiveHandle D3D12RHI::CreatePrimitives(const SMeshView& mesh)
+	{
+		const FPrimitiveHandle primitive_handle = m_render_primitives.Emplace();
+		auto& primitive = *m_render_primitives.Get(primitive_handle);
+		primitive.m_vertex_count = static_cast<uint32_t>(mesh.vertex_count);
+		primitive.m_index_count = static_cast<uint32_t>(mesh.index_count);
+		primitive.m_vertex_stride = sizeof(SVertexInstance);
+		primitive.m_index_stride = sizeof(IndexType);
+
+		D3D12_HEAP_PROPERTIES heap_prop = { D3D12_HEAP_TYPE_UPLOAD };
+		D3D12_RESOURCE_DESC   resource_desc = {};
+		resource_desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		resource_desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		resource_desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+		resource_desc.Format = DXGI_FORMAT_UNKNOWN;
+		resource_desc.Height = 1;
+		resource_desc.DepthOrArraySize = 1;
+		resource_desc.MipLevels = 1;
+		resource_desc.SampleDesc.Count = 1;
+		resource_desc.SampleDesc.Quality = 0;
+		D3D12_RANGE read_range = { 0, 0 };
+
+		// 数据已经是GPU布局(比如直接映射的.femesh), 每个缓冲只需要一次memcpy
+		auto create_buffer = [&](const void* data, UINT64 size, ComPtr<ID3D12Resource2>& out_buffer) {
+			resource_desc.Width = size;
+			CHECK_RESULT(m_d3d12_device->CreateCommittedResource(&heap_prop, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&out_buffer)));
+			UINT8* data_begin = nullptr;
+			out_buffer->Map(0, &read_range, reinterpret_cast<void**>(&data_begin));
+			memcpy(data_begin, data, size);
+			out_buffer->Unmap(0, nullptr);
+		};
+		create_buffer(mesh.vertices, mesh.vertex_count * sizeof(SVertexInstance), primitive.m_vertex_buffer);
+		create_buffer(mesh.indices, mesh.index_count * sizeof(IndexType), primitive.m_index_buffer);
+		create_buffer(mesh.geometries, mesh.geometry_count * sizeof(SGeometryDesc), primitive.m_geometry_descs);
+		primitive.m_geometry_descs_cpu.assign(mesh.geometries, mesh.geometries + mesh.geometry_count);
+		return primitive_handle;
 	}
 
 	void D3D12RHI::CreateMaterials()
@@ -1417,6 +1749,15 @@ namespace FireEngine
 		WaitForSingleObject(m_render_end_fence.m_fence_event, INFINITE);
 	}
 
+	void D3D12RHI::RebuildAccelerationStructures()
+	{
+		FlushCommandQueue();
+		CreateBottomLevelAccelerationStructure();
+		CreateTopLevelInstanceResource();
+		CreateTopLevelAccelerationStructure();
+		BuildDescHeap();
+	}
+
 	void D3D12RHI::BuildDescHeap()
 	{
 		D3D12_DESCRIPTOR_HEAP_DESC stDXRDescriptorHeapDesc = {};
@@ -1,6 +1,8 @@
 
 #include "Render/RenderingSystem.h"
 
+#include <algorithm>
+#include <cfloat>
 #include <DirectXMath.h>
 
 #include "Classes/texture.h"
@@ -8,8 +10,12 @@
 #include "Global/global_context.h"
 #include "RHI/D3D12RHI.h"
 #include "Core/ReadData.h"
-#include "atlconv.h"
 #include "Classes/mesh.h"
+#include "Classes/cooked_mesh.h"
+#include "Classes/cooked_texture.h"
+#include "Core/derived_data_cache.h"
+#include "Core/file_watcher.h"
+#include "Core/job_system.h"
 
 namespace FireEngine {
 	using namespace DirectX;
@@ -24,8 +30,250 @@ namespace FireEngine {
 	XMVECTOR g_vUp = { 0.0f, 1.0f, 0.0f, 0.0f };
 	XMVECTOR forward = g_vLookAt - g_vEye;
 
+	namespace
+	{
+		// ЩOBJϲ, ɫͲд決, ʱͬº決
+		const std::array<const char*, 6> c_mesh_file_names = {
+			"Resource/models/floor.obj",//white
+			"Resource/models/shortbox.obj",//white
+			"Resource/models/tallbox.obj",//white
+			"Resource/models/left.obj",//red
+			"Resource/models/right.obj",//green
+			"Resource/models/light.obj",//light
+		};
+		const std::array<XMFLOAT4, 6> c_mesh_colors = { {
+			{ 0.63f, 0.065f, 0.05f, 1.0f },
+			{ 0.63f, 0.45f, 0.05f, 1.0f },
+			{ 0.63f, 0.065f, 0.65f, 1.0f },
+			{ 0.14f, 0.45f, 0.091f, 1.0f },
+			{ 0.725f, 0.71f, 0.68f, 1.0f },
+			{ 0.65f, 0.65f, 0.65f, 1.0f },
+		} };
+		const std::array<uint32_t, 6> c_mesh_materials = { 2, 2, 2, 0, 1, 3 };
+
+		// ͼʹú決õ .fetex, ɫͼѹ BC7, ͼѹ BC5
+		struct STextureSource
+		{
+			const char*    source_path;
+			EAssetType     source_type;
+			EMipContent    mip_content;
+			ETextureFormat cooked_format;
+		};
+		const std::array<STextureSource, 2> c_texture_sources = { {
+			{ "Resource/texture/Earth4kTexture_4K.png", EAssetType::Texture, EMipContent::Color, ETextureFormat::BC7 },
+			{ "Resource/texture/Earth4kNormal_4K.png", EAssetType::NormalMap, EMipContent::NormalMap, ETextureFormat::BC5 },
+		} };
+
+		const char* const c_raytracing_shader_path = "Resource/Shader/Raytracing.cso";
+
+		// ݻļֻȡԴļ, 決汾ͺ決, Դļֻӳϣ
+		// Դļʱ false, ʱʹû
+		bool GetSceneMeshKey(CFileSystem* file_system, SHash128& out_key)
+		{
+			CContentHasher mesh_hasher;
+			mesh_hasher.AddValue(c_cooked_mesh_version).AddValue(c_mesh_cooker_version);
+			for (size_t i = 0; i < c_mesh_file_names.size(); ++i)
+			{
+				SFileData source;
+				if (!file_system->ReadFile(c_mesh_file_names[i], source))
+				{
+					printf("[error]:load %s failed!\n", c_mesh_file_names[i]);
+					return false;
+				}
+				mesh_hasher.Add(source.view.data, source.view.size).AddValue(c_mesh_colors[i]).AddValue(c_mesh_materials[i]);
+			}
+			out_key = mesh_hasher.Finish();
+			return true;
+		}
+
+		bool GetSceneTextureKey(CFileSystem* file_system, size_t index, SHash128& out_key)
+		{
+			const STextureSource& texture_source = c_texture_sources[index];
+			SFileData source;
+			if (!file_system->ReadFile(texture_source.source_path, source))
+			{
+				printf("[error]:load %s failed!\n", texture_source.source_path);
+				return false;
+			}
+			out_key = GetCookedTextureKey(source.view, texture_source.mip_content, texture_source.cooked_format);
+			return true;
+		}
+
+		// ÿOBJӦһ, BindSceneMesh ±ȡƹ, 񲻹 .femesh δ
+		bool HasSceneGeometries(const SMeshView& mesh_view)
+		{
+			return mesh_view.geometry_count >= c_mesh_file_names.size();
+		}
+
+		bool LoadSceneMesh(CCookedMesh& mesh, const std::string& cooked_path)
+		{
+			if (mesh.Load(cooked_path) && HasSceneGeometries(mesh.GetView()))
+			{
+				return true;
+			}
+			// ӳ, º決ʱܸļ
+			mesh.ReleaseCpuData();
+			return false;
+		}
+
+		void ApplySceneMeshSettings(CMesh& mesh, size_t index)
+		{
+			for (auto& vertex : mesh.m_vretices)
+			{
+				vertex.color[0] = c_mesh_colors[index].x;
+				vertex.color[1] = c_mesh_colors[index].y;
+				vertex.color[2] = c_mesh_colors[index].z;
+				vertex.color[3] = c_mesh_colors[index].w;
+			}
+			mesh.material = c_mesh_materials[index];
+		}
+
+		// ڹ߳ϵ, ʧܵOBJ, ʱһ
+		bool CookSceneMesh(const std::string& cooked_path, CFileSystem* file_system, CJobSystem* job_system)
+		{
+			std::array<CMesh, 6> meshes;
+			auto parse_mesh = [&](uint32_t i) {
+				SFileData source;
+				if (!file_system->ReadFile(c_mesh_file_names[i], source) || !ParseMeshVertexObject(source.view, meshes[i].m_vretices, meshes[i].m_indices))
+				{
+					printf("[error]:load %s failed!\n", c_mesh_file_names[i]);
+					meshes[i].m_vretices.clear();
+					meshes[i].m_indices.clear();
+				}
+				ApplySceneMeshSettings(meshes[i], i);
+			};
+			job_system->ParallelFor(static_cast<uint32_t>(meshes.size()), parse_mesh);
+			std::vector<CMesh*> mesh_ptrs;
+			for (CMesh& mesh : meshes)
+			{
+				mesh_ptrs.emplace_back(&mesh);
+			}
+			return WriteCookedMesh(cooked_path, mesh_ptrs);
+		}
+
+		bool CookSceneTexture(const std::string& cooked_path, size_t index, CFileSystem* file_system, CJobSystem* job_system)
+		{
+			const STextureSource& texture_source = c_texture_sources[index];
+			SFileData source;
+			CTexture  texture;
+			return file_system->ReadFile(texture_source.source_path, source)
+				&& texture.LoadTextureFromMemory(source.view, job_system)
+				&& CookTexture(cooked_path, texture, texture_source.mip_content, texture_source.cooked_format, job_system);
+		}
+
+		// õ .femesh ʱֱӳ, ûлʱº決, Դļ決ʧʱؿ
+		// ϣͺ決, ضڹ߳ϵ
+		std::unique_ptr<CCookedMesh> LoadOrCookSceneMesh(CFileSystem* file_system, CDerivedDataCache* derived_data_cache, CJobSystem* job_system, std::string& out_cooked_path)
+		{
+			SHash128 key;
+			if (!GetSceneMeshKey(file_system, key))
+			{
+				return nullptr;
+			}
+			const std::string cooked_path = derived_data_cache->GetPath(key, "femesh");
+			auto mesh = std::make_unique<CCookedMesh>();
+			if ((derived_data_cache->Exists(key, "femesh") && LoadSceneMesh(*mesh, cooked_path))
+				|| (CookSceneMesh(cooked_path, file_system, job_system) && LoadSceneMesh(*mesh, cooked_path)))
+			{
+				out_cooked_path = cooked_path;
+				return mesh;
+			}
+			printf("[error]:cook %s failed!\n", cooked_path.c_str());
+			return nullptr;
+		}
+
+		// ػõ .fetex ·, ûлļͷʱº決, ʧʱؿ
+		std::string GetOrCookSceneTexture(CFileSystem* file_system, CDerivedDataCache* derived_data_cache, CJobSystem* job_system, size_t index)
+		{
+			SHash128 key;
+			if (!GetSceneTextureKey(file_system, index, key))
+			{
+				return {};
+			}
+			const std::string cooked_path = derived_data_cache->GetPath(key, "fetex");
+			if (derived_data_cache->Exists(key, "fetex"))
+			{
+				// ֻУļͷ, º決ǰҪȽӳ
+				CCookedTexture cooked_texture;
+				if (cooked_texture.Load(cooked_path))
+				{
+					return cooked_path;
+				}
+			}
+			if (!CookSceneTexture(cooked_path, index, file_system, job_system))
+			{
+				printf("[error]:cook %s failed!\n", cooked_path.c_str());
+				return {};
+			}
+			return cooked_path;
+		}
+
+		void SetLightPosition(const SVertexInstance* vertices, uint32_t count)
+		{
+			float x = 0.f;
+			float y = 0.f;
+			float z = 0.f;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				x += vertices[i].position[0];
+				y += vertices[i].position[1];
+				z += vertices[i].position[2];
+			}
+			g_v4LightPosition.x = x / static_cast<float>(count);
+			g_v4LightPosition.y = y / static_cast<float>(count);
+			g_v4LightPosition.z = z / static_cast<float>(count);
+			g_v4LightPosition.w = 1.0f;
+		}
+
+		void ComputeBounds(const SVertexInstance* vertices, uint32_t count, XMFLOAT3& out_center, float& out_radius)
+		{
+			XMVECTOR min_position = XMVectorReplicate(FLT_MAX);
+			XMVECTOR max_position = XMVectorReplicate(-FLT_MAX);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const XMVECTOR position = XMVectorSet(vertices[i].position[0], vertices[i].position[1], vertices[i].position[2], 0.0f);
+				min_position = XMVectorMin(min_position, position);
+				max_position = XMVectorMax(max_position, position);
+			}
+			if (count > 0)
+			{
+				XMStoreFloat3(&out_center, (min_position + max_position) * 0.5f);
+				out_radius = XMVectorGetX(XMVector3Length(max_position - min_position)) * 0.5f;
+			}
+		}
+	}
+
 	CRenderingSystem::CRenderingSystem(CWindowSystem* window_system)
 	{
+		CAssetSystem* asset_system = g_global_singleton_context->m_asset_system.get();
+		CFileSystem*  file_system = g_global_singleton_context->m_file_system.get();
+		CDerivedDataCache* derived_data_cache = g_global_singleton_context->m_derived_data_cache.get();
+		CJobSystem*   job_system = g_global_singleton_context->m_job_system.get();
+
+		// Դļϣ, ݻδʱĺ決ڹ߳Ͻ, 豸͹߳ʼص
+		// ʱԴļֻӳϣ, ᱻ
+		std::unique_ptr<CCookedMesh> cooked_mesh;
+		std::string                  cooked_mesh_path;
+		std::array<std::string, 2>   cooked_texture_paths;
+		std::mutex                   prepare_mutex;
+		std::condition_variable      prepare_condition;
+		bool                         prepared = false;
+		job_system->Submit([&]() {
+			job_system->ParallelFor(static_cast<uint32_t>(1 + c_texture_sources.size()), [&](uint32_t i) {
+				if (i == 0)
+				{
+					cooked_mesh = LoadOrCookSceneMesh(file_system, derived_data_cache, job_system, cooked_mesh_path);
+				}
+				else
+				{
+					cooked_texture_paths[i - 1] = GetOrCookSceneTexture(file_system, derived_data_cache, job_system, i - 1);
+				}
+			});
+			std::lock_guard<std::mutex> lock(prepare_mutex);
+			prepared = true;
+			prepare_condition.notify_all();
+		});
+
 		// init rendering system
 		auto hwnd = window_system->GetWindowHwnd();
 		m_rhi = new D3D12RHI(hwnd);
@@ -37,14 +285,9 @@ namespace FireEngine {
 		m_rhi->CreateSwapChain(width_height.first, width_height.second);
 		m_rhi->CreateRayTracingRootSignature();
 
-		auto shader_path = g_global_singleton_context->m_file_system->GetFullPath("Resource/Shader/Raytracing.cso");
-		WCHAR* conv;
-		{
-			USES_CONVERSION;
-			conv = A2W(shader_path.data());
-		}
-		std::vector<uint8_t> shader_byte_code = ReadData(conv);
-		m_rhi->CreateRayTracingPipelineStateObject(shader_byte_code);
+		auto shader_path = g_global_singleton_context->m_file_system->GetFullPath(c_raytracing_shader_path);
+		CMappedFile shader_byte_code = MapData(shader_path);
+		m_rhi->CreateRayTracingPipelineStateObject(shader_byte_code.GetView());
 		m_rhi->CreateRenderEndFence();
 		m_rhi->InitializeSampler();
 		m_rhi->CreateRayTracingRenderTargetUAV();
@@ -52,76 +295,61 @@ namespace FireEngine {
 		m_rhi->CreateSceneConstantBuffer();
 		m_rhi->CreateMaterials();
 
-		std::vector<std::string> mesh_file_names;
-		{
-			mesh_file_names.reserve(6);
-			mesh_file_names.emplace_back("Resource/models/floor.obj");//white
-			mesh_file_names.emplace_back("Resource/models/shortbox.obj");//white
-			mesh_file_names.emplace_back("Resource/models/tallbox.obj");//white
-			mesh_file_names.emplace_back("Resource/models/left.obj");//red
-			mesh_file_names.emplace_back("Resource/models/right.obj");//green
-			mesh_file_names.emplace_back("Resource/models/light.obj");//light
-			std::array<DirectX::XMFLOAT4, 6> color;
-			color[0] = { 0.63f, 0.065f, 0.05f, 1.0f };
-			color[1] = { 0.63f, 0.45f, 0.05f, 1.0f };
-			color[2] = { 0.63f, 0.065f, 0.65f, 1.0f };
-			color[3] = { 0.14f, 0.45f, 0.091f, 1.0f };
-			color[4] = { 0.725f, 0.71f, 0.68f, 1.0f };
-			color[5] = { 0.65f, 0.65f, 0.65f, 1.0f };
+		{
+			std::unique_lock<std::mutex> lock(prepare_mutex);
+			prepare_condition.wait(lock, [&prepared]() { return prepared; });
+		}
+
+		{
 			int32_t color_idx = 0;
-			std::array<uint32_t, 6> material_instance;
-			material_instance[0] = 2;
-			material_instance[1] = 2;
-			material_instance[2] = 2;
-			material_instance[3] = 0;
-			material_instance[4] = 1;
-			material_instance[5] = 3;
 #define Combine 1
 #if Combine
-			std::vector<CMesh*> meshes;
-			for (auto& path : mesh_file_names)
+			if (cooked_mesh)
 			{
-				std::string mesh_path = g_global_singleton_context->m_file_system->GetFullPath(path);
-				std::vector<SVertexInstance> vretices;
-				std::vector<IndexType> indices;
-				LoadMeshVertexObject(mesh_path, vretices, indices);
-				std::unique_ptr<CMesh> mesh = std::make_unique<CMesh>();
-				for (auto& vertex : vretices)
+				const SMeshView mesh_view = cooked_mesh->GetView();
+				BindSceneMesh(asset_system->RetainAsset(std::move(cooked_mesh), EAssetType::CookedMesh), mesh_view);
+			}
+			else
+			{
+				// Դļ決ʧʱ, ԴϵͳеOBJֱϴ, ʧܵĵ
+				std::vector<SAssetHandle> mesh_handles;
+				for (const char* path : c_mesh_file_names)
 				{
-					vertex.color[0] = color[color_idx].x;
-					vertex.color[1] = color[color_idx].y;
-					vertex.color[2] = color[color_idx].z;
-					vertex.color[3] = color[color_idx].w;
+					mesh_handles.emplace_back(asset_system->LoadAsync(path, EAssetType::Mesh));
 				}
-				mesh->material = material_instance[color_idx];
-				color_idx++;
-				mesh->m_vretices = std::move(vretices);
-				mesh->m_indices = std::move(indices);
-				meshes.emplace_back(mesh.get());
-				uint64_t asset_id = g_global_singleton_context->m_asset_system->RetainAsset(std::move(mesh));
-			}
-			m_rhi->CreatePrimitives(meshes);
-			{
-				float x = 0.f;
-				float y = 0.f;
-				float z = 0.f;
-				int32_t count = 0;
-				for (auto && vertex_instance : meshes[5]->m_vretices)
+				std::vector<CMesh*> mesh_ptrs;
+				for (SAssetHandle& mesh_handle : mesh_handles)
 				{
-					x += vertex_instance.position[0];
-					y += vertex_instance.position[1];
-					z += vertex_instance.position[2];
-					count++;
+					CMesh* mesh = asset_system->Wait(mesh_handle) ? asset_system->GetAsset<CMesh>(mesh_handle) : nullptr;
+					if (!mesh)
+					{
+						auto empty_mesh = std::make_unique<CMesh>();
+						mesh = empty_mesh.get();
+						asset_system->Release(mesh_handle);
+						mesh_handle = asset_system->RetainAsset(std::move(empty_mesh), EAssetType::Mesh);
+					}
+					ApplySceneMeshSettings(*mesh, color_idx);
+					color_idx++;
+					mesh_ptrs.emplace_back(mesh);
+				}
+				m_scene_primitives = m_rhi->CreatePrimitives(mesh_ptrs);
+				SetLightPosition(mesh_ptrs[5]->m_vretices.data(), static_cast<uint32_t>(mesh_ptrs[5]->m_vretices.size()));
+				std::vector<SVertexInstance> scene_vertices;
+				for (CMesh* mesh : mesh_ptrs)
+				{
+					scene_vertices.insert(scene_vertices.end(), mesh->m_vretices.begin(), mesh->m_vretices.end());
+				}
+				ComputeBounds(scene_vertices.data(), static_cast<uint32_t>(scene_vertices.size()), m_scene_center, m_scene_radius);
+				// ѾGPU, ͷCPU
+				for (SAssetHandle mesh_handle : mesh_handles)
+				{
+					asset_system->Release(mesh_handle);
 				}
-				g_v4LightPosition.x = x / static_cast<float>(count);
-				g_v4LightPosition.y = y / static_cast<float>(count);
-				g_v4LightPosition.z = z / static_cast<float>(count);
-				g_v4LightPosition.w = 1.0f;
 			}
 #else
 			std::unique_ptr<CMesh>          mesh = std::make_unique<CMesh>();
 			
-			for (auto& path : mesh_file_names)
+			for (const char* path : c_mesh_file_names)
 			{
 				std::string mesh_path = g_global_singleton_context->m_file_system->GetFullPath(path);
 				std::vector<SVertexInstance> vretices;
@@ -132,10 +360,10 @@ namespace FireEngine {
 				mesh->m_vretices.reserve(mesh->m_vretices.size() + vretices.size());
 				for (auto& vertex : vretices)
 				{
-					vertex.color[0] = color[color_idx].x;
-					vertex.color[1] = color[color_idx].y;
-					vertex.color[2] = color[color_idx].z;
-					vertex.color[3] = color[color_idx].w;
+					vertex.color[0] = c_mesh_colors[color_idx].x;
+					vertex.color[1] = c_mesh_colors[color_idx].y;
+					vertex.color[2] = c_mesh_colors[color_idx].z;
+					vertex.color[3] = c_mesh_colors[color_idx].w;
 					mesh->m_vretices.emplace_back(vertex);
 				}
 				color_idx++;
@@ -151,34 +379,220 @@ namespace FireEngine {
 			{
 				printf("normal[%f, %f, %f]\n", vert.normal[0], vert.normal[1], vert.normal[2]);
 			}
-			uint64_t asset_id = g_global_singleton_context->m_asset_system->RetainAsset(std::move(mesh));
+			SAssetHandle mesh_handle = g_global_singleton_context->m_asset_system->RetainAsset(std::move(mesh), EAssetType::Mesh);
 #endif
 		}
 
+		// Դļ決ʧʱϴͼ, жͼԴʱһͷ, һֱ, ̶Դ
+		auto bind_rhi_texture = [asset_system, rhi = m_rhi](SAssetHandle handle, FTextureHandle rhi_texture) {
+			asset_system->AddUnloadCallback(handle, [rhi, rhi_texture](SAssetHandle, CAssetBase*) {
+				rhi->ReleaseTexture(rhi_texture);
+			});
+			asset_system->TrackGpuMemory(handle, EResidencyCategory::GpuTexture, rhi->GetTextureMemorySize(rhi_texture));
+			asset_system->PinAsset(handle, EResidencyCategory::GpuTexture);
+		};
+
+		// ˳ϴ, ͼλɫԼһ
+		// .fetex ʱֻϴ mip tail, ϸĲ㼶 TickRendering ﰴĻߴ
+		m_texture_streamer = std::make_unique<CTextureStreamer>(m_rhi, &asset_system->GetResidency(), job_system);
+		m_streaming_textures.resize(c_texture_sources.size());
+		for (size_t i = 0; i < c_texture_sources.size(); ++i)
 		{
-			std::string texture_path = g_global_singleton_context->m_file_system->GetFullPath("Resource/texture/Earth4kTexture_4K.png");
-			auto texture = std::make_unique<CTexture>();
-			texture->LoadTextureFromFile(texture_path);
-			m_rhi->CreateTexture(texture->m_data, texture->m_width, texture->m_height);
-			uint64_t asset_id0 = g_global_singleton_context->m_asset_system->RetainAsset(std::move(texture));
-		}
-		{
-			std::string texture_path = g_global_singleton_context->m_file_system->GetFullPath("Resource/texture/Earth4kNormal_4K.png");
-			auto texture = std::make_unique<CTexture>();
-			texture->LoadTextureFromFile(texture_path);
-			m_rhi->CreateTexture(texture->m_data, texture->m_width, texture->m_height);
-			uint64_t asset_id0 = g_global_singleton_context->m_asset_system->RetainAsset(std::move(texture));
+			const std::string& cooked_path = cooked_texture_paths[i];
+			const FStreamingTextureHandle streaming_texture = cooked_path.empty() ? FStreamingTextureHandle{} : m_texture_streamer->AddTexture(cooked_path);
+			if (streaming_texture.IsValid())
+			{
+				m_streaming_textures[i] = streaming_texture;
+				continue;
+			}
+			const SAssetHandle source_handle = asset_system->LoadAsync(c_texture_sources[i].source_path, c_texture_sources[i].source_type);
+			CTexture* texture = asset_system->Wait(source_handle) ? asset_system->GetAsset<CTexture>(source_handle) : nullptr;
+			if (!texture)
+			{
+				printf("[error]:texture %s load failed!\n", c_texture_sources[i].source_path);
+				continue;
+			}
+			bind_rhi_texture(source_handle, m_rhi->CreateTexture(*texture));
 		}
 		m_rhi->CreateBottomLevelAccelerationStructure();
 		m_rhi->CreateTopLevelInstanceResource();
 		m_rhi->CreateTopLevelAccelerationStructure();
 
 		m_rhi->BuildDescHeap();
+
+		// ֻɢļ,  pak Դ仯
+		// Դļ -> ĺ決, Ķֻº決Щ
+		m_file_watcher = std::make_unique<CFileWatcher>(file_system->GetFullPath("Resource/"));
+		for (const char* path : c_mesh_file_names)
+		{
+			m_reload_dependencies[HashPath(path)].push_back({ EReloadTarget::SceneMesh, 0 });
+		}
+		for (uint32_t i = 0; i < c_texture_sources.size(); ++i)
+		{
+			m_reload_dependencies[HashPath(c_texture_sources[i].source_path)].push_back({ EReloadTarget::Texture, i });
+		}
+		m_reload_dependencies[HashPath(c_raytracing_shader_path)].push_back({ EReloadTarget::Shader, 0 });
+	}
+
+	CRenderingSystem::~CRenderingSystem()
+	{
+		// º決 this
+		std::unique_lock<std::mutex> lock(m_reload_mutex);
+		m_reload_condition.wait(lock, [this]() { return m_reloads_in_flight == 0; });
+	}
+
+	void CRenderingSystem::BindSceneMesh(SAssetHandle mesh_asset, const SMeshView& mesh_view)
+	{
+		CAssetSystem* asset_system = g_global_singleton_context->m_asset_system.get();
+		const FPrimitiveHandle primitive_handle = m_rhi->CreatePrimitives(mesh_view);
+		// жʱһͷĶ/, һֱ, ̶Դ, ӳ .femesh Ա̭
+		asset_system->AddUnloadCallback(mesh_asset, [rhi = m_rhi, primitive_handle](SAssetHandle, CAssetBase*) {
+			rhi->ReleasePrimitives(primitive_handle);
+		});
+		asset_system->TrackGpuMemory(mesh_asset, EResidencyCategory::GpuBuffer, m_rhi->GetPrimitivesMemorySize(primitive_handle));
+		asset_system->PinAsset(mesh_asset, EResidencyCategory::GpuBuffer);
+		m_scene_mesh_asset = mesh_asset;
+		m_scene_primitives = primitive_handle;
+
+		const SGeometryDesc& light_geometry = mesh_view.geometries[5];
+		SetLightPosition(mesh_view.vertices + light_geometry.vertex_offset, light_geometry.vertex_count);
+		ComputeBounds(mesh_view.vertices, static_cast<uint32_t>(mesh_view.vertex_count), m_scene_center, m_scene_radius);
+	}
+
+	void CRenderingSystem::UpdateHotReload()
+	{
+		std::vector<std::string> changed_paths;
+		m_file_watcher->PollChanges(changed_paths);
+		for (const std::string& path : changed_paths)
+		{
+			auto dependency = m_reload_dependencies.find(HashPath("Resource/" + path));
+			if (dependency == m_reload_dependencies.end())
+			{
+				continue;
+			}
+			printf("[reload]:Resource/%s changed\n", path.c_str());
+			for (const SReloadTarget& target : dependency->second)
+			{
+				if (std::find(m_dirty_targets.begin(), m_dirty_targets.end(), target) == m_dirty_targets.end())
+				{
+					m_dirty_targets.push_back(target);
+				}
+			}
+		}
+
+		std::vector<SReloadResult> results;
+		{
+			std::lock_guard<std::mutex> lock(m_reload_mutex);
+			results.swap(m_reload_results);
+		}
+		for (SReloadResult& result : results)
+		{
+			m_reloading_targets.erase(std::find(m_reloading_targets.begin(), m_reloading_targets.end(), result.target));
+			ApplyReload(result);
+		}
+
+		// ں決Ŀɺٷ, ֤һ޸ĻЧ
+		for (auto it = m_dirty_targets.begin(); it != m_dirty_targets.end();)
+		{
+			if (std::find(m_reloading_targets.begin(), m_reloading_targets.end(), *it) != m_reloading_targets.end())
+			{
+				++it;
+				continue;
+			}
+			StartReload(*it);
+			it = m_dirty_targets.erase(it);
+		}
+	}
+
+	void CRenderingSystem::StartReload(const SReloadTarget& target)
+	{
+		m_reloading_targets.push_back(target);
+		{
+			std::lock_guard<std::mutex> lock(m_reload_mutex);
+			++m_reloads_in_flight;
+		}
+		// ڹ߳ͺ決, нʱֱʹ, ɺһ֡ʼʱ滻
+		g_global_singleton_context->m_job_system->Submit([this, target]() {
+			CFileSystem*       file_system = g_global_singleton_context->m_file_system.get();
+			CDerivedDataCache* derived_data_cache = g_global_singleton_context->m_derived_data_cache.get();
+			CJobSystem*        job_system = g_global_singleton_context->m_job_system.get();
+			SReloadResult result;
+			result.target = target;
+			switch (target.type)
+			{
+			case EReloadTarget::SceneMesh:
+			{
+				result.mesh = LoadOrCookSceneMesh(file_system, derived_data_cache, job_system, result.cooked_path);
+				break;
+			}
+			case EReloadTarget::Texture:
+			{
+				result.cooked_path = GetOrCookSceneTexture(file_system, derived_data_cache, job_system, target.index);
+				break;
+			}
+			case EReloadTarget::Shader:
+				// ɫѾǱõ .cso, ߳ӳ
+				result.cooked_path = file_system->GetFullPath(c_raytracing_shader_path);
+				break;
+			}
+
+			std::lock_guard<std::mutex> lock(m_reload_mutex);
+			m_reload_results.push_back(std::move(result));
+			--m_reloads_in_flight;
+			m_reload_condition.notify_all();
+		});
+	}
+
+	void CRenderingSystem::ApplyReload(SReloadResult& result)
+	{
+		if (result.cooked_path.empty())
+		{
+			printf("[error]:reload failed, keep using the old version\n");
+			return;
+		}
+		switch (result.target.type)
+		{
+		case EReloadTarget::SceneMesh:
+		{
+			// ͼԪúжؾ, ֻؽε BLAS/TLAS 
+			CAssetSystem*    asset_system = g_global_singleton_context->m_asset_system.get();
+			const SAssetHandle old_mesh_asset = m_scene_mesh_asset;
+			const FPrimitiveHandle old_primitives = m_scene_primitives;
+			const SMeshView  mesh_view = result.mesh->GetView();
+			BindSceneMesh(asset_system->RetainAsset(std::move(result.mesh), EAssetType::CookedMesh), mesh_view);
+			// ͼԪԴͷ, ûк決ʱκԴ, ͷ
+			asset_system->Release(old_mesh_asset);
+			m_rhi->ReleasePrimitives(old_primitives);
+			m_rhi->RebuildAccelerationStructures();
+			break;
+		}
+		case EReloadTarget::Texture:
+		{
+			const FStreamingTextureHandle streaming_texture = m_texture_streamer->AddTexture(result.cooked_path);
+			if (!streaming_texture.IsValid())
+			{
+				return;
+			}
+			m_texture_streamer->RemoveTexture(m_streaming_textures[result.target.index]);
+			m_streaming_textures[result.target.index] = streaming_texture;
+			break;
+		}
+		case EReloadTarget::Shader:
+		{
+			CMappedFile shader_byte_code = MapData(result.cooked_path);
+			if (!m_rhi->ReloadRayTracingPipeline(shader_byte_code.GetView()))
+			{
+				return;
+			}
+			break;
+		}
+		}
+		printf("[reload]:%s reloaded\n", result.cooked_path.c_str());
 	}
 
 	void CRenderingSystem::TickRendering(float dt)
 	{
-		
+		UpdateHotReload();
 
 		XMVECTOR z_axis = XMVectorZero();
 		z_axis = XMVectorSetZ(z_axis, 1.0f);
@@ -237,6 +651,15 @@ namespace FireEngine {
 		float image_aspect_ratio = window_size.first / (float)window_size.second;
 		m_scene_constant_buffer.m_scale.x = scale * image_aspect_ratio;
 		m_scene_constant_buffer.m_scale.y = scale;
+
+		// ĻϵĳߴΪͼߴ, Զʱϸ㼶Դʱȱ
+		const float scene_distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&m_scene_center) - g_vEye));
+		const float screen_size = CTextureStreamer::ComputeScreenSize(m_scene_radius * 2.0f, scene_distance, DirectX::XMConvertToRadians(fov), static_cast<float>(window_size.second));
+		for (FStreamingTextureHandle streaming_texture : m_streaming_textures)
+		{
+			m_texture_streamer->RequestScreenSize(streaming_texture, screen_size);
+		}
+		m_texture_streamer->Tick();
 		m_rhi->UpdateSceneConstantBuffer(&m_scene_constant_buffer, sizeof(m_scene_constant_buffer));
 		m_rhi->DoRayTracing();
 		m_rhi->WaitForFence();
@@ -0,0 +1,422 @@
+﻿#include "Render/texture_streamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "Core/job_system.h"
+#include "RHI/D3D12RHI.h"
+
+namespace FireEngine
+{
+	namespace
+	{
+		uint32_t GetMipExtent(const STextureSubresource& subresource)
+		{
+			return subresource.width > subresource.height ? subresource.width : subresource.height;
+		}
+
+		// D3D12 要求块压缩贴图最高层的宽高是4的倍数, 非2的幂贴图的某些层级不能作为最高层
+		bool IsValidTopMip(const STextureView& view, uint32_t mip)
+		{
+			const STextureSubresource& subresource = view.subresources[mip];
+			return mip == 0 || !IsBlockCompressed(view.format) || (subresource.width % 4 == 0 && subresource.height % 4 == 0);
+		}
+
+		uint32_t FindFinerTopMip(const STextureView& view, uint32_t mip)
+		{
+			do
+			{
+				--mip;
+			} while (mip > 0 && !IsValidTopMip(view, mip));
+			return mip;
+		}
+
+		uint32_t FindCoarserTopMip(const STextureView& view, uint32_t mip, uint32_t tail_mip)
+		{
+			do
+			{
+				++mip;
+			} while (mip < tail_mip && !IsValidTopMip(view, mip));
+			return mip;
+		}
+
+		// [first_mip, last_mip) 组成的贴图视图, 偏移仍然相对于 view.data
+		STextureView GetMipRange(const STextureView& view, uint32_t first_mip, uint32_t last_mip)
+		{
+			STextureView range = view;
+			range.width = view.subresources[first_mip].width;
+			range.height = view.subresources[first_mip].height;
+			range.subresources = view.subresources + first_mip;
+			range.subresource_count = last_mip - first_mip;
+			return range;
+		}
+	}
+
+	bool CTextureStreamer::SPriority::operator<(const SPriority& other) const
+	{
+		if (requested != other.requested)
+		{
+			return !requested;
+		}
+		if (deficit != other.deficit)
+		{
+			return deficit < other.deficit;
+		}
+		return screen_size < other.screen_size;
+	}
+
+	CTextureStreamer::CTextureStreamer(D3D12RHI* rhi, CResidencyManager* residency, CJobSystem* job_system)
+		: m_rhi(rhi)
+		, m_residency(residency)
+		, m_job_system(job_system)
+	{
+	}
+
+	CTextureStreamer::~CTextureStreamer()
+	{
+		// 读取任务直接引用映射, 要等它们结束才能解除映射
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_read_condition.wait(lock, [this]() { return m_reads_in_flight == 0; });
+		}
+		for (SStreamingTexture& texture : m_textures)
+		{
+			m_rhi->ReleaseTexture(texture.rhi_texture);
+			m_residency->Untrack(texture.residency);
+		}
+	}
+
+	FStreamingTextureHandle CTextureStreamer::AddTexture(const std::string& file_name)
+	{
+		SStreamingTexture texture;
+		texture.file = std::make_unique<CCookedTexture>();
+		if (!texture.file->Load(file_name))
+		{
+			printf("[error]:streaming texture %s load failed!\n", file_name.c_str());
+			return {};
+		}
+		const STextureView view = texture.file->GetView();
+
+		// 最长边不超过 c_texture_stream_tail_size 的第一层, 不能作为最高层时往精细的方向找
+		uint32_t tail_mip = 0;
+		while (tail_mip + 1 < view.subresource_count && GetMipExtent(view.subresources[tail_mip]) > c_texture_stream_tail_size)
+		{
+			++tail_mip;
+		}
+		while (tail_mip > 0 && !IsValidTopMip(view, tail_mip))
+		{
+			--tail_mip;
+		}
+
+		texture.rhi_texture = m_rhi->CreateTexture(GetMipRange(view, tail_mip, view.subresource_count));
+		if (!texture.rhi_texture.IsValid())
+		{
+			printf("[error]:streaming texture %s upload failed!\n", file_name.c_str());
+			return {};
+		}
+		texture.tail_mip = tail_mip;
+		texture.resident_mip = tail_mip;
+		texture.requested_mip = tail_mip;
+		// 由自己按预算丢弃层级, 驻留管理器只用来统计, 固定住不让它整张淘汰
+		texture.residency = m_residency->Track(EResidencyCategory::GpuTexture, 0, nullptr);
+		m_residency->Pin(texture.residency);
+		UpdateResidentSize(texture);
+		return m_textures.Insert(std::move(texture));
+	}
+
+	void CTextureStreamer::RemoveTexture(FStreamingTextureHandle handle)
+	{
+		SStreamingTexture* texture = m_textures.Get(handle);
+		if (!texture || texture->removed)
+		{
+			return;
+		}
+		if (texture->reading)
+		{
+			texture->removed = true;
+			return;
+		}
+		DestroyTexture(handle);
+	}
+
+	SSlotHandle CTextureStreamer::GetRhiTexture(FStreamingTextureHandle handle) const
+	{
+		const SStreamingTexture* texture = m_textures.Get(handle);
+		return texture ? texture->rhi_texture : SSlotHandle{};
+	}
+
+	uint32_t CTextureStreamer::GetResidentMip(FStreamingTextureHandle handle) const
+	{
+		const SStreamingTexture* texture = m_textures.Get(handle);
+		return texture ? texture->resident_mip : 0;
+	}
+
+	uint32_t CTextureStreamer::GetRequestedMip(FStreamingTextureHandle handle) const
+	{
+		const SStreamingTexture* texture = m_textures.Get(handle);
+		return texture ? texture->requested_mip : 0;
+	}
+
+	void CTextureStreamer::RequestScreenSize(FStreamingTextureHandle handle, float screen_size)
+	{
+		SStreamingTexture* texture = m_textures.Get(handle);
+		if (!texture || texture->removed)
+		{
+			return;
+		}
+		if (texture->last_request_frame == m_frame && screen_size <= texture->screen_size)
+		{
+			return;
+		}
+		texture->screen_size = screen_size;
+		texture->last_request_frame = m_frame;
+
+		// 最长边仍然不小于屏幕尺寸的最粗层级, 再细就超过屏幕像素数了
+		const STextureView view = texture->file->GetView();
+		uint32_t mip = 0;
+		while (mip < texture->tail_mip && static_cast<float>(GetMipExtent(view.subresources[mip + 1])) >= screen_size)
+		{
+			++mip;
+		}
+		while (mip > 0 && !IsValidTopMip(view, mip))
+		{
+			--mip;
+		}
+		texture->requested_mip = mip;
+	}
+
+	float CTextureStreamer::ComputeScreenSize(float world_size, float distance, float fov_y, float viewport_height)
+	{
+		const float view_height = 2.0f * distance * std::tan(fov_y * 0.5f);
+		return view_height > 0.0f ? world_size / view_height * viewport_height : viewport_height;
+	}
+
+	void CTextureStreamer::SetFrameBudgets(uint64_t io_budget, uint64_t upload_budget)
+	{
+		m_io_budget = io_budget;
+		m_upload_budget = upload_budget;
+	}
+
+	void CTextureStreamer::Tick()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (SReadResult& read : m_completed_reads)
+			{
+				m_pending_uploads.emplace_back(std::move(read));
+			}
+			m_completed_reads.clear();
+		}
+		UploadCompletedReads();
+		// 其它贴图占用变多或预算调低时, 不管优先级先回到预算以内
+		MakeRoom(0, nullptr);
+		IssueReads();
+		++m_frame;
+	}
+
+	CTextureStreamer::SPriority CTextureStreamer::GetLevelPriority(const SStreamingTexture& texture, uint32_t mip) const
+	{
+		SPriority priority;
+		priority.requested = texture.last_request_frame == m_frame && texture.screen_size > 0.0f;
+		priority.deficit = static_cast<int32_t>(mip) - static_cast<int32_t>(texture.requested_mip);
+		priority.screen_size = texture.screen_size;
+		return priority;
+	}
+
+	bool CTextureStreamer::HasRoom(uint64_t size) const
+	{
+		const SResidencyStats& stats = m_residency->GetStats(EResidencyCategory::GpuTexture);
+		const uint64_t         pool_used = m_resident_size + m_reserved_size;
+		const uint64_t         residency_used = stats.current + m_reserved_size;
+		return pool_used <= m_pool_budget && size <= m_pool_budget - pool_used
+			&& residency_used <= stats.budget && size <= stats.budget - residency_used;
+	}
+
+	bool CTextureStreamer::MakeRoom(uint64_t size, const SStreamingTexture* for_texture)
+	{
+		SPriority for_priority{};
+		if (for_texture)
+		{
+			for_priority = GetLevelPriority(*for_texture, FindFinerTopMip(for_texture->file->GetView(), for_texture->resident_mip));
+		}
+		while (!HasRoom(size))
+		{
+			// 正在读取的贴图不能丢层级, 读完的数据要接在当前最高层前面
+			SStreamingTexture* victim = nullptr;
+			SPriority          victim_priority{};
+			for (SStreamingTexture& texture : m_textures)
+			{
+				if (&texture == for_texture || texture.reading || texture.removed || texture.failed || texture.resident_mip >= texture.tail_mip)
+				{
+					continue;
+				}
+				const SPriority priority = GetLevelPriority(texture, texture.resident_mip);
+				if ((for_texture && !(priority < for_priority)) || (victim && !(priority < victim_priority)))
+				{
+					continue;
+				}
+				victim = &texture;
+				victim_priority = priority;
+			}
+			if (!victim)
+			{
+				return false;
+			}
+			const uint32_t mip = FindCoarserTopMip(victim->file->GetView(), victim->resident_mip, victim->tail_mip);
+			if (!m_rhi->TrimTextureMips(victim->rhi_texture, mip - victim->resident_mip))
+			{
+				victim->failed = true;
+				return false;
+			}
+			victim->resident_mip = mip;
+			UpdateResidentSize(*victim);
+		}
+		return true;
+	}
+
+	void CTextureStreamer::UploadCompletedReads()
+	{
+		uint64_t uploaded = 0;
+		size_t   upload_count = 0;
+		for (; upload_count < m_pending_uploads.size(); ++upload_count)
+		{
+			SReadResult&       read = m_pending_uploads[upload_count];
+			SStreamingTexture* texture = m_textures.Get(read.handle);
+			if (texture->removed)
+			{
+				DestroyTexture(read.handle);
+				continue;
+			}
+			if (uploaded > 0 && uploaded + read.data.size() > m_upload_budget)
+			{
+				break;
+			}
+			uploaded += read.data.size();
+			texture->reading = false;
+			ReleaseReservedSize(*texture);
+
+			// 偏移改成相对于读到的数据
+			const STextureView view = texture->file->GetView();
+			const uint64_t     base_offset = view.subresources[read.first_mip].offset;
+			std::vector<STextureSubresource> subresources(view.subresources + read.first_mip, view.subresources + read.last_mip);
+			for (STextureSubresource& subresource : subresources)
+			{
+				subresource.offset -= base_offset;
+			}
+			STextureView mips = view;
+			mips.width = subresources[0].width;
+			mips.height = subresources[0].height;
+			mips.data = read.data.data();
+			mips.subresources = subresources.data();
+			mips.subresource_count = static_cast<uint32_t>(subresources.size());
+			if (!m_rhi->ExtendTextureMips(texture->rhi_texture, mips))
+			{
+				texture->failed = true;
+				continue;
+			}
+			texture->resident_mip = read.first_mip;
+			UpdateResidentSize(*texture);
+		}
+		m_pending_uploads.erase(m_pending_uploads.begin(), m_pending_uploads.begin() + upload_count);
+	}
+
+	void CTextureStreamer::IssueReads()
+	{
+		std::vector<std::pair<SPriority, FStreamingTextureHandle>> candidates;
+		for (uint32_t i = 0; i < m_textures.Size(); ++i)
+		{
+			const SStreamingTexture& texture = m_textures[i];
+			if (texture.reading || texture.removed || texture.failed || texture.requested_mip >= texture.resident_mip)
+			{
+				continue;
+			}
+			const uint32_t mip = FindFinerTopMip(texture.file->GetView(), texture.resident_mip);
+			candidates.emplace_back(GetLevelPriority(texture, mip), m_textures.GetHandle(i));
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return b.first < a.first; });
+
+		uint64_t issued = 0;
+		for (const auto& candidate : candidates)
+		{
+			SStreamingTexture& texture = *m_textures.Get(candidate.second);
+			const STextureView view = texture.file->GetView();
+			const uint32_t     mip = FindFinerTopMip(view, texture.resident_mip);
+			// 文件里的上传布局与显存占用接近, 用它估计新层级的大小
+			const uint64_t size = view.subresources[texture.resident_mip].offset - view.subresources[mip].offset;
+			if (issued > 0 && issued + size > m_io_budget)
+			{
+				break;
+			}
+			if (!MakeRoom(size, &texture))
+			{
+				break;
+			}
+			IssueRead(candidate.second, texture, mip);
+			issued += size;
+		}
+	}
+
+	void CTextureStreamer::IssueRead(FStreamingTextureHandle handle, SStreamingTexture& texture, uint32_t first_mip)
+	{
+		const STextureView view = texture.file->GetView();
+		const uint8_t*     src = view.data + view.subresources[first_mip].offset;
+		const uint64_t     size = view.subresources[texture.resident_mip].offset - view.subresources[first_mip].offset;
+		const uint32_t     last_mip = texture.resident_mip;
+		texture.reading = true;
+		texture.reserved_size = size;
+		m_reserved_size += size;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++m_reads_in_flight;
+		}
+		// 贴图在读取期间不会被销毁, 映射一直有效
+		auto read = [this, handle, first_mip, last_mip, src, size]() {
+			SReadResult result;
+			result.handle = handle;
+			result.first_mip = first_mip;
+			result.last_mip = last_mip;
+			result.data.resize(static_cast<size_t>(size));
+			memcpy(result.data.data(), src, static_cast<size_t>(size));
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_completed_reads.emplace_back(std::move(result));
+			--m_reads_in_flight;
+			m_read_condition.notify_all();
+		};
+		if (m_job_system)
+		{
+			m_job_system->Submit(std::move(read));
+		}
+		else
+		{
+			read();
+		}
+	}
+
+	void CTextureStreamer::UpdateResidentSize(SStreamingTexture& texture)
+	{
+		const uint64_t gpu_size = m_rhi->GetTextureMemorySize(texture.rhi_texture);
+		m_resident_size = m_resident_size - texture.gpu_size + gpu_size;
+		texture.gpu_size = gpu_size;
+		m_residency->Resize(texture.residency, gpu_size);
+	}
+
+	void CTextureStreamer::ReleaseReservedSize(SStreamingTexture& texture)
+	{
+		m_reserved_size -= texture.reserved_size;
+		texture.reserved_size = 0;
+	}
+
+	void CTextureStreamer::DestroyTexture(FStreamingTextureHandle handle)
+	{
+		SStreamingTexture* texture = m_textures.Get(handle);
+		m_rhi->ReleaseTexture(texture->rhi_texture);
+		m_residency->Untrack(texture->residency);
+		m_resident_size -= texture->gpu_size;
+		ReleaseReservedSize(*texture);
+		m_textures.Erase(handle);
+	}
+}
@@ -0,0 +1,75 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+
+#include "Core/Asset.h"
+#include "Core/define.h"
+#include "Core/mapped_file.h"
+
+namespace FireEngine
+{
+	class CMesh;
+
+	constexpr uint32_t c_cooked_mesh_magic = 0x48534D46; // "FMSH"
+	constexpr uint32_t c_cooked_mesh_version = 1;
+	// 改动导入/烘焙的处理但文件格式不变时加一, 让派生数据缓存里的旧结果失效
+	constexpr uint32_t c_mesh_cooker_version = 1;
+	constexpr uint64_t c_cooked_mesh_alignment = 16;
+
+	struct SMeshBounds
+	{
+		float min[3];
+		float max[3];
+	};
+
+	// .femesh 文件头, 所有偏移都相对于文件开头并按 c_cooked_mesh_alignment 对齐
+	struct alignas(16) SCookedMeshHeader
+	{
+		uint32_t    magic;
+		uint32_t    version;
+		uint32_t    vertex_stride;
+		uint32_t    index_stride;
+		uint64_t    vertex_offset;
+		uint64_t    vertex_count;
+		uint64_t    index_offset;
+		uint64_t    index_count;
+		// SGeometryDesc 表, 材质下标在 SGeometryDesc::material_index 里
+		uint64_t    geometry_offset;
+		uint64_t    geometry_count;
+		// 每个子网格一个 SMeshBounds
+		uint64_t    geometry_bounds_offset;
+		SMeshBounds bounds;
+	};
+
+	// 把网格写成 .femesh, 只在导入/烘焙时调用
+	bool WriteCookedMesh(const std::string& file_name, const SMeshView& mesh);
+	// 每个 CMesh 作为一个子网格, 材质取 CMesh::material
+	bool WriteCookedMesh(const std::string& file_name, const std::vector<CMesh*>& meshes);
+
+	// 运行时只读映射 .femesh, 校验文件头后直接返回指向映射内存的视图
+	class CCookedMesh : public CAssetBase
+	{
+	public:
+		CCookedMesh() = default;
+
+		uint64_t GetMemorySize() const override { return m_file.view.size; }
+		// 上传之后不再需要映射, 之后 GetView 返回空视图
+		void ReleaseCpuData() override
+		{
+			m_file = {};
+			m_header = nullptr;
+		}
+
+		bool Load(const std::string& file_name);
+		// 接管文件系统读到的数据, 可以是 pak 映射上的视图
+		bool Load(SFileData&& file);
+
+		const SCookedMeshHeader& GetHeader() const { return *m_header; }
+		SMeshView GetView() const;
+		const SMeshBounds* GetGeometryBounds() const;
+
+	private:
+		SFileData                m_file;
+		const SCookedMeshHeader* m_header{ nullptr };
+	};
+}
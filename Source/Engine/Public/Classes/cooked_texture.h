@@ -0,0 +1,72 @@
+﻿#pragma once
+#include <string>
+
+#include "Classes/texture.h"
+#include "Core/Asset.h"
+#include "Core/content_hash.h"
+#include "Core/mapped_file.h"
+#include "Core/mip_generator.h"
+#include "Core/texture_compressor.h"
+
+namespace FireEngine
+{
+	class CJobSystem;
+
+	constexpr uint32_t c_cooked_texture_magic = 0x58455446; // "FTEX"
+	constexpr uint32_t c_cooked_texture_version = 1;
+	// 改动 CookTexture 的滤波/压缩参数但文件格式不变时加一, 让派生数据缓存里的旧结果失效
+	constexpr uint32_t c_texture_cooker_version = 1;
+	// 与 D3D12_TEXTURE_DATA_PITCH_ALIGNMENT / D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT 一致, 烘焙时不依赖 D3D12 头文件
+	constexpr uint64_t c_cooked_texture_row_pitch_alignment = 256;
+	constexpr uint64_t c_cooked_texture_placement_alignment = 512;
+	constexpr uint32_t c_cooked_texture_max_mips = 16;
+
+	// .fetex 文件头, 后面跟 mip_count 个 STextureSubresource, 偏移都相对于文件开头
+	// 每个子资源的起点按 c_cooked_texture_placement_alignment 对齐, 行距按 c_cooked_texture_row_pitch_alignment 对齐
+	struct alignas(16) SCookedTextureHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t format;  // ETextureFormat
+		uint32_t width;
+		uint32_t height;
+		uint32_t mip_count;
+		uint32_t subresource_stride;
+		uint32_t reserved;
+		uint64_t subresource_offset;
+		uint64_t data_size;
+	};
+
+	// 把贴图按上传布局写成 .fetex, 只在导入/烘焙时调用
+	bool WriteCookedTexture(const std::string& file_name, const CTexture& texture);
+	// 丢弃已有的 mip, 用 Kaiser 滤波重新生成完整 mip 链, 宽高是4的倍数时压缩成 format, 然后写出 .fetex
+	bool CookTexture(const std::string& file_name, CTexture& texture, EMipContent content, ETextureFormat format, CJobSystem* job_system = nullptr);
+	// CookTexture 结果在派生数据缓存中的键, source 是导入前的源文件内容
+	SHash128 GetCookedTextureKey(const SByteView& source, EMipContent content, ETextureFormat format);
+
+	// 运行时只读映射 .fetex, 校验文件头后直接返回指向映射内存的视图
+	class CCookedTexture : public CAssetBase
+	{
+	public:
+		CCookedTexture() = default;
+
+		uint64_t GetMemorySize() const override { return m_file.view.size; }
+		// 上传之后不再需要映射, 之后 GetView 返回空视图
+		void ReleaseCpuData() override
+		{
+			m_file = {};
+			m_header = nullptr;
+		}
+
+		bool Load(const std::string& file_name);
+		// 接管文件系统读到的数据, 可以是 pak 映射上的视图
+		bool Load(SFileData&& file);
+
+		const SCookedTextureHeader& GetHeader() const { return *m_header; }
+		STextureView GetView() const;
+
+	private:
+		SFileData                   m_file;
+		const SCookedTextureHeader* m_header{ nullptr };
+	};
+}
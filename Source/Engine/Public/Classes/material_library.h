@@ -0,0 +1,35 @@
+﻿#pragma once
+#include <string_view>
+#include <vector>
+
+#include "Core/Asset.h"
+#include "Core/mtl_reader.h"
+
+namespace FireEngine
+{
+	// .mtl 材质库, 引用的贴图作为依赖由资源系统加载, 不保存在这里
+	class CMaterialLibrary : public CAssetBase
+	{
+	public:
+		CMaterialLibrary() = default;
+
+		uint64_t GetMemorySize() const override
+		{
+			return m_materials.capacity() * sizeof(SMtlMaterial);
+		}
+
+		const SMtlMaterial* Find(std::string_view name) const
+		{
+			for (const SMtlMaterial& material : m_materials)
+			{
+				if (material.name == name)
+				{
+					return &material;
+				}
+			}
+			return nullptr;
+		}
+
+		std::vector<SMtlMaterial> m_materials;
+	};
+}
@@ -10,6 +10,17 @@ namespace FireEngine {
 	{
 	public:
 		CMesh() = default;
+
+		uint64_t GetMemorySize() const override
+		{
+			return m_vretices.capacity() * sizeof(SVertexInstance) + m_indices.capacity() * sizeof(IndexType);
+		}
+		void ReleaseCpuData() override
+		{
+			std::vector<SVertexInstance>().swap(m_vretices);
+			std::vector<IndexType>().swap(m_indices);
+		}
+
 		std::vector<SVertexInstance> m_vretices;
 		std::vector<IndexType> m_indices;
 		uint32_t material;
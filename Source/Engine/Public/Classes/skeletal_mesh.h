@@ -0,0 +1,60 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+
+#include "Classes/mesh.h"
+#include "Core/basic_math.h"
+#include "Core/skinning.h"
+
+namespace FireEngine
+{
+	struct SBoneTransform
+	{
+		FVector translation{ FVector::Zero() };
+		FQuat   rotation{ FQuat::Identity() };
+		FVector scaling{ FVector::Ones() };
+	};
+
+	// 父骨骼总是排在子骨骼前面
+	struct SBone
+	{
+		std::string    name;
+		int32_t        parent_index{ -1 };
+		SBoneTransform bind_local;
+		FMatrix        inverse_bind_pose{ FMatrix::Identity() };
+	};
+
+	// 按固定帧率采样的局部变换, frames[frame * bone_count + bone]
+	struct SAnimationClip
+	{
+		std::string                 name;
+		float                       frame_rate{ 30.0f };
+		uint32_t                    frame_count{ 0 };
+		std::vector<SBoneTransform> frames;
+	};
+
+	// 顶点流与 CMesh 相同, 每个顶点多一个 SSkinWeight
+	class CSkeletalMesh : public CMesh
+	{
+	public:
+		CSkeletalMesh() = default;
+
+		uint64_t GetMemorySize() const override
+		{
+			return CMesh::GetMemorySize() + m_skin_weights.capacity() * sizeof(SSkinWeight);
+		}
+		// 骨骼和动画在求蒙皮矩阵时还要用, 只丢弃顶点流
+		void ReleaseCpuData() override
+		{
+			CMesh::ReleaseCpuData();
+			std::vector<SSkinWeight>().swap(m_skin_weights);
+		}
+
+		// 循环播放 clip_index 在 time 秒处的姿势, 输出每根骨骼的蒙皮矩阵; clip_index 越界时使用绑定姿势
+		void EvaluateSkinMatrices(uint32_t clip_index, float time, std::vector<SSkinMatrix>& out_matrices) const;
+
+		std::vector<SBone>          m_bones;
+		std::vector<SSkinWeight>    m_skin_weights;
+		std::vector<SAnimationClip> m_animations;
+	};
+}
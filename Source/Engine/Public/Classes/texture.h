@@ -5,19 +5,66 @@
 
 #include "Core/define.h"
 #include "Core/Asset.h"
+#include "Core/mapped_file.h"
+#include "Core/mip_generator.h"
+#include "Core/texture_compressor.h"
 
 namespace FireEngine {
+	class CJobSystem;
+
+	// 一个 mip 层级在数据块中的位置, 行与行之间可以有填充
+	struct STextureSubresource
+	{
+		uint32_t width;
+		uint32_t height;
+		uint64_t offset;
+		uint64_t row_pitch;  // 相邻两行起点的间距
+		uint64_t row_size;   // 一行的有效字节数
+		uint64_t row_count;  // 块压缩格式为块行数
+	};
+
+	// 贴图数据的只读视图, 可以指向 CTexture 也可以指向直接映射的 .fetex
+	struct STextureView
+	{
+		ETextureFormat             format{ ETextureFormat::RGBA8 };
+		uint32_t                   width{ 0 };
+		uint32_t                   height{ 0 };
+		const uint8_t*             data{ nullptr };
+		const STextureSubresource* subresources{ nullptr };
+		uint32_t                   subresource_count{ 0 };
+	};
+
 	class CTexture : public CAssetBase
 	{
 	public:
 		CTexture() = default;
 
-		void LoadTextureFromFile(const std::string& tex_file_name);
+		uint64_t GetMemorySize() const override { return m_data.capacity(); }
+		// 尺寸和格式保留, 像素数据和 mip 表清空
+		void ReleaseCpuData() override
+		{
+			std::vector<uint8_t>().swap(m_data);
+			m_mips.clear();
+		}
+
+		// job_system 不为空时, 大尺寸PNG的反滤波和展开分到工作线程上
+		void LoadTextureFromFile(const std::string& tex_file_name, CJobSystem* job_system = nullptr);
+		// 从内存中的图片文件解码, 供异步加载在工作线程调用
+		bool LoadTextureFromMemory(const SByteView& data, CJobSystem* job_system = nullptr);
+		// 在 level 0 之后生成完整的 mip 链, 只能在压缩前调用
+		bool GenerateMips(EMipContent content, EMipFilter filter, CJobSystem* job_system = nullptr);
+		// 把 m_data 中每个层级的 RGBA8 替换为块压缩数据, 宽高必须是4的倍数
+		bool Compress(ETextureFormat format, ECompressionQuality quality, CJobSystem* job_system = nullptr);
+		// 每层行紧密排列, 视图在 CTexture 和 out_subresources 存活期间有效
+		STextureView GetView(std::vector<STextureSubresource>& out_subresources) const;
 
 	public:
 		int32_t      m_width;
 		int32_t      m_height;
 		int32_t      m_channels;
+		ETextureFormat m_format{ ETextureFormat::RGBA8 };
+		// 所有层级依次存放, m_mips 记录每层的尺寸和位置, 至少有 level 0
 		std::vector<uint8_t> m_data;
+		std::vector<STextureMip> m_mips;
 	};
 }
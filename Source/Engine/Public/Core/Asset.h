@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include <cstdint>
 
 namespace FireEngine
 {
@@ -9,5 +10,10 @@ namespace FireEngine
 	public:
 		CAssetBase() = default;
 		virtual ~CAssetBase() = default;
+
+		// CPU 端数据占用的字节数, 用于驻留预算统计
+		virtual uint64_t GetMemorySize() const { return 0; }
+		// 数据已经上传到 GPU 后丢弃 CPU 副本, 资源对象本身保留
+		virtual void ReleaseCpuData() {}
 	};
 };
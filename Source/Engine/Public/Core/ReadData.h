@@ -2,16 +2,31 @@
 
 #include <cstdint>
 #include <fstream>
+#include <string>
 #include <vector>
 #include "define.h"
+#include "mapped_file.h"
 
 namespace FireEngine
 {
 	std::vector<uint8_t> ReadData(_In_z_ const wchar_t* name);
 
+	// 只读映射整个文件, 找不到时再到可执行文件目录下查找, 失败抛出异常
+	CMappedFile MapData(const std::string& file_name);
+
 	bool LoadMeshVertex(const std::string& mesh_file_name, std::vector<FireEngine::SVertexInstance>& out_vertex_instances, std::vector<IndexType>& out_indices);
 
 	void LoadTexture(const std::string& tex_file_name);
 
+	// 整个OBJ合并为一个网格, 索引相对于第一个顶点
 	void LoadMeshVertexObject(const std::string& mesh_file_name, std::vector<FireEngine::SVertexInstance>& out_vertex_instances, std::vector<IndexType>& out_indices);
+
+	// 按 o/g/usemtl 切分出子网格, 子网格内的索引相对于各自的 vertex_offset
+	bool LoadMeshVertexObject(const std::string& mesh_file_name, std::vector<FireEngine::SVertexInstance>& out_vertex_instances, std::vector<IndexType>& out_indices, std::vector<SGeometryDesc>& out_geometries);
+
+	// 解析已经在内存中的OBJ, 两个重载分别对应上面两个 LoadMeshVertexObject
+	bool ParseMeshVertexObject(const SByteView& data, std::vector<FireEngine::SVertexInstance>& out_vertex_instances, std::vector<IndexType>& out_indices);
+	bool ParseMeshVertexObject(const SByteView& data, std::vector<FireEngine::SVertexInstance>& out_vertex_instances, std::vector<IndexType>& out_indices, std::vector<SGeometryDesc>& out_geometries);
+	// 合并为一个网格, 同时返回 mtllib 引用的材质库(相对于OBJ所在目录), 没有时为空
+	bool ParseMeshVertexObject(const SByteView& data, std::vector<FireEngine::SVertexInstance>& out_vertex_instances, std::vector<IndexType>& out_indices, std::string& out_material_library);
 }
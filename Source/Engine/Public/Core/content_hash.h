@@ -0,0 +1,36 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+
+namespace FireEngine
+{
+	// 128位内容哈希, 用作派生数据缓存的键
+	struct SHash128
+	{
+		uint64_t low{ 0 };
+		uint64_t high{ 0 };
+
+		bool operator==(const SHash128& other) const { return low == other.low && high == other.high; }
+		bool operator!=(const SHash128& other) const { return !(*this == other); }
+		// 32个小写十六进制字符, 高位在前
+		std::string ToString() const;
+	};
+
+	// MurmurHash3 x64_128, 不是加密哈希, 只用来判断内容是否变化
+	SHash128 HashBytes(const void* data, uint64_t size, uint64_t seed = 0);
+
+	// 按顺序把多段数据混进同一个哈希, 各段的长度也参与哈希, 避免拼接位置不同却得到相同结果
+	class CContentHasher
+	{
+	public:
+		CContentHasher& Add(const void* data, uint64_t size);
+		CContentHasher& Add(const SHash128& hash) { return Add(&hash, sizeof(hash)); }
+		template <typename T>
+		CContentHasher& AddValue(const T& value) { return Add(&value, sizeof(T)); }
+
+		SHash128 Finish() const { return m_hash; }
+
+	private:
+		SHash128 m_hash;
+	};
+}
@@ -1,6 +1,8 @@
 ﻿#pragma once
 #include <DirectXMath.h>
 
+#include "index_type.h"
+
 namespace FireEngine
 {
 	struct SVertexInstance
@@ -45,7 +47,16 @@ namespace FireEngine
 		
 	};
 
-	typedef uint32_t IndexType;
+	// 一整块网格数据的只读视图, 子网格内的索引相对于各自的 vertex_offset
+	struct SMeshView
+	{
+		const SVertexInstance* vertices{ nullptr };
+		uint64_t               vertex_count{ 0 };
+		const IndexType*       indices{ nullptr };
+		uint64_t               index_count{ 0 };
+		const SGeometryDesc*   geometries{ nullptr };
+		uint64_t               geometry_count{ 0 };
+	};
 }
 namespace Config
 {
@@ -0,0 +1,9 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace FireEngine
+{
+	// 压缩成 zlib 流(RFC 1950), 由 ZlibInflate 解压; 只在烘焙和打包时使用
+	bool ZlibDeflate(const uint8_t* data, uint64_t size, std::vector<uint8_t>& out_data);
+}
@@ -0,0 +1,27 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+
+#include "Core/content_hash.h"
+
+namespace FireEngine
+{
+	// 本地磁盘上的派生数据缓存, 存放烘焙好的网格/贴图等
+	// 键是 源数据 + 烘焙器版本 + 烘焙设置 的内容哈希, 源文件没变就能跳过导入和烘焙
+	// 值只按键寻址, 写入后不再修改, 所以目录可以放到多个工作副本共享的位置
+	// 缓存只负责键到路径的映射; 读写由资源系统和烘焙函数完成, 它们都先写唯一的临时文件再改名
+	class CDerivedDataCache
+	{
+	public:
+		explicit CDerivedDataCache(const std::string& cache_directory);
+
+		const std::string& GetDirectory() const { return m_cache_directory; }
+
+		// <缓存目录>/<键的前两位>/<键>.<extension>, 烘焙函数可以直接写到这个路径
+		std::string GetPath(const SHash128& key, std::string_view extension) const;
+		bool Exists(const SHash128& key, std::string_view extension) const;
+
+	private:
+		std::string m_cache_directory;
+	};
+}
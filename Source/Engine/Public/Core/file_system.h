@@ -1,50 +1,246 @@
 ﻿#pragma once
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "Asset.h"
+#include "io_queue.h"
+#include "pak_file.h"
+#include "residency_manager.h"
+#include "slot_map.h"
 
 namespace FireEngine
 {
+	class CJobSystem;
+
+	// 虚拟文件系统, 按挂载顺序倒序查找, 后挂载的目录或 pak 覆盖先挂载的
+	// 资源根目录在构造时挂载, 所有挂载必须在开始加载资源之前完成
+	// 目录挂载下的散文件可以通过 IO 队列批量异步读取, pak 本身已经映射, 不需要
 	class CFileSystem
 	{
 	public:
-		CFileSystem(const std::string& resource_path) : m_resource_root_path(resource_path){
-			m_resource_root_path = m_resource_root_path + "/";
-		}
+		CFileSystem(const std::string& resource_path);
 
 		std::string GetFullPath(std::string_view relative_path) const
 		{
 			return m_resource_root_path + relative_path.data();
 		}
+
+		bool MountDirectory(const std::string& directory);
+		bool MountPak(const std::string& pak_file_name);
+
+		// 记录路径的写法并返回哈希, 目录挂载要靠它找回路径字符串, 可以在任意线程调用
+		FPathHash InternPath(std::string_view relative_path);
+		bool Exists(FPathHash path_hash) const;
+		// pak 中未压缩的条目返回指向 pak 映射的视图, 不做拷贝, 分块压缩的条目用 job_system 并行解压
+		bool ReadFile(FPathHash path_hash, SFileData& out_file, CJobSystem* job_system = nullptr) const;
+		bool ReadFile(std::string_view relative_path, SFileData& out_file, CJobSystem* job_system = nullptr);
+		// 只读文件中 [offset, offset + size) 的数据, 分块压缩的条目只解压涉及的块
+		bool ReadFileRange(FPathHash path_hash, uint64_t offset, uint64_t size, uint8_t* out_data, CJobSystem* job_system = nullptr) const;
+		// 散文件交给 IO 队列, 回调在IO线程上执行; pak 中的条目和找不到的文件在调用线程上读取并回调
+		// direct 只对散文件生效, 用于读完就上传的大块烘焙数据, 不占页缓存
+		void ReadFileAsync(FPathHash path_hash, EIoPriority priority, FIoReadCallback on_read, bool direct = false, CJobSystem* job_system = nullptr) const;
+		void ReadFileAsync(std::string_view relative_path, EIoPriority priority, FIoReadCallback on_read, bool direct = false, CJobSystem* job_system = nullptr);
+		// 不经过挂载点的绝对路径直接用这个队列读取
+		CIoQueue& GetIoQueue() const { return *m_io_queue; }
+
 	private:
-		std::string m_resource_root_path;
+		struct SMountPoint
+		{
+			std::string               directory;
+			std::unique_ptr<CPakFile> pak;
+		};
 
+		bool FindInternedPath(FPathHash path_hash, std::string& out_path) const;
 
+		std::string                                m_resource_root_path;
+		std::vector<SMountPoint>                   m_mount_points;
+		std::unordered_map<FPathHash, std::string> m_interned_paths;
+		mutable std::mutex                         m_intern_mutex;
+		std::unique_ptr<CIoQueue>                  m_io_queue;
 	};
 
 
+	enum class EAssetType : uint8_t
+	{
+		Mesh,            // OBJ, 合并成一个 CMesh
+		CookedMesh,      // .femesh, CCookedMesh
+		FbxMesh,         // 二进制FBX, CMesh
+		Texture,         // PNG 或 stb 支持的图片, 按 sRGB 生成 mip 链, CTexture
+		NormalMap,       // 法线贴图, 生成 mip 时逐 texel 重新归一化, CTexture
+		CookedTexture,   // .fetex, CCookedTexture
+		MaterialLibrary, // .mtl, CMaterialLibrary
+	};
+
+	enum class EAssetState : uint8_t
+	{
+		Invalid,   // 句柄无效或资源已经卸载
+		Loading,
+		Loaded,
+		Failed,
+	};
+
+	// LoadAsync/RetainAsset 返回的句柄, 资源在加载完成并发布前 GetAsset 返回空
+	// 资源卸载后槽位会被复用, 旧句柄靠代数识别, 不会查到新资源
+	struct SAssetHandle
+	{
+		SSlotHandle slot;
+		EAssetType  type{ EAssetType::Mesh };
+
+		bool IsValid() const { return slot.IsValid(); }
+	};
+
+	using FAssetLoadedCallback = std::function<void(SAssetHandle handle, CAssetBase* asset)>;
+	// 资源卸载前调用, asset 还有效, 用来释放由它创建的 RHI 资源, 资源系统析构时不调用
+	using FAssetUnloadCallback = std::function<void(SAssetHandle handle, CAssetBase* asset)>;
+
+	// 按 路径 + 类型 去重的资源表, 同一个文件不管被请求多少次只加载一份
+	// 每个使用者持有一个引用, 引用归零或显式 Unload 时释放CPU数据和关联的RHI资源
+	// 导入时发现的引用(OBJ -> mtllib -> 贴图)组成依赖图: 依赖以高一级的优先级并行加载,
+	// 全部完成(成功或失败)后才发布依赖它的资源, 资源对依赖各持有一个引用, 卸载时释放
+	// 资源的CPU数据和登记的GPU内存计入驻留预算, 超出时按最久未访问淘汰:
+	// 淘汰CPU数据只丢弃副本(ReleaseCpuData), 淘汰GPU内存会卸载整个资源
 	class CAssetSystem
 	{
 	public:
+		CAssetSystem();
+		~CAssetSystem();
+
+		// 接管不来自文件的资源(比如运行时生成或烘焙出来的), 引用计数为1
+		SAssetHandle RetainAsset(std::unique_ptr<CAssetBase>&& asset, EAssetType type);
+
+		// 同时记录一次访问, 用于LRU淘汰
+		CAssetBase* GetAsset(SAssetHandle handle);
 
-		uint64_t RetainAsset(std::unique_ptr<CAssetBase>&& asset)
+		template <typename T>
+		T* GetAsset(SAssetHandle handle)
 		{
-			uint64_t asset_id =m_assets.size();
-			m_assets.emplace_back(std::move(asset));
-			return asset_id;
+			return dynamic_cast<T*>(GetAsset(handle));
 		}
 
-		CAssetBase* GetAsset(uint64_t asset_id)
+		// file_name 是相对于挂载点的路径, 通过 CFileSystem 读取, 绝对路径直接交给 IO 队列
+		// 读取线程按优先级取出请求, 散文件提交给 IO 队列批量读取, 解码交给工作线程, 完成后由主线程 PumpCompletions 发布并回调
+		// 同一路径和类型已经加载或正在加载时不再读取, 返回同一个句柄并增加一次引用, 优先级以第一次请求为准
+		// 只能在主线程调用, 失败时回调的 asset 为空, 失败的路径下次请求会重新加载
+		SAssetHandle LoadAsync(const std::string& file_name, EAssetType type, FAssetLoadedCallback on_loaded = nullptr, EIoPriority priority = EIoPriority::Normal);
+		EAssetState GetState(SAssetHandle handle) const;
+		uint32_t GetRefCount(SAssetHandle handle) const;
+		// 导入时发现的直接依赖, 比如网格的材质库和材质库引用的贴图, 加载失败的依赖也在其中
+		std::vector<SAssetHandle> GetDependencies(SAssetHandle handle) const;
+
+		// 把句柄交给新的使用者时加一次引用, 每个使用者用完调用一次 Release, 引用归零时卸载
+		void AddRef(SAssetHandle handle);
+		void Release(SAssetHandle handle);
+		// 不管引用计数立即卸载: 先执行卸载回调释放RHI资源, 再销毁CPU数据, 句柄随之失效
+		// 还在加载中的资源在完成后直接丢弃
+		void Unload(SAssetHandle handle);
+		void AddUnloadCallback(SAssetHandle handle, FAssetUnloadCallback on_unload);
+
+		// 登记由这个资源创建的GPU内存, 随资源一起卸载
+		void TrackGpuMemory(SAssetHandle handle, EResidencyCategory category, uint64_t size);
+		// 正在使用的资源固定住对应类别的内存, 比如场景正在绘制的贴图固定 GpuTexture, CPU副本仍然可以淘汰
+		void PinAsset(SAssetHandle handle, EResidencyCategory category);
+		void UnpinAsset(SAssetHandle handle, EResidencyCategory category);
+		bool IsCpuResident(SAssetHandle handle) const;
+		// 每帧在 PumpCompletions 之后调用, 推进访问时间并把超出预算的内存淘汰掉
+		void UpdateResidency();
+		CResidencyManager& GetResidency() { return m_residency; }
+
+		// 发布已完成的资源并执行回调, 每帧在主线程调用
+		void PumpCompletions();
+		// 阻塞到 handle 完成, 期间发布其它已完成的资源, 返回是否加载成功
+		bool Wait(SAssetHandle handle);
+
+	private:
+		struct SLoadRequest
+		{
+			SAssetHandle handle;
+			std::string  file_name;
+			EIoPriority  priority{ EIoPriority::Normal };
+		};
+
+		// 路径已经换算成相对于挂载点(或绝对路径), 可以直接交给 LoadAsync
+		struct SAssetDependency
+		{
+			std::string file_name;
+			EAssetType  type;
+		};
+
+		struct SLoadResult
+		{
+			SAssetHandle                  handle;
+			std::unique_ptr<CAssetBase>   asset;
+			std::vector<SAssetDependency> dependencies;
+		};
+
+		// 同一个文件按不同类型加载(比如颜色贴图和法线贴图)是不同的资源
+		struct SAssetKey
+		{
+			FPathHash  path_hash;
+			EAssetType type;
+
+			bool operator==(const SAssetKey& other) const { return path_hash == other.path_hash && type == other.type; }
+		};
+
+		struct SAssetKeyHasher
 		{
-			if (asset_id < m_assets.size())
+			size_t operator()(const SAssetKey& key) const
 			{
-				return m_assets[asset_id].get();
+				return static_cast<size_t>(key.path_hash ^ (static_cast<uint64_t>(key.type) * 0x9E3779B97F4A7C15ull));
 			}
-			return nullptr;
-		}
-	private:
-		std::vector<std::unique_ptr<CAssetBase>> m_assets;
+		};
+
+		// 只在主线程访问, 读取线程和工作线程只拿到句柄, 卸载时从 m_records 中删除
+		struct SAssetRecord
+		{
+			std::unique_ptr<CAssetBase>       asset;
+			EAssetState                       state{ EAssetState::Loading };
+			uint32_t                          ref_count{ 0 };
+			bool                              has_key{ false };  // RetainAsset 进来的资源没有路径
+			SAssetKey                         key{};
+			std::vector<FAssetLoadedCallback> on_loaded;
+			std::vector<FAssetUnloadCallback> on_unload;
+			FResidencyHandle                  cpu_residency;
+			std::vector<FResidencyHandle>     gpu_residency;
+			EIoPriority                       priority{ EIoPriority::Normal };
+			std::vector<SAssetHandle>         dependencies;
+			// 解码已经完成, 还在等待的依赖数, 归零时发布
+			uint32_t                          pending_dependencies{ 0 };
+		};
+
+		void ReaderLoop();
+		// 在IO线程或读取线程上调用, 烘焙结果直接校验, 其它类型交给工作线程解码
+		void OnFileRead(SLoadRequest&& request, bool success, SFileData&& file_data);
+		void Decode(SLoadRequest&& request, SFileData&& file_data);
+		void Complete(SLoadRequest&& request, std::unique_ptr<CAssetBase>&& asset, std::vector<SAssetDependency>&& dependencies = {});
+		// 以下在主线程调用
+		void Publish(SAssetHandle handle);
+		void OnDependencyLoaded(SAssetHandle handle);
+
+		void ForgetKey(SAssetRecord& record);
+		void TrackCpuMemory(SAssetHandle handle);
+
+		TSlotMap<SAssetRecord>                                      m_records;
+		std::unordered_map<SAssetKey, SSlotHandle, SAssetKeyHasher> m_asset_slots;
+		// 请求时已经加载完成的资源, 回调推迟到下一次 PumpCompletions, 与异步完成的时机一致
+		std::vector<std::pair<SAssetHandle, FAssetLoadedCallback>> m_ready_callbacks;
+		CResidencyManager                                           m_residency;
+
+		std::thread                                                 m_reader_thread;
+		std::array<std::deque<SLoadRequest>, c_io_priority_count>   m_read_requests;
+		std::vector<SLoadResult>                                    m_completed;
+		std::mutex                                                  m_mutex;
+		std::condition_variable                                     m_read_condition;
+		std::condition_variable                                     m_complete_condition;
+		uint32_t                                                    m_in_flight{ 0 };
+		bool                                                        m_quit{ false };
 	};
 };
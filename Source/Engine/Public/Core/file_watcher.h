@@ -0,0 +1,51 @@
+﻿#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace FireEngine
+{
+	// 递归监视一个目录, 后台线程收集写完或改名进来的文件, 主线程每帧取走
+	// Windows 用 ReadDirectoryChangesW, 其它平台用 inotify
+	class CFileWatcher
+	{
+	public:
+		// 文件最后一次变化之后 settle_time_ms 内没有新变化才报告, 避免读到编辑器写了一半的文件
+		explicit CFileWatcher(const std::string& root_directory, uint32_t settle_time_ms = 200);
+		~CFileWatcher();
+
+		CFileWatcher(const CFileWatcher&) = delete;
+		CFileWatcher& operator=(const CFileWatcher&) = delete;
+
+		bool IsWatching() const { return m_thread.joinable(); }
+		// 取走已经稳定的变化, 路径相对于根目录, 用 '/' 分隔, 同一个文件只出现一次
+		void PollChanges(std::vector<std::string>& out_paths);
+
+	private:
+		bool Open();
+		void Close();
+		void WatchLoop();
+		void AddChange(std::string&& path);
+
+		std::string                                                            m_root_directory;
+		std::chrono::milliseconds                                              m_settle_time;
+		std::thread                                                            m_thread;
+		std::mutex                                                             m_mutex;
+		std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_pending_changes;
+#if defined(_WIN32)
+		void* m_directory_handle{ nullptr };
+		void* m_stop_event{ nullptr };
+#else
+		// 新建的子目录要单独添加监视, 只在监视线程访问
+		void AddWatches(const std::string& relative_directory);
+
+		int                                  m_inotify_descriptor{ -1 };
+		int                                  m_stop_pipe[2]{ -1, -1 };
+		std::unordered_map<int, std::string> m_watch_directories;
+#endif
+	};
+}
@@ -0,0 +1,11 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace FireEngine
+{
+	// 读取空白分隔的浮点数表, 每 column_count 个数为一行, 与换行的位置无关(和 ifstream >> 的语义一致)
+	// 用SIMD一次扫描64字节找出所有记号的起点, 再用 from_chars 转换
+	// 遇到不是数字的记号或读满 max_row_count 行时停止, 不完整的最后一行会被丢弃, 返回读到的行数
+	uint64_t ReadFloatTable(const char* begin, const char* end, uint32_t column_count, std::vector<float>& out_values, uint64_t max_row_count = UINT64_MAX);
+}
@@ -0,0 +1,8 @@
+﻿#pragma once
+#include <cstdint>
+
+namespace FireEngine
+{
+	// 单独放在这里, 只用到索引的代码(比如三角化)不必引入 DirectXMath
+	typedef uint32_t IndexType;
+}
@@ -0,0 +1,11 @@
+﻿#pragma once
+#include <cstdint>
+
+#include "mapped_file.h"
+
+namespace FireEngine
+{
+	// 解压 zlib 流(RFC 1950/1951)到 out, 超出 out_capacity 视为失败
+	// 不校验 adler32, 与 stb 的行为一致
+	bool ZlibInflate(const SByteView& compressed, uint8_t* out, uint64_t out_capacity, uint64_t& out_size);
+}
@@ -0,0 +1,75 @@
+﻿#pragma once
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Core/mapped_file.h"
+
+namespace FireEngine
+{
+	enum class EIoPriority : uint8_t
+	{
+		High,    // 当前帧就要用的资源
+		Normal,
+		Low,     // 预取
+		Count,
+	};
+
+	constexpr uint32_t c_io_priority_count = static_cast<uint32_t>(EIoPriority::Count);
+	// 大文件按块读取, O_DIRECT 的块先读进同样大小的对齐缓冲
+	constexpr uint32_t c_io_chunk_size = 1u << 20;
+	// 小于这个大小的文件走页缓存, 直接读的收益抵不过对齐和拷贝
+	constexpr uint64_t c_direct_io_min_size = 4ull << 20;
+
+	// 整个文件读完后调用, 失败时 success 为 false, 在IO线程上执行, 不要在回调里阻塞
+	using FIoReadCallback = std::function<void(bool success, SFileData&& file_data)>;
+
+	// 批量读取整个文件的请求队列, 按优先级出队, 同时打开的文件和在途的块都不超过 queue_depth
+	// Linux 上用 io_uring 一次系统调用提交一批读取并收割完成, 内核不支持(或被禁用)时退回 pread 线程池
+	// direct 的大文件用 O_DIRECT 绕过页缓存, 读进注册给内核的对齐缓冲(READ_FIXED)再拷贝出来
+	class CIoQueue
+	{
+	public:
+		explicit CIoQueue(uint32_t queue_depth = 64);
+		// 还在排队的请求以失败回调, 已经提交的读取等它完成
+		~CIoQueue();
+
+		CIoQueue(const CIoQueue&) = delete;
+		CIoQueue& operator=(const CIoQueue&) = delete;
+
+		// file_name 是完整路径, 可以在任意线程调用
+		void Read(const std::string& file_name, EIoPriority priority, FIoReadCallback on_read, bool direct = false);
+		bool IsUsingIoUring() const { return m_ring != nullptr; }
+
+	private:
+		struct SReadRequest
+		{
+			std::string     file_name;
+			FIoReadCallback on_read;
+			bool            direct{ false };
+		};
+
+		struct SRing;
+
+		// 需要持有 m_mutex
+		bool PopRequest(SReadRequest& out_request);
+		bool HasRequests() const;
+		void WorkerLoop();
+		void RingLoop();
+
+		uint32_t                                                   m_queue_depth;
+		std::array<std::deque<SReadRequest>, c_io_priority_count> m_requests;
+		std::mutex                                                 m_mutex;
+		std::condition_variable                                    m_condition;
+		bool                                                       m_quit{ false };
+		std::unique_ptr<SRing>                                     m_ring;
+		std::vector<std::thread>                                   m_threads;
+	};
+}
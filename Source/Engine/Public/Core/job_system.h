@@ -0,0 +1,38 @@
+﻿#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FireEngine
+{
+	class CJobSystem
+	{
+	public:
+		// worker_count为0时使用 硬件线程数-1 个工作线程
+		explicit CJobSystem(uint32_t worker_count = 0);
+		~CJobSystem();
+
+		CJobSystem(const CJobSystem&) = delete;
+		CJobSystem& operator=(const CJobSystem&) = delete;
+
+		uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+		void Submit(std::function<void()> job);
+
+		// 把[0, count)分给工作线程和调用线程一起执行, 返回时全部完成, 可以嵌套调用
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& job);
+
+	private:
+		void WorkerLoop();
+
+		std::vector<std::thread>          m_workers;
+		std::deque<std::function<void()>> m_jobs;
+		std::mutex                        m_mutex;
+		std::condition_variable           m_condition;
+		bool                              m_quit{ false };
+	};
+}
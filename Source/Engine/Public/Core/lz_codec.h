@@ -0,0 +1,18 @@
+﻿#pragma once
+#include <cstdint>
+
+namespace FireEngine
+{
+	// 面向字节的 LZ77 编码, 格式与 LZ4 的 block 格式相同:
+	// token(高4位字面量长度, 低4位匹配长度-4), 长度为15时后面跟若干个累加的字节, 255表示继续
+	// 字面量, 2字节小端偏移, 最后5个字节总是字面量
+	// 只用于单个 pak 块, 块大小不超过 c_lz_max_block_size
+	constexpr uint64_t c_lz_max_block_size = 1u << 30;
+
+	// 最坏情况(不可压缩)下的输出大小
+	uint64_t LzCompressBound(uint64_t size);
+	// 返回压缩后的字节数, dst_capacity 小于 LzCompressBound(size) 时返回 0
+	uint64_t LzCompress(const uint8_t* src, uint64_t size, uint8_t* dst, uint64_t dst_capacity);
+	// 必须正好解出 dst_size 个字节, 越界的输入返回失败而不会读写越界
+	bool LzDecompress(const uint8_t* src, uint64_t src_size, uint8_t* dst, uint64_t dst_size);
+}
@@ -0,0 +1,73 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace FireEngine
+{
+	// 只读的字节视图, 不持有内存
+	struct SByteView
+	{
+		const uint8_t* data{ nullptr };
+		uint64_t       size{ 0 };
+
+		bool Empty() const { return size == 0; }
+		const char* CharBegin() const { return reinterpret_cast<const char*>(data); }
+		const char* CharEnd() const { return reinterpret_cast<const char*>(data) + size; }
+	};
+
+	// 把整个文件只读映射到进程地址空间, 页面按需换入, 不做拷贝
+	// 析构时解除映射, 所有从GetView()拿到的视图随之失效
+	class CMappedFile
+	{
+	public:
+		CMappedFile() = default;
+		~CMappedFile();
+
+		CMappedFile(const CMappedFile&) = delete;
+		CMappedFile& operator=(const CMappedFile&) = delete;
+		CMappedFile(CMappedFile&& other) noexcept;
+		CMappedFile& operator=(CMappedFile&& other) noexcept;
+
+		bool Open(const std::string& file_name);
+		void Close();
+
+		bool IsOpen() const { return m_is_open; }
+		const uint8_t* GetData() const { return m_data; }
+		uint64_t GetSize() const { return m_size; }
+		SByteView GetView() const { return { m_data, m_size }; }
+
+	private:
+		void MoveFrom(CMappedFile& other);
+
+		const uint8_t* m_data{ nullptr };
+		uint64_t       m_size{ 0 };
+		bool           m_is_open{ false };
+#if defined(_WIN32)
+		void* m_file_handle{ nullptr };
+		void* m_mapping_handle{ nullptr };
+#else
+		int m_file_descriptor{ -1 };
+#endif
+	};
+
+	// 写文件时用的临时文件名, 每次调用都不同, 多个进程往共享目录写同一个文件时互不覆盖
+	// 写完后改名成 file_name, 读取端永远看不到写了一半的文件
+	std::string MakeTempFileName(const std::string& file_name);
+
+	// 通过文件系统读到的一个文件, view 指向映射内存或 buffer
+	// pak 中未压缩的条目直接指向 pak 的映射, 不持有任何内存, 只在挂载期间有效
+	struct SFileData
+	{
+		SByteView            view;
+		CMappedFile          mapped_file;  // 目录挂载下单独映射的文件
+		std::vector<uint8_t> buffer;       // 压缩条目解压后的数据
+
+		bool Open(const std::string& file_name)
+		{
+			buffer.clear();
+			view = mapped_file.Open(file_name) ? mapped_file.GetView() : SByteView{};
+			return mapped_file.IsOpen();
+		}
+	};
+}
@@ -0,0 +1,37 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace FireEngine
+{
+	class CJobSystem;
+
+	enum class EMipContent : uint8_t
+	{
+		Color,      // sRGB 颜色, 转到线性空间滤波, alpha 按线性处理
+		Linear,     // 线性数据(遮罩, 粗糙度等)
+		NormalMap,  // 切线空间法线, 滤波后逐 texel 重新归一化
+	};
+
+	enum class EMipFilter : uint8_t
+	{
+		Box,        // 2x2 平均, 最快
+		Kaiser,     // 8 tap Kaiser 窗 sinc, 更锐利
+	};
+
+	// 一个 mip 层级在贴图数据里的位置
+	struct STextureMip
+	{
+		uint32_t width{ 0 };
+		uint32_t height{ 0 };
+		uint64_t offset{ 0 };
+		uint64_t size{ 0 };
+	};
+
+	uint32_t GetMipCount(uint32_t width, uint32_t height);
+
+	// data 开头为 RGBA8 的 level 0, 其余层级依次追加在后面, out_mips 包含 level 0
+	// 层级之间按顺序生成, 每个层级按行块分给工作线程
+	bool GenerateMipChain(std::vector<uint8_t>& data, uint32_t width, uint32_t height, EMipContent content, EMipFilter filter,
+		std::vector<STextureMip>& out_mips, CJobSystem* job_system);
+}
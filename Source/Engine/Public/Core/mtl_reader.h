@@ -0,0 +1,22 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+
+#include "define.h"
+#include "mapped_file.h"
+
+namespace FireEngine
+{
+	// newmtl 定义的一个材质, 贴图路径相对于 .mtl 所在目录, 没有时为空
+	struct SMtlMaterial
+	{
+		std::string name;
+		SMaterial   material{};
+		std::string diffuse_texture;  // map_Kd
+		std::string normal_texture;   // map_Bump / bump / norm
+	};
+
+	// 解析OBJ的材质库, 只取 Kd/Ks/Ke/Ns/Ni 和颜色/法线贴图, 其它语句忽略
+	// 贴图语句的选项(-bm 等)被跳过, 取最后一项作为文件名, 不支持带空格的路径
+	bool ReadMtl(const SByteView& buffer, std::vector<SMtlMaterial>& out_materials);
+}
@@ -0,0 +1,30 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+
+#include "define.h"
+#include "mapped_file.h"
+
+namespace FireEngine
+{
+	class CJobSystem;
+
+	struct SObjMeshData
+	{
+		std::vector<SVertexInstance> vertices;
+		std::vector<IndexType>       indices;
+		// 每个 o/g/usemtl 切分出一个子网格, 子网格内的索引相对于 vertex_offset
+		std::vector<SGeometryDesc>   geometries;
+		std::vector<std::string>     geometry_names;
+		// SGeometryDesc::material_index 指向这里, 没有 usemtl 时为 0
+		std::vector<std::string>     material_names;
+		std::string                  material_library;
+	};
+
+	// 在内存中的OBJ文本上单遍解析, 直接写出 SVertexInstance 和 IndexType
+	bool ReadObj(const SByteView& buffer, SObjMeshData& out_mesh);
+
+	// 在换行处把文件切块后并行解析, 再用前缀和修正 v/vt/vn 基址和 o/g/usemtl 子网格边界
+	// 输出与 ReadObj 完全一致, 文件较小时直接退回单线程
+	bool ReadObjParallel(const SByteView& buffer, CJobSystem& job_system, SObjMeshData& out_mesh);
+}
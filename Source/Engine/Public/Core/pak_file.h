@@ -0,0 +1,98 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace FireEngine
+{
+	class CJobSystem;
+
+	// 规范化后的相对路径的 64 位 FNV-1a, 不区分大小写, '\' 与 '/' 等价
+	using FPathHash = uint64_t;
+	FPathHash HashPath(std::string_view path);
+	// 去掉开头的 "./" 和 '/', 反斜杠统一成 '/'
+	std::string NormalizePath(std::string_view path);
+
+	constexpr uint32_t c_pak_magic = 0x4B415046; // "FPAK"
+	constexpr uint32_t c_pak_version = 1;
+	// 条目按页对齐, 映射后可以直接交给要求对齐的加载器(.femesh/.fetex)
+	constexpr uint64_t c_pak_entry_alignment = 4096;
+
+	// Lz 条目按 c_pak_chunk_size 切成独立的块, 可以并行解压, 也可以只解压读到的范围
+	constexpr uint32_t c_pak_chunk_size = 128 * 1024;
+
+	enum class EPakCompression : uint32_t
+	{
+		None,
+		Zlib,
+		Lz,    // 条目开头是 SPakChunkTable
+	};
+
+	struct alignas(16) SPakHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entry_count;
+		uint32_t entry_stride;
+		uint64_t entry_offset;   // 按 path_hash 升序排列的 SPakEntry 表
+		uint64_t string_offset;  // 以 '\0' 结尾的原始路径, 只用于调试和列举
+		uint64_t string_size;
+		uint64_t reserved;
+	};
+
+	struct SPakEntry
+	{
+		FPathHash path_hash;
+		uint64_t  offset;
+		uint64_t  size;               // 包内的字节数
+		uint64_t  uncompressed_size;
+		uint32_t  compression;        // EPakCompression
+		uint32_t  name_offset;        // 相对于 string_offset
+	};
+
+	// Lz 条目数据的开头, 后面跟 chunk_count + 1 个 uint64_t 块偏移(相对于条目开头), 最后一个是条目末尾
+	// 块的大小等于解压后的大小时按原样存储
+	struct SPakChunkTable
+	{
+		uint32_t chunk_size;
+		uint32_t chunk_count;
+	};
+
+	struct SPakSource
+	{
+		std::string path;       // 包内的相对路径
+		std::string file_name;  // 磁盘上的文件
+	};
+
+	// 打包, 只在烘焙时调用, 压缩能省下至少1/8的条目按 compression 存储, 其余不压缩
+	// job_system 不为空时 Lz 的块分给工作线程压缩
+	bool WritePak(const std::string& pak_file_name, const std::vector<SPakSource>& sources, EPakCompression compression, CJobSystem* job_system = nullptr);
+	// 把 directory 下的所有文件按相对路径打包
+	bool WritePakFromDirectory(const std::string& pak_file_name, const std::string& directory, EPakCompression compression, CJobSystem* job_system = nullptr);
+
+	// 只读映射整个 pak, 目录表直接在映射内存上二分查找, 打开时不为条目分配任何内存
+	class CPakFile
+	{
+	public:
+		bool Open(const std::string& pak_file_name);
+
+		const SPakEntry* Find(FPathHash path_hash) const;
+		// 未压缩的条目返回指向映射的视图, 压缩的条目解压到 out_file.buffer
+		// job_system 不为空时 Lz 的块在工作线程上并行解压
+		bool Read(const SPakEntry& entry, SFileData& out_file, CJobSystem* job_system = nullptr) const;
+		// 读取解压后 [offset, offset + size) 的数据, Lz 条目只解压涉及的块, zlib 条目需要整个解压
+		bool ReadRange(const SPakEntry& entry, uint64_t offset, uint64_t size, uint8_t* out_data, CJobSystem* job_system = nullptr) const;
+		const char* GetEntryName(const SPakEntry& entry) const;
+
+		uint32_t GetEntryCount() const { return m_header ? m_header->entry_count : 0; }
+		const SPakEntry* GetEntries() const { return m_entries; }
+
+	private:
+		CMappedFile       m_mapped_file;
+		const SPakHeader* m_header{ nullptr };
+		const SPakEntry*  m_entries{ nullptr };
+	};
+}
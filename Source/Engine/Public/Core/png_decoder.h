@@ -0,0 +1,34 @@
+﻿#pragma once
+#include <cstdint>
+
+#include "mapped_file.h"
+
+namespace FireEngine
+{
+	class CJobSystem;
+
+	// 与 stb 的 STBI_MAX_DIMENSIONS 相同; 另外解码后的 RGBA 不能超过 c_png_max_decoded_size
+	constexpr uint32_t c_png_max_dimension = 1u << 24;
+	constexpr uint64_t c_png_max_decoded_size = INT32_MAX;
+
+	struct SPngInfo
+	{
+		uint32_t width{ 0 };
+		uint32_t height{ 0 };
+		uint8_t  bit_depth{ 0 };
+		uint8_t  color_type{ 0 };
+		uint8_t  interlace{ 0 };
+		// 与 stb 相同的通道数: 调色板图为3, 带 tRNS 时多一个透明通道
+		uint8_t  channels{ 0 };
+	};
+
+	// 只解析文件头和 IHDR, 不是PNG、尺寸为0或超出上面的限制时返回false
+	bool ReadPngInfo(const SByteView& data, SPngInfo& out_info);
+
+	// 8/16 位非隔行的灰度/RGB/调色板/灰度透明/RGBA 由 DecodePng 处理, 其它格式交给 stb
+	bool IsPngDecodable(const SPngInfo& info);
+
+	// 解码为 RGBA8 直接写进 out_pixels(至少 width * height * 4 字节), 不经过中间的像素缓冲
+	// job_system 不为空时, 以 None/Sub 滤波的行作为分段起点并行反滤波, 再按行块并行展开成 RGBA
+	bool DecodePng(const SByteView& data, const SPngInfo& info, uint8_t* out_pixels, CJobSystem* job_system);
+}
@@ -0,0 +1,88 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+
+#include "Core/slot_map.h"
+
+namespace FireEngine
+{
+	enum class EResidencyCategory : uint8_t
+	{
+		CpuPayload,  // 资源对象在内存里的数据(顶点, 像素, 映射的烘焙文件)
+		GpuBuffer,   // 顶点/索引等缓冲
+		GpuTexture,  // 贴图
+		Count,
+	};
+
+	constexpr uint32_t c_residency_category_count = static_cast<uint32_t>(EResidencyCategory::Count);
+
+	struct SResidencyStats
+	{
+		uint64_t budget{ UINT64_MAX };
+		uint64_t current{ 0 };
+		uint64_t peak{ 0 };
+		uint64_t evicted_bytes{ 0 };
+		uint32_t evicted_count{ 0 };
+	};
+
+	using FResidencyHandle = SSlotHandle;
+	// 被淘汰时调用, 负责真正释放内存, 调用前条目已经移除
+	using FResidencyEvictCallback = std::function<void()>;
+
+	// 按类别统计内存并在超出预算时按最久未访问的顺序淘汰
+	// 每个类别一条 LRU 链表, Touch 把条目移到链表尾, 淘汰从链表头开始, 都是 O(1)
+	// 固定(Pin)的条目暂时移出链表, 不会被淘汰, 只能在主线程调用
+	class CResidencyManager
+	{
+	public:
+		void SetBudget(EResidencyCategory category, uint64_t budget);
+		const SResidencyStats& GetStats(EResidencyCategory category) const { return m_stats[static_cast<uint32_t>(category)]; }
+		void PrintStats() const;
+
+		FResidencyHandle Track(EResidencyCategory category, uint64_t size, FResidencyEvictCallback on_evict);
+		// 所有者自己释放了内存, 不调用淘汰回调
+		void Untrack(FResidencyHandle handle);
+		void Resize(FResidencyHandle handle, uint64_t size);
+		void Touch(FResidencyHandle handle);
+		// 可以嵌套, Pin 和 Unpin 次数相同后才能再被淘汰
+		void Pin(FResidencyHandle handle);
+		void Unpin(FResidencyHandle handle);
+		bool IsPinned(FResidencyHandle handle) const;
+		EResidencyCategory GetCategory(FResidencyHandle handle) const;
+
+		// 推进一帧, 用来记录访问时间
+		void BeginFrame() { ++m_frame; }
+		uint64_t GetFrame() const { return m_frame; }
+		uint64_t GetLastAccessFrame(FResidencyHandle handle) const;
+		// 把每个类别淘汰到预算以内, 全部被固定时保持超出
+		void EnforceBudgets();
+
+	private:
+		struct SEntry
+		{
+			EResidencyCategory      category;
+			uint64_t                size;
+			uint64_t                last_access_frame;
+			uint32_t                pin_count{ 0 };
+			FResidencyHandle        prev;
+			FResidencyHandle        next;
+			FResidencyEvictCallback on_evict;
+		};
+
+		struct SLruList
+		{
+			FResidencyHandle head;  // 最久未访问
+			FResidencyHandle tail;  // 最近访问
+		};
+
+		void Link(FResidencyHandle handle, SEntry& entry);
+		void Unlink(SEntry& entry);
+		void Remove(FResidencyHandle handle, SEntry& entry);
+
+		TSlotMap<SEntry>                                        m_entries;
+		std::array<SLruList, c_residency_category_count>        m_lru_lists{};
+		std::array<SResidencyStats, c_residency_category_count> m_stats{};
+		uint64_t                                                m_frame{ 0 };
+	};
+}
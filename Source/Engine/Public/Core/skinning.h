@@ -0,0 +1,43 @@
+﻿#pragma once
+#include <cstdint>
+
+#include "define.h"
+
+namespace FireEngine
+{
+	class CJobSystem;
+
+	constexpr uint32_t c_max_bone_influences = 4;
+
+	// 每个顶点最多4根骨骼, 权重量化为 0~255 且和恒为 255, 权重为0的槽位骨骼下标为0
+	struct SSkinWeight
+	{
+		uint16_t bone_indices[c_max_bone_influences];
+		uint8_t  weights[c_max_bone_influences];
+	};
+
+	// 蒙皮矩阵(当前全局变换 * 绑定逆矩阵)按列存放, 只用前三行, 每列第4个分量填0
+	struct alignas(16) SSkinMatrix
+	{
+		float columns[4][4];
+	};
+
+	// 一个角色的一次蒙皮: 绑定姿势的顶点流 -> 变形后的顶点流, uv/color 原样拷贝
+	struct SSkinningJob
+	{
+		const SVertexInstance* bind_vertices{ nullptr };
+		const SSkinWeight*     skin_weights{ nullptr };
+		const SSkinMatrix*     skin_matrices{ nullptr };
+		SVertexInstance*       out_vertices{ nullptr };
+		uint32_t               vertex_count{ 0 };
+	};
+
+	// 保留权重最大的4个影响并量化, influence_count 可以超过4
+	SSkinWeight QuantizeSkinWeight(const uint32_t* bone_indices, const float* weights, uint32_t influence_count);
+
+	// 线性混合蒙皮 [vertex_begin, vertex_end)
+	void SkinVertices(const SSkinningJob& job, uint32_t vertex_begin, uint32_t vertex_end);
+
+	// 所有角色的顶点按固定大小分批, 交给工作线程并行蒙皮
+	void SkinVertices(const SSkinningJob* jobs, uint32_t job_count, CJobSystem& job_system);
+}
@@ -0,0 +1,131 @@
+﻿#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace FireEngine
+{
+	// 32位槽位下标 + 32位代数, 槽位被复用后旧句柄的代数对不上, 查找直接返回空
+	struct SSlotHandle
+	{
+		uint32_t index{ UINT32_MAX };
+		uint32_t generation{ 0 };
+
+		bool IsValid() const { return index != UINT32_MAX; }
+		bool operator==(const SSlotHandle& other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(const SSlotHandle& other) const { return !(*this == other); }
+		uint64_t ToU64() const { return (static_cast<uint64_t>(generation) << 32) | index; }
+	};
+
+	// 元素紧密存放在一个数组里, 删除时把最后一个元素挪进空位, 遍历没有空洞
+	// 句柄通过槽位表间接找到元素, 插入/删除/查找都是 O(1), 空闲槽位串成链表复用
+	// 元素的地址在插入和删除后可能改变, 只保存句柄, 不要保存指针
+	template <typename T>
+	class TSlotMap
+	{
+	public:
+		template <typename... Args>
+		SSlotHandle Emplace(Args&&... args)
+		{
+			uint32_t slot_index;
+			if (m_free_head != UINT32_MAX)
+			{
+				slot_index = m_free_head;
+				m_free_head = m_slots[slot_index].dense_index;
+			}
+			else
+			{
+				slot_index = static_cast<uint32_t>(m_slots.size());
+				m_slots.push_back({ 0, 1 });
+			}
+			SSlot& slot = m_slots[slot_index];
+			slot.dense_index = static_cast<uint32_t>(m_values.size());
+			m_values.emplace_back(std::forward<Args>(args)...);
+			m_dense_to_slot.push_back(slot_index);
+			return { slot_index, slot.generation };
+		}
+
+		SSlotHandle Insert(T&& value) { return Emplace(std::move(value)); }
+		SSlotHandle Insert(const T& value) { return Emplace(value); }
+
+		bool Erase(SSlotHandle handle)
+		{
+			if (!Contains(handle))
+			{
+				return false;
+			}
+			SSlot& slot = m_slots[handle.index];
+			const uint32_t dense_index = slot.dense_index;
+			const uint32_t last_index = static_cast<uint32_t>(m_values.size() - 1);
+			if (dense_index != last_index)
+			{
+				m_values[dense_index] = std::move(m_values[last_index]);
+				m_dense_to_slot[dense_index] = m_dense_to_slot[last_index];
+				m_slots[m_dense_to_slot[dense_index]].dense_index = dense_index;
+			}
+			m_values.pop_back();
+			m_dense_to_slot.pop_back();
+
+			// 代数用完的槽位不再复用, 保证旧句柄永远查不到新元素
+			if (++slot.generation != 0)
+			{
+				slot.dense_index = m_free_head;
+				m_free_head = handle.index;
+			}
+			return true;
+		}
+
+		bool Contains(SSlotHandle handle) const
+		{
+			// 删除时代数已经加一, 空闲槽位不会匹配任何发出去的句柄
+			return handle.index < m_slots.size() && handle.generation != 0 && m_slots[handle.index].generation == handle.generation;
+		}
+
+		T* Get(SSlotHandle handle)
+		{
+			return Contains(handle) ? &m_values[m_slots[handle.index].dense_index] : nullptr;
+		}
+
+		const T* Get(SSlotHandle handle) const
+		{
+			return Contains(handle) ? &m_values[m_slots[handle.index].dense_index] : nullptr;
+		}
+
+		// 按紧密数组的顺序遍历, dense_index 在删除后会变
+		SSlotHandle GetHandle(uint32_t dense_index) const
+		{
+			const uint32_t slot_index = m_dense_to_slot[dense_index];
+			return { slot_index, m_slots[slot_index].generation };
+		}
+
+		void Clear()
+		{
+			while (!m_values.empty())
+			{
+				Erase(GetHandle(static_cast<uint32_t>(m_values.size() - 1)));
+			}
+		}
+
+		uint32_t Size() const { return static_cast<uint32_t>(m_values.size()); }
+		bool Empty() const { return m_values.empty(); }
+
+		T& operator[](uint32_t dense_index) { return m_values[dense_index]; }
+		const T& operator[](uint32_t dense_index) const { return m_values[dense_index]; }
+		typename std::vector<T>::iterator begin() { return m_values.begin(); }
+		typename std::vector<T>::iterator end() { return m_values.end(); }
+		typename std::vector<T>::const_iterator begin() const { return m_values.begin(); }
+		typename std::vector<T>::const_iterator end() const { return m_values.end(); }
+
+	private:
+		struct SSlot
+		{
+			uint32_t dense_index;  // 空闲时是下一个空闲槽位
+			uint32_t generation;   // 从1开始, 每次删除加一
+		};
+
+		std::vector<T>        m_values;
+		std::vector<uint32_t> m_dense_to_slot;
+		std::vector<SSlot>    m_slots;
+		uint32_t              m_free_head{ UINT32_MAX };
+	};
+}
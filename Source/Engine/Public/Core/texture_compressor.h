@@ -0,0 +1,39 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace FireEngine
+{
+	class CJobSystem;
+
+	enum class ETextureFormat : uint8_t
+	{
+		RGBA8,
+		BC1,    // 不透明 RGB, 每块8字节
+		BC3,    // RGB + 独立的 alpha, 每块16字节
+		BC5,    // 两个独立通道, 用于法线贴图的 XY
+		BC7,    // 高质量 RGBA, 每块16字节, 只使用 mode 6
+	};
+
+	// BC1/BC3 的颜色: Fast 取包围盒端点不做迭代, Normal/High 用 stb_dxt 的一次/两次端点优化
+	// BC3 的 alpha 和 BC5: 所有档位都是包围盒端点加最优索引
+	// BC7: 档位决定主轴的幂迭代次数、端点优化次数和是否搜索 p 位
+	enum class ECompressionQuality : uint8_t
+	{
+		Fast,
+		Normal,
+		High,
+	};
+
+	bool IsBlockCompressed(ETextureFormat format);
+	// 一行像素(块压缩格式为一行块)的字节数
+	uint64_t GetTextureRowPitch(ETextureFormat format, uint32_t width);
+	// 像素行数, 块压缩格式为块行数
+	uint32_t GetTextureRowCount(ETextureFormat format, uint32_t height);
+	uint64_t GetTextureDataSize(ETextureFormat format, uint32_t width, uint32_t height);
+
+	// rgba 为 width * height 的 RGBA8, 输出按块行排列, 边缘不足4像素的块复制边缘像素补齐
+	// job_system 不为空时按块行分给工作线程
+	bool CompressTexture(const uint8_t* rgba, uint32_t width, uint32_t height, ETextureFormat format, ECompressionQuality quality,
+		std::vector<uint8_t>& out_data, CJobSystem* job_system);
+}
@@ -0,0 +1,13 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "index_type.h"
+
+namespace FireEngine
+{
+	// 把一个平面多边形三角化, positions 按 position_stride 个float的间隔存放每个角的xyz
+	// 输出的三角形保持多边形原来的绕序, 下标为 index_base + 角的序号
+	// 凸多边形直接扇形展开; 凹多边形用耳切法, 顶点多时用 z-order 哈希只检查三角形包围盒内的凹点
+	void TriangulatePolygon(const float* positions, uint32_t position_stride, uint32_t vertex_count, std::vector<IndexType>& out_indices, IndexType index_base = 0);
+}
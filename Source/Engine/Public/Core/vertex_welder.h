@@ -0,0 +1,13 @@
+﻿#pragma once
+#include <vector>
+
+#include "define.h"
+
+namespace FireEngine
+{
+	// 合并 position/normal/uv/color 完全相同的顶点并重写索引, 返回合并后的顶点数
+	uint32_t WeldVertices(std::vector<SVertexInstance>& vertices, std::vector<IndexType>& indices);
+
+	// 按子网格分别合并, 子网格内的索引仍然相对于各自的 vertex_offset, geometries 同步更新
+	uint32_t WeldVertices(std::vector<SVertexInstance>& vertices, std::vector<IndexType>& indices, std::vector<SGeometryDesc>& geometries);
+}
@@ -3,6 +3,7 @@
 
 #include "fbxsdk.h"
 #include "Classes/mesh.h"
+#include "Classes/skeletal_mesh.h"
 
 namespace FireEngine
 {
@@ -23,15 +24,18 @@ namespace FireEngine
 
 		bool LoadScene(const std::string& file_name);
 		void LoadStaticMesh(CMesh* out_mesh);
-		void ImportSkeletalMesh(CMesh* out_mesh);
+		// 骨骼/蒙皮权重(前4个, 量化)/绑定姿势, 以及所有动画栈的逐帧采样
+		void ImportSkeletalMesh(CSkeletalMesh* out_mesh);
 		void ReleaseScene();
 
 	private:
 		void Initialize();
+		void CollectMeshes(std::vector<FbxMesh*>& out_meshes) const;
+		// 顶点按控制点存放, 多边形三角化后追加到 out_mesh
+		void AppendMeshGeometry(FbxMesh* mesh, CMesh* out_mesh);
 
 		FbxManager* m_fbx_manager{ nullptr };
 		FbxScene* m_fbx_scene{ nullptr };
-		FbxGeometryConverter* m_geometry_converter{ nullptr };
 	};
 
 
@@ -0,0 +1,64 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Classes/mesh.h"
+#include "Core/mapped_file.h"
+
+namespace FireEngine
+{
+	// 节点的一个属性, 只记录它在文件里的位置, 数组用到时才解压
+	struct SFbxProperty
+	{
+		char           type{ 0 };
+		const uint8_t* data{ nullptr };
+		uint32_t       array_length{ 0 };
+		uint32_t       encoding{ 0 };
+		uint32_t       byte_length{ 0 };
+	};
+
+	// 节点记录, 子节点和属性都不预先解析
+	struct SFbxNode
+	{
+		std::string_view name;
+		uint64_t         property_count{ 0 };
+		const uint8_t*   properties{ nullptr };
+		const uint8_t*   children{ nullptr };
+		const uint8_t*   end{ nullptr };
+		const uint8_t*   parent_end{ nullptr };
+	};
+
+	// "Kaydara FBX Binary" 格式的流式读取, 不建立场景图, 跳过不关心的节点只需读一个记录头
+	class CFbxBinaryReader
+	{
+	public:
+		bool Open(const SByteView& data);
+		uint32_t GetVersion() const { return m_version; }
+
+		bool FirstNode(SFbxNode& out_node) const;
+		bool FirstChild(const SFbxNode& parent, SFbxNode& out_child) const;
+		bool NextSibling(SFbxNode& node) const;
+		bool FindChild(const SFbxNode& parent, std::string_view name, SFbxNode& out_child) const;
+
+		bool GetProperty(const SFbxNode& node, uint32_t property_index, SFbxProperty& out_property) const;
+		std::string_view GetString(const SFbxNode& node, uint32_t property_index) const;
+
+		// 数组属性按需解压(zlib)并转换为目标类型
+		bool ReadArray(const SFbxProperty& property, std::vector<double>& out_values) const;
+		bool ReadArray(const SFbxProperty& property, std::vector<int32_t>& out_values) const;
+
+	private:
+		bool ReadNode(const uint8_t* cursor, const uint8_t* parent_end, SFbxNode& out_node) const;
+
+		SByteView m_data;
+		uint32_t  m_version{ 0 };
+		uint32_t  m_offset_size{ 4 };
+	};
+
+	// 取出 Objects 下所有 Mesh 的 Vertices/PolygonVertexIndex 以及第一层法线/UV/颜色,
+	// 多边形三角化后合并到 out_mesh, 最后焊接重复顶点. 不处理节点变换
+	bool ReadFbxMesh(const SByteView& data, CMesh& out_mesh);
+	bool LoadFbxMesh(const std::string& file_name, CMesh* out_mesh);
+}
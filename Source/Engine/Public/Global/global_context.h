@@ -6,10 +6,12 @@
 namespace FireEngine
 {
 	class CFileSystem;
+	class CDerivedDataCache;
 	class CWindowSystem;
 	class CLevelManager;
 	class CRenderingSystem;
 	class CAssetSystem;
+	class CJobSystem;
 
 	class CGlobalSingletonContext
 	{
@@ -19,7 +21,9 @@ namespace FireEngine
 
 
 
+		std::shared_ptr<CJobSystem> m_job_system;
 		std::shared_ptr<CFileSystem> m_file_system;
+		std::shared_ptr<CDerivedDataCache> m_derived_data_cache;
 		std::shared_ptr<CAssetSystem> m_asset_system;
 		std::shared_ptr<CWindowSystem> m_window_system;
 		std::shared_ptr<CLevelManager> m_level_manager;
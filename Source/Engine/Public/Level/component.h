@@ -3,6 +3,7 @@
 namespace FireEngine {
 	class CComponent
 	{
+	public:
 		virtual ~CComponent() = default;
 	};
 }
\ No newline at end of file
@@ -1,10 +1,15 @@
 ﻿#pragma once
 #include <vector>
 
+#include "Core/slot_map.h"
+#include "actor.h"
+
 namespace FireEngine {
 
 	void LoadDefaultLevel();
 
+	using FActorHandle = SSlotHandle;
+
 	class CLevel
 	{
 	public:
@@ -13,8 +18,13 @@ namespace FireEngine {
 
 		void TickLevel(float dt);
 
+		// actor 紧密存放在关卡里, 外部只保存句柄, 销毁后旧句柄 GetActor 返回空
+		FActorHandle SpawnActor();
+		void DestroyActor(FActorHandle actor);
+		CActor* GetActor(FActorHandle actor) { return m_actors.Get(actor); }
+		uint32_t GetActorCount() const { return m_actors.Size(); }
 
 	private:
-		// std::vector<>
+		TSlotMap<CActor> m_actors;
 	};
 }
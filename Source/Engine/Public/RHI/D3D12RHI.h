@@ -13,7 +13,10 @@
 #include <tchar.h>
 
 #include "Classes/mesh.h"
+#include "Classes/texture.h"
 #include "Core/define.h"
+#include "Core/mapped_file.h"
+#include "Core/slot_map.h"
 
 using namespace Microsoft::WRL;
 
@@ -38,6 +41,7 @@ namespace FireEngine
 		~SGeometryResource() = default;
 		SGeometryResource(SGeometryResource&) = default;
 		SGeometryResource(SGeometryResource&&) = default;
+		SGeometryResource& operator=(SGeometryResource&&) = default;
 		
 		ComPtr<ID3D12Resource2> m_vertex_buffer;
 		ComPtr<ID3D12Resource2> m_index_buffer;
@@ -60,6 +64,25 @@ namespace FireEngine
 		uint32_t size_in_bytes;
 	};
 
+	// 排队到下一帧命令列表开头的 mip 拷贝: 先从上传堆写入新层级, 再从旧贴图拷贝保留的层级
+	struct SPendingTextureCopy
+	{
+		ComPtr<ID3D12Resource> src;
+		UINT src_first_mip{ 0 };
+		ComPtr<ID3D12Resource> dest;
+		UINT dest_first_mip{ 0 };
+		UINT mip_count{ 0 };
+		ComPtr<ID3D12Resource> upload;
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> upload_layouts;
+	};
+
+	// GPU 可能还在使用的资源, 围栏到达 fence_value 后才释放
+	struct SRetiredResource
+	{
+		UINT64 fence_value{ 0 };
+		ComPtr<ID3D12Resource> resource;
+	};
+
 	struct EventFence
 	{
 		ComPtr<ID3D12Fence1> m_fence;
@@ -73,6 +96,9 @@ namespace FireEngine
 	};
 
 
+	using FTextureHandle = SSlotHandle;
+	using FPrimitiveHandle = SSlotHandle;
+
 	class D3D12RHI
 	{
 	public:
@@ -90,7 +116,9 @@ namespace FireEngine
 		size_t CreateRayTracingRootSignature();
 
 		void CreatePipelineStateObject();
-		void CreateRayTracingPipelineStateObject(const std::vector<uint8_t>& shader_byte_code);
+		bool CreateRayTracingPipelineStateObject(const SByteView& shader_byte_code);
+		// 热重载: 在两帧之间调用, 等GPU空闲后重建管线和着色器表, 失败时继续使用旧管线
+		bool ReloadRayTracingPipeline(const SByteView& shader_byte_code);
 
 		void CreateRenderEndFence();
 		void InitializeSampler();
@@ -98,7 +126,19 @@ namespace FireEngine
 
 		void CreateShaderTable();
 
-		void CreateTexture(std::vector<uint8_t>& texture_data, uint32_t width, uint32_t height);
+		// 上传贴图的全部 mip 层级, 失败时返回无效句柄
+		FTextureHandle CreateTexture(const CTexture& texture);
+		// 子资源的行距与上传堆一致时(比如直接映射的 .fetex)每层只需要一次 memcpy
+		FTextureHandle CreateTexture(const STextureView& texture);
+		// 等 GPU 用完后释放贴图, 已经释放的句柄直接忽略
+		void ReleaseTexture(FTextureHandle texture);
+		// 显存里实际占用的字节数(含对齐), 用于驻留预算统计
+		uint64_t GetTextureMemorySize(FTextureHandle texture) const;
+		// 流式加载: 在现有最高层前面补上更精细的 mip, finer_mips 的下一层必须是现有的最高层
+		// 旧层级在GPU上拷贝到新贴图, 句柄立即指向新贴图; 拷贝记录在下一帧命令列表的开头, 不等待GPU
+		bool ExtendTextureMips(FTextureHandle texture, const STextureView& finer_mips);
+		// 丢掉最精细的 drop_count 层, 至少保留一层, 同样在下一帧的命令列表里拷贝
+		bool TrimTextureMips(FTextureHandle texture, uint32_t drop_count);
 
 
 		void WaitForFence() const;
@@ -108,8 +148,13 @@ namespace FireEngine
 
 		TCHAR* GetCurrentAdapterName();
 
-		void CreatePrimitives(const std::vector<SVertexInstance>& vertex_vector, const std::vector<IndexType>& vertex_indices);
-		void CreatePrimitives(const std::vector<CMesh*>& meshes);
+		// 加速结构和描述符堆使用紧密数组里的第0个图元
+		FPrimitiveHandle CreatePrimitives(const std::vector<SVertexInstance>& vertex_vector, const std::vector<IndexType>& vertex_indices);
+		FPrimitiveHandle CreatePrimitives(const std::vector<CMesh*>& meshes);
+		FPrimitiveHandle CreatePrimitives(const SMeshView& mesh);
+		// 等 GPU 用完后释放顶点/索引缓冲, 已经释放的句柄直接忽略
+		void ReleasePrimitives(FPrimitiveHandle primitive);
+		uint64_t GetPrimitivesMemorySize(FPrimitiveHandle primitive) const;
 		void CreateMaterials();
 		void CreateSceneConstantBuffer();
 		void UpdateSceneConstantBuffer(SSceneConstantBuffer* data, uint64_t size);
@@ -119,8 +164,29 @@ namespace FireEngine
 		void CreateTopLevelInstanceResource();
 		void CreateTopLevelAccelerationStructure();
 		void BuildDescHeap();
+		// 热重载: 替换图元后在两帧之间调用, 等GPU空闲后重建 BLAS/TLAS 和描述符堆
+		void RebuildAccelerationStructures();
 
 	private:
+		// 提交一个围栏并等待, 之后GPU不再引用任何已提交的资源
+		void FlushCommandQueue();
+
+		// 默认堆上的贴图, 初始状态为 COPY_DEST
+		ComPtr<ID3D12Resource> CreateTextureResource(DXGI_FORMAT format, UINT64 width, UINT height, UINT16 mip_count);
+		// 按 dest 前 texture.subresource_count 个子资源的布局把数据拷到新的上传堆
+		ComPtr<ID3D12Resource> CreateTextureUploadBuffer(ID3D12Resource* dest, const STextureView& texture, std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>& out_layouts);
+		void RecordTextureUpload(ID3D12Resource* upload, const std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>& layouts, ID3D12Resource* dest);
+		void CopyTextureMips(ID3D12Resource* src, UINT src_first_mip, ID3D12Resource* dest, UINT dest_first_mip, UINT mip_count);
+		// 拷贝完成后把 texture 从 COPY_DEST 转回 COMMON
+		void RecordTextureCopyEnd(ID3D12Resource* texture);
+		// 把 texture 转回 COMMON, 提交命令列表并等待完成
+		void FinishTextureCopy(ID3D12Resource* texture);
+		// 把排队的 mip 拷贝记录到本帧命令列表, 旧贴图和上传堆随本帧的围栏释放
+		void RecordPendingTextureCopies();
+		// 已经提交的命令可能还在引用 resource, 等下一个围栏值通过后再释放
+		void RetireResource(ComPtr<ID3D12Resource> resource);
+		void ReleaseRetiredResources();
+
 		/*constance value*/
 		D3D_FEATURE_LEVEL m_feature_level = D3D_FEATURE_LEVEL_12_1;
 		UINT m_rtv_descriptor_size{ 0u };
@@ -165,8 +231,11 @@ namespace FireEngine
 		ComPtr<ID3D12Resource> m_top_level_acceleration_structure;
 		ComPtr<ID3D12Resource> m_top_level_scratch_resource;
 		ComPtr<ID3D12Resource> m_top_level_instance_resource;
-		//textures
-		std::vector<ComPtr<ID3D12Resource>> m_textures;
+		//textures, 上传完成后只保留默认堆上的贴图
+		TSlotMap<ComPtr<ID3D12Resource>> m_textures;
+		std::vector<SPendingTextureCopy> m_pending_texture_copies;
+		// 按围栏值递增排列
+		std::vector<SRetiredResource> m_retired_resources;
 
 		//constant buffer
 		SConstantBuffer m_scene_constant_buffer;
@@ -185,7 +254,7 @@ namespace FireEngine
 		std::vector<ComPtr<ID3D12RootSignature>> m_root_signatures;
 
 		/*缓存本帧用到的资源*/
-		std::vector<SGeometryResource> m_render_primitives;
+		TSlotMap<SGeometryResource> m_render_primitives;
 		ComPtr<ID3D12Resource> m_materials;
 		std::vector<SMaterial> m_materials_cpu;
 
@@ -1,7 +1,14 @@
-#pragma once
+﻿#pragma once
 
 #include "memory"
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
 #include "Core/define.h"
+#include "Core/file_system.h"
+#include "Core/file_watcher.h"
+#include "Classes/cooked_mesh.h"
+#include "Render/texture_streamer.h"
 #include "Window/window_system.h"
 
 
@@ -12,15 +19,62 @@ namespace FireEngine
 	{
 	public:
 		CRenderingSystem(CWindowSystem* window_system);
-		~CRenderingSystem() = default;
+		~CRenderingSystem();
 
 		void TickRendering(float dt);
 
 		
 	private:
+		// 热重载的单位: 合并后的场景网格, 某张贴图, 光追着色器
+		enum class EReloadTarget : uint8_t
+		{
+			SceneMesh,
+			Texture,
+			Shader,
+		};
+
+		struct SReloadTarget
+		{
+			EReloadTarget type;
+			uint32_t      index;
+
+			bool operator==(const SReloadTarget& other) const { return type == other.type && index == other.index; }
+		};
+
+		// 工作线程重新烘焙的结果, cooked_path 为空表示失败, 网格已经映射好, 主线程只需上传
+		struct SReloadResult
+		{
+			SReloadTarget                target;
+			std::string                  cooked_path;
+			std::unique_ptr<CCookedMesh> mesh;
+		};
+
+		// 创建场景图元并随网格资源一起释放, 同时更新光源位置和场景包围球
+		void BindSceneMesh(SAssetHandle mesh_asset, const SMeshView& mesh_view);
+		// 每帧开始时调用, 此时上一帧已经结束: 收集变化的源文件, 替换重新烘焙好的资源, 再发起新的烘焙
+		void UpdateHotReload();
+		void StartReload(const SReloadTarget& target);
+		void ApplyReload(SReloadResult& result);
 
 		D3D12RHI* m_rhi;
+		SAssetHandle m_scene_mesh_asset;
+		SSlotHandle m_scene_primitives;  // D3D12RHI 的图元句柄, 没有烘焙结果时不属于任何资源
+		std::unique_ptr<CTextureStreamer> m_texture_streamer;
+		std::vector<FStreamingTextureHandle> m_streaming_textures;
+		// 场景包围球, 用来估计贴图在屏幕上的尺寸
+		DirectX::XMFLOAT3 m_scene_center{};
+		float m_scene_radius{ 0.0f };
 
 		SSceneConstantBuffer m_scene_constant_buffer;
+
+		// 监视 Resource 目录, 源文件路径哈希 -> 依赖它的热重载目标
+		std::unique_ptr<CFileWatcher> m_file_watcher;
+		std::unordered_map<FPathHash, std::vector<SReloadTarget>> m_reload_dependencies;
+		std::vector<SReloadTarget> m_dirty_targets;
+		std::vector<SReloadTarget> m_reloading_targets;
+		std::vector<SReloadResult> m_reload_results;
+		std::mutex m_reload_mutex;
+		std::condition_variable m_reload_condition;
+		uint32_t m_reloads_in_flight{ 0 };
 	};
 }
@@ -0,0 +1,128 @@
+﻿#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Classes/cooked_texture.h"
+#include "Core/residency_manager.h"
+#include "Core/slot_map.h"
+
+namespace FireEngine
+{
+	class CJobSystem;
+	class D3D12RHI;
+
+	// 最长边不超过这个尺寸的层级(mip tail)在添加贴图时一次上传, 之后一直常驻
+	constexpr uint32_t c_texture_stream_tail_size = 128;
+
+	using FStreamingTextureHandle = SSlotHandle;
+
+	// 烘焙好的 .fetex 只映射不读入, 启动时只上传 mip tail, 更精细的层级按请求的屏幕尺寸逐层流入
+	// 读取在工作线程上从映射拷贝, 只有拷到的页会换入, 上传在主线程的 Tick 中进行
+	// 每帧的读取量和上传量有预算, 超过池预算或 GpuTexture 驻留预算时先丢优先级最低的精细层级
+	// 除了读取任务, 所有函数只能在主线程调用
+	class CTextureStreamer
+	{
+	public:
+		CTextureStreamer(D3D12RHI* rhi, CResidencyManager* residency, CJobSystem* job_system = nullptr);
+		~CTextureStreamer();
+
+		CTextureStreamer(const CTextureStreamer&) = delete;
+		CTextureStreamer& operator=(const CTextureStreamer&) = delete;
+
+		// 映射 .fetex 并上传 mip tail, 失败时返回无效句柄
+		FStreamingTextureHandle AddTexture(const std::string& file_name);
+		// 正在读取的贴图等读取完成后在 Tick 中释放
+		void RemoveTexture(FStreamingTextureHandle handle);
+
+		// D3D12RHI 的贴图句柄, 流入或丢弃层级时保持不变
+		SSlotHandle GetRhiTexture(FStreamingTextureHandle handle) const;
+		// 当前常驻的最精细层级
+		uint32_t GetResidentMip(FStreamingTextureHandle handle) const;
+		uint32_t GetRequestedMip(FStreamingTextureHandle handle) const;
+
+		// 贴图的最长边本帧在屏幕上覆盖 screen_size 个像素, 同一帧多次请求取最大的
+		void RequestScreenSize(FStreamingTextureHandle handle, float screen_size);
+		// 物体在屏幕上的像素尺寸, fov_y 是弧度
+		static float ComputeScreenSize(float world_size, float distance, float fov_y, float viewport_height);
+
+		// 所有流式贴图的显存上限, 默认只受 GpuTexture 驻留预算限制
+		void SetPoolBudget(uint64_t budget) { m_pool_budget = budget; }
+		// 每帧发起读取和上传的字节数, 每帧至少处理一个请求, 超过预算的单层也能流入
+		void SetFrameBudgets(uint64_t io_budget, uint64_t upload_budget);
+		uint64_t GetResidentSize() const { return m_resident_size; }
+
+		// 每帧在请求之后调用: 上传读完的层级, 超出预算时丢弃精细层级, 再按优先级发起新的读取
+		void Tick();
+
+	private:
+		struct SStreamingTexture
+		{
+			std::unique_ptr<CCookedTexture> file;
+			SSlotHandle                     rhi_texture;
+			FResidencyHandle                residency;
+			uint32_t                        tail_mip{ 0 };
+			uint32_t                        resident_mip{ 0 };
+			uint32_t                        requested_mip{ 0 };
+			float                           screen_size{ 0.0f };
+			uint64_t                        last_request_frame{ 0 };
+			uint64_t                        gpu_size{ 0 };
+			uint64_t                        reserved_size{ 0 };  // 正在读取或等待上传的层级预留的字节数
+			bool                            reading{ false };
+			bool                            removed{ false };
+			bool                            failed{ false };  // 上传失败后停止流入, 保持已有层级
+		};
+
+		// [first_mip, last_mip) 在文件中连续存放, data 从 first_mip 的起点开始
+		struct SReadResult
+		{
+			FStreamingTextureHandle handle;
+			uint32_t                first_mip;
+			uint32_t                last_mip;
+			std::vector<uint8_t>    data;
+		};
+
+		// 按字典序比较, 本帧请求过的优先, 再比较层级比请求粗多少, 最后比较屏幕尺寸
+		struct SPriority
+		{
+			bool    requested;
+			int32_t deficit;
+			float   screen_size;
+
+			bool operator<(const SPriority& other) const;
+		};
+
+		SPriority GetLevelPriority(const SStreamingTexture& texture, uint32_t mip) const;
+		bool HasRoom(uint64_t size) const;
+		// 从优先级低于 for_texture 的贴图上丢弃精细层级, 直到放得下 size, for_texture 为空时任何贴图都可以丢
+		bool MakeRoom(uint64_t size, const SStreamingTexture* for_texture);
+		void UploadCompletedReads();
+		void IssueReads();
+		void IssueRead(FStreamingTextureHandle handle, SStreamingTexture& texture, uint32_t first_mip);
+		void UpdateResidentSize(SStreamingTexture& texture);
+		void ReleaseReservedSize(SStreamingTexture& texture);
+		void DestroyTexture(FStreamingTextureHandle handle);
+
+		D3D12RHI*                     m_rhi;
+		CResidencyManager*            m_residency;
+		CJobSystem*                   m_job_system;
+		TSlotMap<SStreamingTexture>   m_textures;
+		std::vector<SReadResult>      m_pending_uploads;
+		uint64_t                      m_pool_budget{ UINT64_MAX };
+		uint64_t                      m_io_budget{ 16ull << 20 };
+		uint64_t                      m_upload_budget{ 16ull << 20 };
+		uint64_t                      m_resident_size{ 0 };
+		// 已发起读取但还没上传的层级也计入预算, 否则同一帧的读取都看到同样的空余, 上传后超出预算
+		uint64_t                      m_reserved_size{ 0 };
+		uint64_t                      m_frame{ 1 };
+
+		// 工作线程把读完的数据放进 m_completed_reads
+		std::vector<SReadResult>      m_completed_reads;
+		std::mutex                    m_mutex;
+		std::condition_variable       m_read_condition;
+		uint32_t                      m_reads_in_flight{ 0 };
+	};
+}
@@ -0,0 +1,129 @@
+﻿#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Core/job_system.h"
+#include "Core/pak_file.h"
+
+using namespace FireEngine;
+
+namespace
+{
+	constexpr uint32_t c_file_count = 3000;
+	constexpr uint32_t c_repeat_count = 5;
+
+	// 每页取一个字节和最后一个字节, 保证映射的页面真的被换入, 又不让校验本身占满耗时
+	uint64_t Checksum(const SByteView& view)
+	{
+		uint64_t sum = view.size;
+		for (uint64_t i = 0; i < view.size; i += 4096)
+		{
+			sum = sum * 31 + view.data[i];
+		}
+		return view.size ? sum * 31 + view.data[view.size - 1] : sum;
+	}
+
+	// 几 KB 的小文件, 一半内容重复, 让压缩有东西可压
+	void WriteSourceFiles(const std::filesystem::path& directory, std::vector<std::string>& out_paths)
+	{
+		uint32_t seed = 12345;
+		for (uint32_t i = 0; i < c_file_count; ++i)
+		{
+			const std::string path = "dir" + std::to_string(i % 30) + "/file" + std::to_string(i) + ".bin";
+			const std::filesystem::path file_name = directory / path;
+			std::filesystem::create_directories(file_name.parent_path());
+			std::vector<char> data(1024 + (i * 7919) % 7168);
+			for (size_t j = 0; j < data.size(); ++j)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				data[j] = j < data.size() / 2 ? static_cast<char>(j % 64) : static_cast<char>(seed >> 24);
+			}
+			std::ofstream(file_name, std::ios::binary).write(data.data(), static_cast<std::streamsize>(data.size()));
+			out_paths.emplace_back(path);
+		}
+	}
+
+	template <typename FRead>
+	double BestMilliseconds(FRead read)
+	{
+		double best = 1e30;
+		for (uint32_t repeat = 0; repeat < c_repeat_count; ++repeat)
+		{
+			const auto begin = std::chrono::steady_clock::now();
+			read();
+			const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			best = elapsed < best ? elapsed : best;
+		}
+		return best;
+	}
+}
+
+// 比较从目录逐个映射小文件和从 pak 里查找读取的耗时, 文件都在页缓存里
+int main(int argc, char** argv)
+{
+	const std::filesystem::path root = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::temp_directory_path() / "fire_engine_pak_benchmark";
+	std::error_code error;
+	std::filesystem::remove_all(root, error);
+	const std::filesystem::path source_directory = root / "source";
+	std::vector<std::string> paths;
+	WriteSourceFiles(source_directory, paths);
+
+	uint64_t directory_sum = 0;
+	const double directory_ms = BestMilliseconds([&]() {
+		directory_sum = 0;
+		for (const std::string& path : paths)
+		{
+			SFileData file;
+			if (file.Open((source_directory / path).string()))
+			{
+				directory_sum += Checksum(file.view);
+			}
+		}
+	});
+	printf("directory: %u files %.2f ms\n", c_file_count, directory_ms);
+
+	CJobSystem job_system;
+	const char* compression_names[] = { "none", "zlib", "lz" };
+	bool        ok = true;
+	for (EPakCompression compression : { EPakCompression::None, EPakCompression::Zlib, EPakCompression::Lz })
+	{
+		const std::string pak_file_name = (root / (std::string(compression_names[static_cast<uint32_t>(compression)]) + ".pak")).string();
+		if (!WritePakFromDirectory(pak_file_name, source_directory.string(), compression, &job_system))
+		{
+			printf("[error]:write %s failed!\n", pak_file_name.c_str());
+			ok = false;
+			continue;
+		}
+		uint64_t pak_sum = 0;
+		const double pak_ms = BestMilliseconds([&]() {
+			// 计入挂载时间
+			pak_sum = 0;
+			CPakFile pak;
+			if (!pak.Open(pak_file_name))
+			{
+				return;
+			}
+			for (const std::string& path : paths)
+			{
+				const SPakEntry* entry = pak.Find(HashPath(path));
+				SFileData        file;
+				if (entry && pak.Read(*entry, file))
+				{
+					pak_sum += Checksum(file.view);
+				}
+			}
+		});
+		if (pak_sum != directory_sum)
+		{
+			printf("[error]:%s pak content differs from the directory!\n", compression_names[static_cast<uint32_t>(compression)]);
+			ok = false;
+		}
+		printf("pak %-4s: %u files %.2f ms (%.1fx), %llu bytes\n", compression_names[static_cast<uint32_t>(compression)], c_file_count, pak_ms, directory_ms / pak_ms,
+			static_cast<unsigned long long>(std::filesystem::file_size(pak_file_name, error)));
+	}
+	std::filesystem::remove_all(root, error);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+﻿#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "Core/job_system.h"
+#include "Core/png_decoder.h"
+
+using namespace FireEngine;
+
+namespace
+{
+	struct SPngTestStats
+	{
+		uint32_t compared{ 0 };
+		uint32_t skipped{ 0 };
+		uint32_t failed{ 0 };
+	};
+
+	// 单线程和多线程各解码一次, 都必须和 stb 逐字节一致; stb 拒绝的文件也必须拒绝
+	void ComparePng(const std::string& name, const std::vector<uint8_t>& bytes, CJobSystem& job_system, SPngTestStats& stats)
+	{
+		const SByteView data{ bytes.data(), bytes.size() };
+		SPngInfo        info;
+		if (!ReadPngInfo(data, info) || !IsPngDecodable(info))
+		{
+			++stats.skipped;
+			return;
+		}
+
+		int32_t  width = 0;
+		int32_t  height = 0;
+		int32_t  channels = 0;
+		stbi_uc* reference = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width, &height, &channels, STBI_rgb_alpha);
+		for (CJobSystem* jobs : { static_cast<CJobSystem*>(nullptr), &job_system })
+		{
+			const char*          mode = jobs ? "parallel" : "serial";
+			std::vector<uint8_t> pixels(static_cast<size_t>(info.width) * info.height * 4, 0xCD);
+			const bool           decoded = DecodePng(data, info, pixels.data(), jobs);
+			++stats.compared;
+			if (!reference)
+			{
+				if (decoded)
+				{
+					printf("[error]:%s (%s) rejected by stb but decoded\n", name.c_str(), mode);
+					++stats.failed;
+				}
+				continue;
+			}
+			if (!decoded)
+			{
+				printf("[error]:%s (%s) decoded by stb but rejected\n", name.c_str(), mode);
+				++stats.failed;
+			}
+			else if (static_cast<uint32_t>(width) != info.width || static_cast<uint32_t>(height) != info.height || channels != info.channels)
+			{
+				printf("[error]:%s (%s) header %ux%u/%u, stb %dx%d/%d\n", name.c_str(), mode, info.width, info.height, info.channels, width, height, channels);
+				++stats.failed;
+			}
+			else if (memcmp(pixels.data(), reference, pixels.size()) != 0)
+			{
+				printf("[error]:%s (%s) pixels differ from stb, bit depth %u, color type %u\n", name.c_str(), mode, info.bit_depth, info.color_type);
+				++stats.failed;
+			}
+		}
+		stbi_image_free(reference);
+	}
+
+	// 语料库的图都很小, 另外用 stb 编码几张大图覆盖按滤波行分段和按行块展开的并行路径
+	void CompareGeneratedPngs(CJobSystem& job_system, SPngTestStats& stats)
+	{
+		const int32_t width = 1021;
+		const int32_t height = 777;
+		for (int32_t channels = 1; channels <= 4; ++channels)
+		{
+			std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * channels);
+			uint32_t             seed = 0x9E3779B9u * static_cast<uint32_t>(channels);
+			for (int32_t y = 0; y < height; ++y)
+			{
+				for (int32_t x = 0; x < width; ++x)
+				{
+					for (int32_t c = 0; c < channels; ++c)
+					{
+						seed = seed * 1664525u + 1013904223u;
+						// 上半部分是渐变, 下半部分是噪声, 让编码器选出不同的滤波方式
+						const uint8_t value = y < height / 2 ? static_cast<uint8_t>(x + y * c) : static_cast<uint8_t>(seed >> 24);
+						pixels[(static_cast<size_t>(y) * width + x) * channels + c] = value;
+					}
+				}
+			}
+			int32_t  png_size = 0;
+			uint8_t* png = stbi_write_png_to_mem(pixels.data(), width * channels, width, height, channels, &png_size);
+			if (!png)
+			{
+				printf("[error]:failed to encode %d channel test image\n", channels);
+				++stats.failed;
+				continue;
+			}
+			ComparePng("generated_" + std::to_string(channels), std::vector<uint8_t>(png, png + png_size), job_system, stats);
+			STBIW_FREE(png);
+		}
+	}
+
+	// 只有签名和 IHDR 的文件头, 用来检查尺寸校验
+	std::vector<uint8_t> MakePngHeader(uint32_t width, uint32_t height, uint8_t bit_depth, uint8_t color_type)
+	{
+		std::vector<uint8_t> bytes = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n', 0, 0, 0, 13, 'I', 'H', 'D', 'R' };
+		for (uint32_t value : { width, height })
+		{
+			for (int32_t shift = 24; shift >= 0; shift -= 8)
+			{
+				bytes.push_back(static_cast<uint8_t>(value >> shift));
+			}
+		}
+		bytes.insert(bytes.end(), { bit_depth, color_type, 0, 0, 0 });
+		// CRC 不参与校验
+		bytes.insert(bytes.end(), { 0, 0, 0, 0 });
+		return bytes;
+	}
+
+	// 截断、为0或超大的 IHDR 都必须在 ReadPngInfo 里被拒绝, 不能让调用者按文件头分配内存
+	void CheckBadHeaders(SPngTestStats& stats)
+	{
+		struct SBadHeader
+		{
+			const char*          name;
+			std::vector<uint8_t> bytes;
+		};
+		std::vector<uint8_t> truncated = MakePngHeader(64, 64, 8, 6);
+		truncated.resize(24);
+		const SBadHeader bad_headers[] = {
+			{ "truncated", truncated },
+			{ "zero_width", MakePngHeader(0, 64, 8, 6) },
+			{ "width_2^31", MakePngHeader(0x80000000u, 1, 8, 6) },
+			{ "height_2^32-1", MakePngHeader(1, 0xFFFFFFFFu, 8, 2) },
+			{ "over_max_dimension", MakePngHeader((1u << 24) + 1, 1, 8, 0) },
+			{ "65535x65535", MakePngHeader(65535, 65535, 16, 6) },
+		};
+		for (const SBadHeader& header : bad_headers)
+		{
+			SPngInfo info;
+			++stats.compared;
+			if (ReadPngInfo({ header.bytes.data(), header.bytes.size() }, info))
+			{
+				printf("[error]:%s header accepted as %ux%u\n", header.name, info.width, info.height);
+				++stats.failed;
+			}
+		}
+
+		// 合法的文件头但没有图像数据, 走解码失败的路径
+		const std::vector<uint8_t> empty = MakePngHeader(64, 64, 8, 6);
+		SPngInfo                   info;
+		std::vector<uint8_t>       pixels(64 * 64 * 4);
+		++stats.compared;
+		if (!ReadPngInfo({ empty.data(), empty.size() }, info) || DecodePng({ empty.data(), empty.size() }, info, pixels.data(), nullptr))
+		{
+			printf("[error]:header without IDAT not handled\n");
+			++stats.failed;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	CJobSystem    job_system(4);
+	SPngTestStats stats;
+	CheckBadHeaders(stats);
+	CompareGeneratedPngs(job_system, stats);
+
+	// 参数是要扫描的目录, 例如 ThirdParty/stb/tests/pngsuite
+	for (int32_t arg = 1; arg < argc; ++arg)
+	{
+		std::error_code error;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(argv[arg], error))
+		{
+			if (!entry.is_regular_file() || entry.path().extension() != ".png")
+			{
+				continue;
+			}
+			std::ifstream        file(entry.path(), std::ios::binary);
+			std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			ComparePng(entry.path().string(), bytes, job_system, stats);
+		}
+		if (error)
+		{
+			printf("[error]:cannot read directory %s: %s\n", argv[arg], error.message().c_str());
+			++stats.failed;
+		}
+	}
+
+	printf("compared %u, skipped %u, failed %u\n", stats.compared, stats.skipped, stats.failed);
+	return stats.failed == 0 ? 0 : 1;
+}
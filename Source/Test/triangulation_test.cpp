@@ -0,0 +1,99 @@
+﻿#include "Core/triangulation.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace FireEngine;
+
+namespace
+{
+	struct SPoint
+	{
+		float x;
+		float y;
+	};
+
+	float Cross(const SPoint& a, const SPoint& b, const SPoint& c)
+	{
+		return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	}
+
+	// 三角形必须和多边形同绕序, 面积之和等于多边形面积, 且不能有退化三角形
+	bool CheckPolygon(const char* name, const std::vector<SPoint>& points)
+	{
+		std::vector<float> positions;
+		for (const SPoint& point : points)
+		{
+			positions.insert(positions.end(), { point.x, point.y, 0.0f });
+		}
+		std::vector<IndexType> indices;
+		TriangulatePolygon(positions.data(), 3, static_cast<uint32_t>(points.size()), indices);
+
+		float polygon_area = 0.0f;
+		for (size_t i = 0; i < points.size(); ++i)
+		{
+			const SPoint& a = points[i];
+			const SPoint& b = points[(i + 1) % points.size()];
+			polygon_area += a.x * b.y - b.x * a.y;
+		}
+
+		bool  ok = indices.size() % 3 == 0;
+		float triangle_area = 0.0f;
+		for (size_t i = 0; ok && i < indices.size(); i += 3)
+		{
+			if (indices[i] >= points.size() || indices[i + 1] >= points.size() || indices[i + 2] >= points.size())
+			{
+				ok = false;
+				break;
+			}
+			const float area = Cross(points[indices[i]], points[indices[i + 1]], points[indices[i + 2]]);
+			if (area <= 0.0f)
+			{
+				printf("[error]:%s triangle %zu (%u %u %u) area %f\n", name, i / 3, indices[i], indices[i + 1], indices[i + 2], area);
+				ok = false;
+			}
+			triangle_area += area;
+		}
+		if (ok && std::fabs(triangle_area - polygon_area) > 1e-4f * std::fabs(polygon_area))
+		{
+			printf("[error]:%s triangle area %f != polygon area %f\n", name, triangle_area, polygon_area);
+			ok = false;
+		}
+		printf("%s %s: %zu triangles\n", ok ? "[pass]" : "[fail]", name, indices.size() / 3);
+		return ok;
+	}
+}
+
+int main()
+{
+	bool ok = true;
+
+	// 凸多边形走扇形展开
+	ok &= CheckPolygon("convex", { { 0, 0 }, { 2, 0 }, { 3, 1 }, { 2, 2 }, { 0, 2 } });
+
+	// 凹多边形走耳切
+	ok &= CheckPolygon("concave", { { 0, 0 }, { 4, 0 }, { 4, 4 }, { 2, 1 }, { 0, 4 } });
+
+	// L 形, 带连续重复点和一条边上的多个共线点, 需要 FilterPoints 一次删掉全部
+	ok &= CheckPolygon("repeated_collinear", {
+		{ 0, 0 }, { 1, 0 }, { 1, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 }, { 4, 0 },
+		{ 4, 1 }, { 2, 1 }, { 1, 1 }, { 1, 1 },
+		{ 1, 2 }, { 1, 3 }, { 1, 4 }, { 0, 4 }, { 0, 3 }, { 0, 2 }, { 0, 1 } });
+
+	// 首尾重合的凹多边形
+	ok &= CheckPolygon("closed_loop", { { 0, 0 }, { 4, 0 }, { 4, 4 }, { 2, 2 }, { 2, 2 }, { 0, 4 }, { 0, 0 } });
+
+	// 超过 z-order 阈值的锯齿圆环, 每个角重复一次
+	std::vector<SPoint> zigzag;
+	for (uint32_t i = 0; i < 200; ++i)
+	{
+		const float angle = 6.28318530f * static_cast<float>(i) / 200.0f;
+		const float radius = (i % 2) ? 1.0f : 0.8f;
+		zigzag.push_back({ radius * std::cos(angle), radius * std::sin(angle) });
+		zigzag.push_back(zigzag.back());
+	}
+	ok &= CheckPolygon("zigzag_repeated", zigzag);
+
+	return ok ? 0 : 1;
+}